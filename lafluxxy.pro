@@ -13,8 +13,9 @@ TEMPLATE = app
 CONFIG += c++14
 
 gcc {
-  QMAKE_CXXFLAGS += -fopenmp -march=native -Wall -Wextra
-  QMAKE_LFLAGS += -fopenmp -march=native
+  # no -march=native: the stencil kernels select their instruction set at runtime
+  QMAKE_CXXFLAGS += -fopenmp -Wall -Wextra
+  QMAKE_LFLAGS += -fopenmp
   QMAKE_CXXFLAGS_RELEASE -= -O2
   QMAKE_CXXFLAGS_RELEASE *= -O3
 }
@@ -50,6 +51,20 @@ SOURCES += src/main.cpp\
            src/input_gray_scott.cpp \
            src/renderarea.cpp \
            src/two_dim_rd.cpp \
+           src/cpu_features.cpp \
+           src/file_replace.cpp \
+           src/stencil_kernels.cpp \
+           src/spectral.cpp \
+           src/runge_kutta.cpp \
+           src/adi.cpp \
+           src/multigrid.cpp \
+           src/super_time_stepping.cpp \
+           src/adaptive_mesh.cpp \
+           src/ensemble.cpp \
+           src/parameter_sweep.cpp \
+           src/distributed.cpp \
+           src/three_dim_rd.cpp \
+           src/batch.cpp \
            src/reaction_lotka_volterra.cpp \
            src/reaction_gray_scott.cpp \
            src/reaction_brusselator.cpp \
@@ -84,12 +99,28 @@ HEADERS  += src/mainwindow.h \
             src/input_gray_scott.h \
             src/renderarea.h \
             src/two_dim_rd.h \
+            src/kinetics.h \
+            src/cpu_features.h \
+            src/file_replace.h \
+            src/stencil_kernels.h \
+            src/spectral.h \
+            src/runge_kutta.h \
+            src/adi.h \
+            src/multigrid.h \
+            src/super_time_stepping.h \
+            src/adaptive_mesh.h \
+            src/ensemble.h \
+            src/parameter_sweep.h \
+            src/distributed.h \
+            src/three_dim_rd.h \
+            src/batch.h \
             src/reaction_gray_scott.h \
             src/reaction_lotka_volterra.h \
             src/reaction_brusselator.h \
             src/reaction_barkley.h \
             src/reaction_fitzhugh_nagumo.h \
             src/reaction_system.h \
+            src/philox.h \
             src/worker_thread.h \
             src/mazerenderer.h \
             src/mazeholder.h \
@@ -0,0 +1,605 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "adaptive_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <omp.h>
+
+/**
+ * @brief      Limit a slope to the smallest of its one-sided estimates
+ *
+ * @param[in]  l     Difference with the left neighbour
+ * @param[in]  r     Difference with the right neighbour
+ *
+ * @return     The limited slope; zero at an extremum
+ */
+static inline double minmod(double l, double r) {
+    if(l * r <= 0.0) {
+        return 0.0;
+    }
+    return std::abs(l) < std::abs(r) ? l : r;
+}
+
+/**
+ * @brief      Get the cells along a side of a block
+ *
+ * Cell j (1 ... n) along the side is found at j times the row length for
+ * the western and eastern sides and at j otherwise.
+ *
+ * @param      m      Cells of the block including the ghost cells
+ * @param[in]  n      Number of cells along both axes, without the ghost cells
+ * @param[in]  side   Side of the block
+ * @param[in]  ghost  Whether to get the ghost cells rather than the cells of the block
+ *
+ * @return     Pointer to cell zero along the side
+ */
+static inline double* edge(MatrixXXd& m, unsigned int n, unsigned int side, bool ghost) {
+    switch(side) {
+        case 0:     // north
+            return m.row(ghost ? 0 : 1).data();
+        case 1:     // south
+            return m.row(ghost ? n + 1 : n).data();
+        case 2:     // west
+            return m.data() + (ghost ? 0 : 1);
+        default:    // east
+            return m.data() + (ghost ? n + 1 : n);
+    }
+}
+
+/**
+ * @brief      Choose the block size for a grid
+ *
+ * @param[in]  _width     width of the uniform grid
+ * @param[in]  _height    height of the uniform grid
+ * @param[in]  preferred  Largest block size to consider
+ *
+ * @return     The block size; zero when there is none
+ */
+unsigned int AdaptiveMesh::choose_block_size(unsigned int _width, unsigned int _height, unsigned int preferred) {
+    for(unsigned int n = preferred & ~1u; n >= 4; n -= 2) {
+        if(_width % n == 0 && _height % n == 0) {
+            return n;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _width       width of the uniform grid
+ * @param[in]  _height      height of the uniform grid
+ * @param[in]  _dx          size of the cells of the uniform grid
+ * @param[in]  _pbc         Whether to employ periodic boundary conditions
+ * @param[in]  _block_size  Number of cells along a block; even, at least 4 and a divisor of width and height
+ * @param[in]  _threshold   Difference between neighbouring coarse cells above which a block is refined
+ * @param[in]  _interval    Number of time steps between two regrids
+ */
+AdaptiveMesh::AdaptiveMesh(unsigned int _width, unsigned int _height, double _dx, bool _pbc,
+                           unsigned int _block_size, double _threshold, unsigned int _interval) :
+    width(_width),
+    height(_height),
+    block_size(_block_size),
+    dx(_dx),
+    pbc(_pbc),
+    threshold(_threshold),
+    interval(std::max(_interval, 1u)),
+    stencil(&get_stencil_kernels()) {
+
+    if(this->block_size < 4 || this->block_size % 2 != 0 ||
+       this->width % this->block_size != 0 || this->height % this->block_size != 0) {
+        throw std::runtime_error("The block size of the adaptive mesh needs to be even, at least 4 and divide the width and height.");
+    }
+
+    this->nbx = this->width / this->block_size;
+    this->nby = this->height / this->block_size;
+}
+
+/**
+ * @brief      Set the state from the uniform grid and adapt the mesh to it
+ *
+ * @param[in]  a     Concentration of A
+ * @param[in]  b     Concentration of B
+ */
+void AdaptiveMesh::set_state(const MatrixXXd& a, const MatrixXXd& b) {
+    this->load_blocks(a, b);
+
+    for(unsigned int k=0; k<this->blocks.size(); k++) {
+        this->fill_ghosts(k);
+    }
+    this->regrid();
+
+    this->step = 0;
+}
+
+/**
+ * @brief      Set the state from the uniform grid on a given layout of blocks
+ *
+ * @param[in]  a        Concentration of A
+ * @param[in]  b        Concentration of B
+ * @param[in]  layout   Whether each block is refined, row by row
+ * @param[in]  _step    Number of time steps taken
+ */
+void AdaptiveMesh::set_state(const MatrixXXd& a, const MatrixXXd& b, const std::vector<char>& layout, unsigned long _step) {
+    if(layout.size() != (size_t)this->nbx * this->nby) {
+        throw std::runtime_error("The layout does not match the blocks of the adaptive mesh.");
+    }
+
+    // coarsening only averages the cells, so the ghost cells are not needed
+    this->load_blocks(a, b);
+    this->target = layout;
+    this->apply_targets();
+
+    this->step = _step;
+}
+
+/**
+ * @brief      Fill all blocks as refined blocks from the uniform grid
+ *
+ * @param[in]  a     Concentration of A
+ * @param[in]  b     Concentration of B
+ */
+void AdaptiveMesh::load_blocks(const MatrixXXd& a, const MatrixXXd& b) {
+    const unsigned int bs = this->block_size;
+
+    this->blocks.assign(this->nbx * this->nby, Block());
+    this->variation.assign(this->blocks.size(), 0.0);
+    this->target.assign(this->blocks.size(), 1);
+
+    for(unsigned int k=0; k<this->blocks.size(); k++) {
+        Block& blk = this->blocks[k];
+        const unsigned int i0 = (k / this->nbx) * bs;
+        const unsigned int j0 = (k % this->nbx) * bs;
+
+        blk.refined = true;
+        blk.n = bs;
+        blk.a = MatrixXXd::Zero(bs + 2, bs + 2);
+        blk.b = MatrixXXd::Zero(bs + 2, bs + 2);
+        blk.a_next = MatrixXXd::Zero(bs + 2, bs + 2);
+        blk.b_next = MatrixXXd::Zero(bs + 2, bs + 2);
+        blk.a.block(1, 1, bs, bs) = a.block(i0, j0, bs, bs);
+        blk.b.block(1, 1, bs, bs) = b.block(i0, j0, bs, bs);
+    }
+}
+
+/**
+ * @brief      Get the state resampled to the uniform grid
+ *
+ * The coarse blocks are interpolated in the same way as when they are
+ * refined, such that the resampled state has the same mass.
+ *
+ * @param      a     Concentration of A
+ * @param      b     Concentration of B
+ */
+void AdaptiveMesh::get_state(MatrixXXd& a, MatrixXXd& b) {
+    const unsigned int bs = this->block_size;
+
+    a.resize(this->height, this->width);
+    b.resize(this->height, this->width);
+
+    for(unsigned int k=0; k<this->blocks.size(); k++) {
+        this->fill_ghosts(k);
+    }
+
+    MatrixXXd fa = MatrixXXd::Zero(bs + 2, bs + 2);
+    MatrixXXd fb = MatrixXXd::Zero(bs + 2, bs + 2);
+    for(unsigned int k=0; k<this->blocks.size(); k++) {
+        const Block& blk = this->blocks[k];
+        const unsigned int i0 = (k / this->nbx) * bs;
+        const unsigned int j0 = (k % this->nbx) * bs;
+
+        if(blk.refined) {
+            a.block(i0, j0, bs, bs) = blk.a.block(1, 1, bs, bs);
+            b.block(i0, j0, bs, bs) = blk.b.block(1, 1, bs, bs);
+        } else {
+            interpolate(blk.a, fa, blk.n);
+            interpolate(blk.b, fb, blk.n);
+            a.block(i0, j0, bs, bs) = fa.block(1, 1, bs, bs);
+            b.block(i0, j0, bs, bs) = fb.block(1, 1, bs, bs);
+        }
+    }
+}
+
+/**
+ * @brief      Advance the concentrations by a number of time steps
+ *
+ * The threads are forked once. Per time step, the ghost cells of all
+ * blocks are filled before any block is updated, such that a block only
+ * reads its own cells during the update.
+ *
+ * @param[in]  nsteps  Number of time steps
+ * @param[in]  update  Update of a row of cells from their Laplacians
+ * @param[in]  ncores  Number of threads
+ */
+void AdaptiveMesh::advance(unsigned int nsteps, const RowUpdate& update, unsigned int ncores) {
+    const unsigned int nthreads = std::max(1u, ncores);
+    this->linebuf.resize(nthreads);
+    for(auto& lb : this->linebuf) {
+        if(lb.cols() != this->block_size + 2) {
+            lb = MatrixXXd::Zero(2, this->block_size + 2);
+        }
+    }
+
+    const int nblocks = this->blocks.size();
+
+    omp_set_num_threads(nthreads);
+    #pragma omp parallel
+    {
+        for(unsigned int s=0; s<nsteps; s++) {
+            #pragma omp for schedule(dynamic)
+            for(int k=0; k<nblocks; k++) {
+                this->fill_ghosts(k);
+            }
+
+            // the blocks that changed and their neighbours need new ghost cells
+            const unsigned long n = this->step + s;
+            if(n > 0 && n % this->interval == 0) {
+                this->regrid();
+
+                #pragma omp for schedule(dynamic)
+                for(int k=0; k<nblocks; k++) {
+                    this->fill_ghosts(k);
+                }
+            }
+
+            #pragma omp for schedule(dynamic)
+            for(int k=0; k<nblocks; k++) {
+                this->update_block(k, update);
+            }
+        }
+    }
+
+    this->step += nsteps;
+}
+
+/**
+ * @brief      Get the number of refined blocks
+ *
+ * @return     The number of refined blocks
+ */
+unsigned int AdaptiveMesh::get_num_refined_blocks() const {
+    return std::count_if(this->blocks.begin(), this->blocks.end(), [](const Block& blk) {
+        return blk.refined;
+    });
+}
+
+/**
+ * @brief      Get the layout of the blocks
+ *
+ * @return     Whether each block is refined, row by row
+ */
+std::vector<char> AdaptiveMesh::get_layout() const {
+    std::vector<char> layout(this->blocks.size());
+    for(unsigned int k=0; k<this->blocks.size(); k++) {
+        layout[k] = this->blocks[k].refined ? 1 : 0;
+    }
+    return layout;
+}
+
+/**
+ * @brief      Get the number of cells relative to the uniform grid
+ *
+ * @return     The fraction of cells
+ */
+double AdaptiveMesh::get_cell_fraction() const {
+    size_t ncells = 0;
+    for(const Block& blk : this->blocks) {
+        ncells += blk.n * blk.n;
+    }
+    return (double)ncells / ((double)this->width * this->height);
+}
+
+/**
+ * @brief      Get the block next to a block
+ *
+ * @param[in]  k     Block index
+ * @param[in]  side  Side of the block
+ *
+ * @return     The index of the neighbouring block, or -1 at a zero-flux edge of the domain
+ */
+int AdaptiveMesh::get_neighbour(unsigned int k, unsigned int side) const {
+    static const int di[4] = {-1, 1, 0, 0};
+    static const int dj[4] = {0, 0, -1, 1};
+
+    int i = (int)(k / this->nbx) + di[side];
+    int j = (int)(k % this->nbx) + dj[side];
+    const int ni = this->nby;
+    const int nj = this->nbx;
+
+    if(i < 0 || i >= ni || j < 0 || j >= nj) {
+        if(!this->pbc) {
+            return -1;
+        }
+        i = (i + ni) % ni;
+        j = (j + nj) % nj;
+    }
+
+    return i * nj + j;
+}
+
+/**
+ * @brief      Fill the ghost cells and face weights of a block from its neighbours
+ *
+ * A face between two cells of equal size has weight one. Between a refined
+ * cell and a coarse cell, the centres are 3/2 refined cells apart, which
+ * gives the refined side a weight of 2/3 against the coarse cell. The
+ * coarse side receives the flux over both refined faces, which amounts to
+ * a weight of 4/3 against the mean of both refined cells. At zero-flux
+ * edges the ghost cells mirror the cells of the block.
+ *
+ * @param[in]  k     Block index
+ */
+void AdaptiveMesh::fill_ghosts(unsigned int k) {
+    Block& blk = this->blocks[k];
+    const unsigned int n = blk.n;
+
+    for(unsigned int side=0; side<4; side++) {
+        const int nb = this->get_neighbour(k, side);
+
+        // cell j (1 ... n) along the side is found at j times the stride
+        const unsigned int stride = (side == NORTH || side == SOUTH) ? 1 : n + 2;
+        double* ga = edge(blk.a, n, side, true);
+        double* gb = edge(blk.b, n, side, true);
+
+        if(nb < 0) {
+            const double* ca = edge(blk.a, n, side, false);
+            const double* cb = edge(blk.b, n, side, false);
+            for(unsigned int j=1; j<=n; j++) {
+                ga[j * stride] = ca[j * stride];
+                gb[j * stride] = cb[j * stride];
+            }
+            blk.weight[side] = 1.0;
+            continue;
+        }
+
+        // the neighbour provides the cells along its opposite side
+        Block& other = this->blocks[nb];
+        const unsigned int opp = side ^ 1;
+        const unsigned int ostride = (side == NORTH || side == SOUTH) ? 1 : other.n + 2;
+        const double* ca = edge(other.a, other.n, opp, false);
+        const double* cb = edge(other.b, other.n, opp, false);
+
+        if(other.refined == blk.refined) {
+            for(unsigned int j=1; j<=n; j++) {
+                ga[j * stride] = ca[j * ostride];
+                gb[j * stride] = cb[j * ostride];
+            }
+            blk.weight[side] = 1.0;
+        } else if(blk.refined) {
+            for(unsigned int j=1; j<=n; j++) {
+                ga[j * stride] = ca[((j + 1) / 2) * ostride];
+                gb[j * stride] = cb[((j + 1) / 2) * ostride];
+            }
+            blk.weight[side] = 2.0 / 3.0;
+        } else {
+            for(unsigned int j=1; j<=n; j++) {
+                ga[j * stride] = 0.5 * (ca[(2*j-1) * ostride] + ca[2*j * ostride]);
+                gb[j * stride] = 0.5 * (cb[(2*j-1) * ostride] + cb[2*j * ostride]);
+            }
+            blk.weight[side] = 4.0 / 3.0;
+        }
+    }
+}
+
+/**
+ * @brief      Perform a single explicit time step on a block
+ *
+ * The Laplacian of every row is evaluated by the stencil kernels using the
+ * ghost cells, after which the faces towards the neighbouring blocks are
+ * corrected for their weight.
+ *
+ * @param[in]  k       Block index
+ * @param[in]  update  Update of a row of cells from their Laplacians
+ */
+void AdaptiveMesh::update_block(unsigned int k, const RowUpdate& update) {
+    Block& blk = this->blocks[k];
+    const unsigned int n = blk.n;
+    const double h = blk.refined ? this->dx : 2.0 * this->dx;
+    const double idx2 = 1.0 / (h * h);
+    const auto& w = blk.weight;
+
+    MatrixXXd& lb = this->linebuf[omp_get_thread_num()];
+    double* lap_a = lb.row(0).data();
+    double* lap_b = lb.row(1).data();
+
+    for(unsigned int i=1; i<=n; i++) {
+        this->stencil->interior(lap_a, blk.a.row(i-1).data(), blk.a.row(i).data(), blk.a.row(i+1).data(), n + 2, idx2);
+        this->stencil->interior(lap_b, blk.b.row(i-1).data(), blk.b.row(i).data(), blk.b.row(i+1).data(), n + 2, idx2);
+
+        // faces towards the neighbouring blocks
+        if(i == 1 && w[NORTH] != 1.0) {
+            for(unsigned int j=1; j<=n; j++) {
+                lap_a[j] += (w[NORTH] - 1.0) * (blk.a(0,j) - blk.a(1,j)) * idx2;
+                lap_b[j] += (w[NORTH] - 1.0) * (blk.b(0,j) - blk.b(1,j)) * idx2;
+            }
+        }
+        if(i == n && w[SOUTH] != 1.0) {
+            for(unsigned int j=1; j<=n; j++) {
+                lap_a[j] += (w[SOUTH] - 1.0) * (blk.a(n+1,j) - blk.a(n,j)) * idx2;
+                lap_b[j] += (w[SOUTH] - 1.0) * (blk.b(n+1,j) - blk.b(n,j)) * idx2;
+            }
+        }
+        lap_a[1] += (w[WEST] - 1.0) * (blk.a(i,0) - blk.a(i,1)) * idx2;
+        lap_b[1] += (w[WEST] - 1.0) * (blk.b(i,0) - blk.b(i,1)) * idx2;
+        lap_a[n] += (w[EAST] - 1.0) * (blk.a(i,n+1) - blk.a(i,n)) * idx2;
+        lap_b[n] += (w[EAST] - 1.0) * (blk.b(i,n+1) - blk.b(i,n)) * idx2;
+
+        update(blk.a_next.row(i).data() + 1, blk.b_next.row(i).data() + 1,
+               blk.a.row(i).data() + 1, blk.b.row(i).data() + 1,
+               lap_a + 1, lap_b + 1, n);
+    }
+
+    // the ghost cells of the new generation are filled before the next step
+    blk.a.swap(blk.a_next);
+    blk.b.swap(blk.b_next);
+}
+
+/**
+ * @brief      Refine and coarsen the blocks according to the threshold
+ *
+ * Must be called by all threads of the parallel region, after the ghost
+ * cells have been filled.
+ */
+void AdaptiveMesh::regrid() {
+    const int nblocks = this->blocks.size();
+
+    #pragma omp for schedule(dynamic)
+    for(int k=0; k<nblocks; k++) {
+        this->variation[k] = this->get_block_variation(k);
+    }
+
+    #pragma omp single
+    {
+        // blocks above the threshold and their eight neighbours are refined;
+        // refined blocks are only coarsened below half the threshold
+        for(int k=0; k<nblocks; k++) {
+            this->target[k] = this->blocks[k].refined && this->variation[k] >= 0.5 * this->threshold;
+        }
+        for(int k=0; k<nblocks; k++) {
+            if(this->variation[k] <= this->threshold) {
+                continue;
+            }
+            this->target[k] = 1;
+            for(unsigned int side=0; side<4; side++) {
+                const int nb = this->get_neighbour(k, side);
+                if(nb < 0) {
+                    continue;
+                }
+                this->target[nb] = 1;
+
+                // the diagonal neighbours via the neighbours above and below
+                if(side == NORTH || side == SOUTH) {
+                    for(unsigned int lr : {WEST, EAST}) {
+                        const int diag = this->get_neighbour(nb, lr);
+                        if(diag >= 0) {
+                            this->target[diag] = 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    this->apply_targets();
+}
+
+/**
+ * @brief      Refine and coarsen the blocks to their targets
+ *
+ * Must be called by all threads of the parallel region.
+ */
+void AdaptiveMesh::apply_targets() {
+    const int nblocks = this->blocks.size();
+
+    #pragma omp for schedule(dynamic)
+    for(int k=0; k<nblocks; k++) {
+        Block& blk = this->blocks[k];
+        const bool refine = this->target[k];
+        if(refine == blk.refined) {
+            continue;
+        }
+
+        const unsigned int n = refine ? 2 * blk.n : blk.n / 2;
+        MatrixXXd a = MatrixXXd::Zero(n + 2, n + 2);
+        MatrixXXd b = MatrixXXd::Zero(n + 2, n + 2);
+        if(refine) {
+            interpolate(blk.a, a, blk.n);
+            interpolate(blk.b, b, blk.n);
+        } else {
+            average(blk.a, a, n);
+            average(blk.b, b, n);
+        }
+
+        blk.refined = refine;
+        blk.n = n;
+        blk.a.swap(a);
+        blk.b.swap(b);
+        blk.a_next = MatrixXXd::Zero(n + 2, n + 2);
+        blk.b_next = MatrixXXd::Zero(n + 2, n + 2);
+    }
+}
+
+/**
+ * @brief      Get the largest difference between neighbouring cells of a block
+ *
+ * @param[in]  k     Block index
+ *
+ * @return     The difference, measured over the size of a coarse cell
+ */
+double AdaptiveMesh::get_block_variation(unsigned int k) const {
+    const Block& blk = this->blocks[k];
+    const unsigned int n = blk.n;
+
+    double var = 0.0;
+    for(const MatrixXXd* m : {&blk.a, &blk.b}) {
+        var = std::max(var, (m->block(1, 2, n, n-1) - m->block(1, 1, n, n-1)).cwiseAbs().maxCoeff());
+        var = std::max(var, (m->block(2, 1, n-1, n) - m->block(1, 1, n-1, n)).cwiseAbs().maxCoeff());
+    }
+
+    // refined cells are half as far apart as coarse cells
+    return blk.refined ? 2.0 * var : var;
+}
+
+/**
+ * @brief      Interpolate coarse cells onto cells of half their size
+ *
+ * The slopes are limited by minmod, such that no new extrema arise and the
+ * mean of the four fine cells equals the coarse cell.
+ *
+ * @param[in]  coarse  Coarse cells including ghost cells
+ * @param      fine    Fine cells including ghost cells, which are left untouched
+ * @param[in]  n       Number of coarse cells along both axes
+ */
+void AdaptiveMesh::interpolate(const MatrixXXd& coarse, MatrixXXd& fine, unsigned int n) {
+    for(unsigned int i=1; i<=n; i++) {
+        for(unsigned int j=1; j<=n; j++) {
+            const double c = coarse(i,j);
+            const double sx = 0.25 * minmod(coarse(i,j+1) - c, c - coarse(i,j-1));
+            const double sy = 0.25 * minmod(coarse(i+1,j) - c, c - coarse(i-1,j));
+
+            fine(2*i-1, 2*j-1) = c - sx - sy;
+            fine(2*i-1, 2*j) = c + sx - sy;
+            fine(2*i, 2*j-1) = c - sx + sy;
+            fine(2*i, 2*j) = c + sx + sy;
+        }
+    }
+}
+
+/**
+ * @brief      Average fine cells onto cells of twice their size
+ *
+ * @param[in]  fine    Fine cells including ghost cells
+ * @param      coarse  Coarse cells including ghost cells, which are left untouched
+ * @param[in]  n       Number of coarse cells along both axes
+ */
+void AdaptiveMesh::average(const MatrixXXd& fine, MatrixXXd& coarse, unsigned int n) {
+    for(unsigned int i=1; i<=n; i++) {
+        for(unsigned int j=1; j<=n; j++) {
+            coarse(i,j) = 0.25 * (fine(2*i-1, 2*j-1) + fine(2*i-1, 2*j) +
+                                  fine(2*i, 2*j-1) + fine(2*i, 2*j));
+        }
+    }
+}
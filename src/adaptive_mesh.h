@@ -0,0 +1,292 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <array>
+#include <functional>
+#include <vector>
+
+#include "matrices.h"
+#include "stencil_kernels.h"
+
+/**
+ * @brief      Function that updates a row of cells from their Laplacians
+ *
+ * The arguments are the output rows of A and B, the current rows of A and
+ * B, the Laplacians of both and the number of cells. The reaction terms and
+ * the diffusion coefficients are applied by the caller.
+ */
+typedef std::function<void(double* a_out, double* b_out, const double* a, const double* b,
+                           const double* lap_a, const double* lap_b, unsigned int n)> RowUpdate;
+
+/**
+ * @brief      Block-structured adaptive mesh for explicit Euler integration
+ *
+ * The domain is divided in square blocks of block_size x block_size cells
+ * of the uniform grid. Every block is either refined, holding the cells of
+ * the uniform grid, or coarse, holding cells that are twice as large. The
+ * blocks where a pattern evolves are refined, while the nearly uniform
+ * remainder of the domain is integrated on the coarse cells at a quarter of
+ * the cost.
+ *
+ * Every block keeps a layer of ghost cells around its cells, which is
+ * filled from the neighbouring blocks before each time step. Across a face
+ * between a coarse and a refined block, the flux is the difference between
+ * the cells on both sides divided by the distance between their centres.
+ * The coarse cell receives the fluxes of both refined cells along its face,
+ * such that the scheme conserves mass. The ghost cells then hold the coarse
+ * cell for a refined block and the mean of the two refined cells for a
+ * coarse block, with a face weight that accounts for the distance.
+ *
+ * Every interval time steps the blocks are refined where the largest
+ * difference between neighbouring cells, measured over the size of a
+ * coarse cell, exceeds the threshold, and coarsened where it is below half
+ * the threshold. The blocks next to a refined block stay refined, such
+ * that a moving front does not leave the refined region between two
+ * regrids. Refinement interpolates linearly with limited slopes and
+ * coarsening averages, both conserving mass.
+ */
+class AdaptiveMesh {
+private:
+    static constexpr unsigned int NORTH = 0;    //!< side towards the previous row of blocks
+    static constexpr unsigned int SOUTH = 1;    //!< side towards the next row of blocks
+    static constexpr unsigned int WEST = 2;     //!< side towards the previous column of blocks
+    static constexpr unsigned int EAST = 3;     //!< side towards the next column of blocks
+
+    /**
+     * @brief      Cells of a single block
+     */
+    struct Block {
+        bool refined = true;                    //!< whether the block holds the cells of the uniform grid
+        unsigned int n = 0;                     //!< number of cells along both axes, without the ghost cells
+        std::array<double, 4> weight;           //!< weight of the faces towards the neighbouring blocks
+        MatrixXXd a;                            //!< concentration of A including the ghost cells
+        MatrixXXd b;                            //!< concentration of B including the ghost cells
+        MatrixXXd a_next;                       //!< second generation of A
+        MatrixXXd b_next;                       //!< second generation of B
+    };
+
+    unsigned int width;         //!< width of the uniform grid
+    unsigned int height;        //!< height of the uniform grid
+    unsigned int block_size;    //!< number of cells of the uniform grid along a block
+    unsigned int nbx;           //!< number of blocks along a row
+    unsigned int nby;           //!< number of blocks along a column
+    double dx;                  //!< size of the cells of the uniform grid
+    bool pbc;                   //!< whether to employ periodic boundary conditions
+
+    double threshold;           //!< difference between neighbouring coarse cells above which a block is refined
+    unsigned int interval;      //!< number of time steps between two regrids
+    unsigned long step = 0;     //!< number of time steps taken
+
+    std::vector<Block> blocks;          //!< blocks, row by row
+    std::vector<double> variation;      //!< largest difference between neighbouring cells per block
+    std::vector<char> target;           //!< whether a block is to be refined upon a regrid
+    std::vector<MatrixXXd> linebuf;     //!< per-thread Laplacian rows
+    const StencilKernels* stencil;      //!< stencil kernels for the instruction set of this CPU
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _width       width of the uniform grid
+     * @param[in]  _height      height of the uniform grid
+     * @param[in]  _dx          size of the cells of the uniform grid
+     * @param[in]  _pbc         Whether to employ periodic boundary conditions
+     * @param[in]  _block_size  Number of cells along a block; even, at least 4 and a divisor of width and height
+     * @param[in]  _threshold   Difference between neighbouring coarse cells above which a block is refined
+     * @param[in]  _interval    Number of time steps between two regrids
+     */
+    AdaptiveMesh(unsigned int _width, unsigned int _height, double _dx, bool _pbc,
+                 unsigned int _block_size, double _threshold, unsigned int _interval);
+
+    /**
+     * @brief      Choose the block size for a grid
+     *
+     * @param[in]  _width     width of the uniform grid
+     * @param[in]  _height    height of the uniform grid
+     * @param[in]  preferred  Largest block size to consider
+     *
+     * @return     The largest even block size of at least 4 and at most preferred that
+     *             divides the width and height; zero when there is none
+     */
+    static unsigned int choose_block_size(unsigned int _width, unsigned int _height, unsigned int preferred = 32);
+
+    /**
+     * @brief      Set the state from the uniform grid and adapt the mesh to it
+     *
+     * @param[in]  a     Concentration of A
+     * @param[in]  b     Concentration of B
+     */
+    void set_state(const MatrixXXd& a, const MatrixXXd& b);
+
+    /**
+     * @brief      Set the state from the uniform grid on a given layout of blocks
+     *
+     * Used to resume a run, such that the blocks and the regrids continue
+     * as before. The coarse blocks are averaged from the uniform grid.
+     *
+     * @param[in]  a        Concentration of A
+     * @param[in]  b        Concentration of B
+     * @param[in]  layout   Whether each block is refined, row by row
+     * @param[in]  _step    Number of time steps taken
+     */
+    void set_state(const MatrixXXd& a, const MatrixXXd& b, const std::vector<char>& layout, unsigned long _step);
+
+    /**
+     * @brief      Get the state resampled to the uniform grid
+     *
+     * The coarse blocks are interpolated in the same way as when they are
+     * refined, such that the resampled state has the same mass.
+     *
+     * @param      a     Concentration of A
+     * @param      b     Concentration of B
+     */
+    void get_state(MatrixXXd& a, MatrixXXd& b);
+
+    /**
+     * @brief      Advance the concentrations by a number of time steps
+     *
+     * @param[in]  nsteps  Number of time steps
+     * @param[in]  update  Update of a row of cells from their Laplacians
+     * @param[in]  ncores  Number of threads
+     */
+    void advance(unsigned int nsteps, const RowUpdate& update, unsigned int ncores);
+
+    /**
+     * @brief      Get the number of refined blocks
+     *
+     * @return     The number of refined blocks
+     */
+    unsigned int get_num_refined_blocks() const;
+
+    /**
+     * @brief      Get the number of cells relative to the uniform grid
+     *
+     * @return     The fraction of cells
+     */
+    double get_cell_fraction() const;
+
+    /**
+     * @brief      Get the layout of the blocks
+     *
+     * @return     Whether each block is refined, row by row
+     */
+    std::vector<char> get_layout() const;
+
+    /**
+     * @brief      Get the number of cells of the uniform grid along a block
+     *
+     * @return     The block size
+     */
+    inline unsigned int get_block_size() const {
+        return this->block_size;
+    }
+
+    /**
+     * @brief      Get the number of time steps taken
+     *
+     * @return     The number of time steps
+     */
+    inline unsigned long get_step() const {
+        return this->step;
+    }
+
+private:
+    /**
+     * @brief      Fill all blocks as refined blocks from the uniform grid
+     *
+     * @param[in]  a     Concentration of A
+     * @param[in]  b     Concentration of B
+     */
+    void load_blocks(const MatrixXXd& a, const MatrixXXd& b);
+
+    /**
+     * @brief      Get the block next to a block
+     *
+     * @param[in]  k     Block index
+     * @param[in]  side  Side of the block
+     *
+     * @return     The index of the neighbouring block, or -1 at a zero-flux edge of the domain
+     */
+    int get_neighbour(unsigned int k, unsigned int side) const;
+
+    /**
+     * @brief      Fill the ghost cells and face weights of a block from its neighbours
+     *
+     * @param[in]  k     Block index
+     */
+    void fill_ghosts(unsigned int k);
+
+    /**
+     * @brief      Perform a single explicit time step on a block
+     *
+     * @param[in]  k       Block index
+     * @param[in]  update  Update of a row of cells from their Laplacians
+     */
+    void update_block(unsigned int k, const RowUpdate& update);
+
+    /**
+     * @brief      Refine and coarsen the blocks according to the threshold
+     *
+     * Must be called by all threads of the parallel region, after the
+     * ghost cells have been filled.
+     */
+    void regrid();
+
+    /**
+     * @brief      Refine and coarsen the blocks to their targets
+     *
+     * Must be called by all threads of the parallel region.
+     */
+    void apply_targets();
+
+    /**
+     * @brief      Get the largest difference between neighbouring cells of a block
+     *
+     * @param[in]  k     Block index
+     *
+     * @return     The difference, measured over the size of a coarse cell
+     */
+    double get_block_variation(unsigned int k) const;
+
+    /**
+     * @brief      Interpolate coarse cells onto cells of half their size
+     *
+     * The slopes are limited by minmod, such that no new extrema arise and
+     * the mean of the four fine cells equals the coarse cell.
+     *
+     * @param[in]  coarse  Coarse cells including ghost cells
+     * @param      fine    Fine cells including ghost cells, which are left untouched
+     * @param[in]  n       Number of coarse cells along both axes
+     */
+    static void interpolate(const MatrixXXd& coarse, MatrixXXd& fine, unsigned int n);
+
+    /**
+     * @brief      Average fine cells onto cells of twice their size
+     *
+     * @param[in]  fine    Fine cells including ghost cells
+     * @param      coarse  Coarse cells including ghost cells, which are left untouched
+     * @param[in]  n       Number of coarse cells along both axes
+     */
+    static void average(const MatrixXXd& fine, MatrixXXd& coarse, unsigned int n);
+};
@@ -0,0 +1,442 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "adi.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <omp.h>
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _width   width of the system
+ * @param[in]  _height  height of the system
+ * @param[in]  dx       size of the space interval
+ * @param[in]  _dt      size of the time interval
+ * @param[in]  Da       Diffusion coefficient of compound A
+ * @param[in]  Db       Diffusion coefficient of compound B
+ * @param[in]  pbc      Whether to employ periodic boundary conditions
+ * @param[in]  mask     Mask with walls set to one, or nullptr
+ */
+AdiIntegrator::AdiIntegrator(unsigned int _width, unsigned int _height,
+                             double dx, double _dt, double Da, double Db,
+                             bool pbc, const MatrixXXi* mask) :
+    width(_width),
+    height(_height),
+    dt(_dt) {
+
+    const double r[2] = {0.5 * Da * this->dt / (dx * dx),
+                         0.5 * Db * this->dt / (dx * dx)};
+
+    // walls already close the domain, hence masked lines are never periodic
+    const bool cyclic = pbc && mask == nullptr;
+
+    this->build_lines(this->lines_y, this->height, this->width, cyclic, mask, r);
+    if(mask != nullptr) {
+        const MatrixXXi maskt = mask->transpose();
+        this->build_lines(this->lines_x, this->width, this->height, cyclic, &maskt, r);
+    } else {
+        this->build_lines(this->lines_x, this->width, this->height, cyclic, nullptr, r);
+    }
+
+    this->ra = MatrixXXd::Zero(this->height, this->width);
+    this->rb = MatrixXXd::Zero(this->height, this->width);
+    for(unsigned int s=0; s<2; s++) {
+        this->rhs[s] = MatrixXXd::Zero(this->height, this->width);
+        this->ut[s] = MatrixXXd::Zero(this->width, this->height);
+        this->rt[s] = MatrixXXd::Zero(this->width, this->height);
+    }
+    this->fact.resize(std::max(this->width, this->height));
+}
+
+/**
+ * @brief      Advance the concentrations by a number of time steps
+ *
+ * @param      a         Concentration of A
+ * @param      b         Concentration of B
+ * @param[in]  nsteps    Number of time steps
+ * @param[in]  reaction  Function that evaluates the reaction terms
+ * @param[in]  ncores    Number of threads
+ */
+void AdiIntegrator::advance(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps,
+                            const ReactionTerms& reaction, unsigned int ncores) {
+    omp_set_num_threads(ncores);
+
+    MatrixXXd* u[2] = {&a, &b};
+    MatrixXXd* R[2] = {&this->ra, &this->rb};
+
+    for(unsigned int j=0; j<nsteps; j++) {
+        // first half step: implicit along the rows, explicit along the columns
+        reaction(a.data(), b.data(), this->ra.data(), this->rb.data());
+        for(unsigned int s=0; s<2; s++) {
+            this->explicit_half(this->lines_y, s, *u[s], *R[s], this->rhs[s]);
+            transpose(this->rhs[s], this->ut[s]);
+            this->solve(this->lines_x, s, this->ut[s]);
+        }
+
+        // second half step: implicit along the columns, explicit along the rows
+        reaction(this->ut[0].data(), this->ut[1].data(), this->rt[0].data(), this->rt[1].data());
+        for(unsigned int s=0; s<2; s++) {
+            this->explicit_half(this->lines_x, s, this->ut[s], this->rt[s], this->rt[s]);
+            transpose(this->rt[s], *u[s]);
+            this->solve(this->lines_y, s, *u[s]);
+        }
+    }
+}
+
+/**
+ * @brief      Set up the codes and factorize the systems along one axis
+ *
+ * Row i of a system reads -r P_i x_{i-1} + (1 + r (P_i + N_i)) x_i - r N_i x_{i+1},
+ * where P_i and N_i are one if the respective neighbour is coupled. Wall
+ * cells are identity rows. Periodic lines add the corner coefficients -r,
+ * which are removed from the tridiagonal part by shifting the first and
+ * last pivot and restored afterwards by a Sherman-Morrison correction.
+ *
+ * @param      ls      The line systems
+ * @param[in]  n       length of the lines
+ * @param[in]  nlines  number of lines
+ * @param[in]  cyclic  whether the lines are periodic
+ * @param[in]  mask    Mask with lines as columns, or nullptr
+ * @param[in]  r       half of D * dt / dx^2 for A and B
+ */
+void AdiIntegrator::build_lines(LineSystems& ls, unsigned int n, unsigned int nlines, bool cyclic,
+                                const MatrixXXi* mask, const double r[2]) {
+    if(cyclic && n < 3) {
+        throw std::runtime_error("Periodic implicit diffusion requires at least three cells along every axis.");
+    }
+
+    ls.n = n;
+    ls.nlines = nlines;
+    ls.cyclic = cyclic;
+    ls.per_cell = mask != nullptr;
+
+    const unsigned int ncols = ls.per_cell ? nlines : 1;
+    ls.codes.assign((size_t)n * ncols, 0);
+
+    if(ls.per_cell) {
+        for(unsigned int i=0; i<n; i++) {
+            for(unsigned int j=0; j<nlines; j++) {
+                if((*mask)(i,j) == 1) {
+                    continue;
+                }
+                uint8_t code = FLUID;
+                if(i > 0 && (*mask)(i-1,j) != 1) {
+                    code |= OPEN_PREV;
+                }
+                if(i+1 < n && (*mask)(i+1,j) != 1) {
+                    code |= OPEN_NEXT;
+                }
+                ls.codes[(size_t)i * nlines + j] = code;
+            }
+        }
+    } else {
+        for(unsigned int i=0; i<n; i++) {
+            uint8_t code = FLUID;
+            if(i > 0 || cyclic) {
+                code |= OPEN_PREV;
+            }
+            if(i+1 < n || cyclic) {
+                code |= OPEN_NEXT;
+            }
+            ls.codes[i] = code;
+        }
+    }
+
+    std::vector<double> diag(n), sub(n), sup(n);
+    for(unsigned int s=0; s<2; s++) {
+        ls.r[s] = r[s];
+        ls.inv[s].assign((size_t)n * ncols, 0.0);
+        ls.cp[s].assign((size_t)n * ncols, 0.0);
+
+        for(unsigned int c=0; c<ncols; c++) {
+            for(unsigned int i=0; i<n; i++) {
+                const uint8_t code = ls.codes[(size_t)i * ncols + c];
+                const double p = (code & OPEN_PREV) ? 1.0 : 0.0;
+                const double q = (code & OPEN_NEXT) ? 1.0 : 0.0;
+                diag[i] = 1.0 + r[s] * (p + q);
+                sub[i] = i > 0 ? -r[s] * p : 0.0;
+                sup[i] = i+1 < n ? -r[s] * q : 0.0;
+            }
+
+            double gamma = 0.0;
+            if(cyclic) {
+                gamma = -diag[0];
+                diag[0] -= gamma;
+                diag[n-1] -= r[s] * r[s] / gamma;
+            }
+
+            double* inv = &ls.inv[s][c];
+            double* cp = &ls.cp[s][c];
+            inv[0] = 1.0 / diag[0];
+            cp[0] = sup[0] * inv[0];
+            for(unsigned int i=1; i<n; i++) {
+                const size_t k = (size_t)i * ncols;
+                inv[k] = 1.0 / (diag[i] - sub[i] * cp[k - ncols]);
+                cp[k] = sup[i] * inv[k];
+            }
+
+            if(cyclic) {
+                // solve the shifted system for u = (gamma, 0, ..., 0, -r)
+                std::vector<double>& z = ls.z[s];
+                z.assign(n, 0.0);
+                z[0] = gamma;
+                z[n-1] = -r[s];
+                z[0] *= inv[0];
+                for(unsigned int i=1; i<n; i++) {
+                    z[i] = (z[i] - sub[i] * z[i-1]) * inv[i];
+                }
+                for(int i=(int)n-2; i>=0; i--) {
+                    z[i] -= cp[i] * z[i+1];
+                }
+                ls.bg[s] = -r[s] / gamma;
+                ls.zfact[s] = 1.0 + z[0] + ls.bg[s] * z[n-1];
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Calculate u + r * d2u + dt/2 * R along the lines
+ *
+ * @param[in]  ls    The line systems
+ * @param[in]  s     Species index
+ * @param[in]  u     Concentrations with lines as columns
+ * @param[in]  R     Reaction terms with lines as columns
+ * @param      out   Result; may be the same matrix as R
+ */
+void AdiIntegrator::explicit_half(const LineSystems& ls, unsigned int s,
+                                  const MatrixXXd& u, const MatrixXXd& R, MatrixXXd& out) const {
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<(int)ls.n; i++) {
+        if(ls.per_cell) {
+            this->explicit_row<true>(ls, s, i, u, R, out);
+        } else {
+            this->explicit_row<false>(ls, s, i, u, R, out);
+        }
+    }
+}
+
+/**
+ * @brief      Calculate u + r * d2u + dt/2 * R for a single position along the lines
+ *
+ * @param[in]  ls    The line systems
+ * @param[in]  s     Species index
+ * @param[in]  i     Position along the lines
+ * @param[in]  u     Concentrations with lines as columns
+ * @param[in]  R     Reaction terms with lines as columns
+ * @param      out   Result; may be the same matrix as R
+ *
+ * @tparam     PerCell  Whether the coefficients are stored per cell
+ */
+template<bool PerCell>
+void AdiIntegrator::explicit_row(const LineSystems& ls, unsigned int s, unsigned int i,
+                                 const MatrixXXd& u, const MatrixXXd& R, MatrixXXd& out) const {
+    const unsigned int n = ls.n;
+    const unsigned int nlines = ls.nlines;
+    const double r = ls.r[s];
+    const double half = 0.5 * this->dt;
+
+    // closed neighbours carry a zero weight, hence clamping is sufficient
+    const unsigned int iprev = i > 0 ? i-1 : (ls.cyclic ? n-1 : 0);
+    const unsigned int inext = i+1 < n ? i+1 : (ls.cyclic ? 0 : n-1);
+
+    const double* up = &u(iprev, 0);
+    const double* uc = &u(i, 0);
+    const double* un = &u(inext, 0);
+    const double* rc = &R(i, 0);
+    double* o = &out(i, 0);
+
+    if(PerCell) {
+        const uint8_t* codes = &ls.codes[(size_t)i * nlines];
+        #pragma omp simd
+        for(unsigned int j=0; j<nlines; j++) {
+            const double wp = (codes[j] & OPEN_PREV) ? r : 0.0;
+            const double wn = (codes[j] & OPEN_NEXT) ? r : 0.0;
+            const double f = (codes[j] & FLUID) ? half : 0.0;
+            o[j] = uc[j] + wp * (up[j] - uc[j]) + wn * (un[j] - uc[j]) + f * rc[j];
+        }
+    } else {
+        const uint8_t code = ls.codes[i];
+        const double wp = (code & OPEN_PREV) ? r : 0.0;
+        const double wn = (code & OPEN_NEXT) ? r : 0.0;
+        #pragma omp simd
+        for(unsigned int j=0; j<nlines; j++) {
+            o[j] = uc[j] + wp * (up[j] - uc[j]) + wn * (un[j] - uc[j]) + half * rc[j];
+        }
+    }
+}
+
+/**
+ * @brief      Solve (1 - r * d2) x = d along the lines in place
+ *
+ * Every thread eliminates a contiguous range of lines; the sweeps run
+ * along the lines and vectorize across them.
+ *
+ * @param[in]  ls    The line systems
+ * @param[in]  s     Species index
+ * @param      d     Right-hand side with lines as columns; receives the solution
+ */
+void AdiIntegrator::solve(const LineSystems& ls, unsigned int s, MatrixXXd& d) {
+    #pragma omp parallel
+    {
+        const unsigned int tid = omp_get_thread_num();
+        const unsigned int nthreads = omp_get_num_threads();
+
+        // round the ranges up to whole cache lines to avoid false sharing
+        const unsigned int chunk = ((ls.nlines + nthreads - 1) / nthreads + 7) & ~7u;
+        const unsigned int c0 = std::min(ls.nlines, tid * chunk);
+        const unsigned int c1 = std::min(ls.nlines, c0 + chunk);
+
+        if(c0 < c1) {
+            if(ls.per_cell) {
+                this->solve_lines<true>(ls, s, d, c0, c1);
+            } else {
+                this->solve_lines<false>(ls, s, d, c0, c1);
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Solve the tridiagonal systems of a range of lines in place
+ *
+ * @param[in]  ls    The line systems
+ * @param[in]  s     Species index
+ * @param      d     Right-hand side with lines as columns; receives the solution
+ * @param[in]  c0    First line
+ * @param[in]  c1    Last line (exclusive)
+ *
+ * @tparam     PerCell  Whether the coefficients are stored per cell
+ */
+template<bool PerCell>
+void AdiIntegrator::solve_lines(const LineSystems& ls, unsigned int s, MatrixXXd& d, unsigned int c0, unsigned int c1) {
+    const unsigned int n = ls.n;
+    const unsigned int nlines = ls.nlines;
+    const double r = ls.r[s];
+    const double* inv = ls.inv[s].data();
+    const double* cp = ls.cp[s].data();
+
+    // forward elimination
+    {
+        double* cur = &d(0, 0);
+        if(PerCell) {
+            #pragma omp simd
+            for(unsigned int j=c0; j<c1; j++) {
+                cur[j] *= inv[j];
+            }
+        } else {
+            const double iv = inv[0];
+            #pragma omp simd
+            for(unsigned int j=c0; j<c1; j++) {
+                cur[j] *= iv;
+            }
+        }
+    }
+    for(unsigned int i=1; i<n; i++) {
+        double* cur = &d(i, 0);
+        const double* prev = &d(i-1, 0);
+        if(PerCell) {
+            const uint8_t* codes = &ls.codes[(size_t)i * nlines];
+            const double* iv = &inv[(size_t)i * nlines];
+            #pragma omp simd
+            for(unsigned int j=c0; j<c1; j++) {
+                const double w = (codes[j] & OPEN_PREV) ? r : 0.0;
+                cur[j] = (cur[j] + w * prev[j]) * iv[j];
+            }
+        } else {
+            const double w = (ls.codes[i] & OPEN_PREV) ? r : 0.0;
+            const double iv = inv[i];
+            #pragma omp simd
+            for(unsigned int j=c0; j<c1; j++) {
+                cur[j] = (cur[j] + w * prev[j]) * iv;
+            }
+        }
+    }
+
+    // back substitution
+    for(int i=(int)n-2; i>=0; i--) {
+        double* cur = &d(i, 0);
+        const double* next = &d(i+1, 0);
+        if(PerCell) {
+            const double* c = &cp[(size_t)i * nlines];
+            #pragma omp simd
+            for(unsigned int j=c0; j<c1; j++) {
+                cur[j] -= c[j] * next[j];
+            }
+        } else {
+            const double c = cp[i];
+            #pragma omp simd
+            for(unsigned int j=c0; j<c1; j++) {
+                cur[j] -= c * next[j];
+            }
+        }
+    }
+
+    // Sherman-Morrison correction for the corner coefficients
+    if(ls.cyclic) {
+        const double* z = ls.z[s].data();
+        const double* first = &d(0, 0);
+        const double* last = &d(n-1, 0);
+        const double bg = ls.bg[s];
+        const double zfact = ls.zfact[s];
+        double* f = this->fact.data();
+        #pragma omp simd
+        for(unsigned int j=c0; j<c1; j++) {
+            f[j] = (first[j] + bg * last[j]) / zfact;
+        }
+        for(unsigned int i=0; i<n; i++) {
+            double* cur = &d(i, 0);
+            const double zi = z[i];
+            #pragma omp simd
+            for(unsigned int j=c0; j<c1; j++) {
+                cur[j] -= f[j] * zi;
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Transpose a matrix using cache-sized tiles
+ *
+ * @param[in]  in    The matrix
+ * @param      out   The transposed matrix
+ */
+void AdiIntegrator::transpose(const MatrixXXd& in, MatrixXXd& out) {
+    static constexpr int TILE = 32;
+    const int rows = in.rows();
+    const int cols = in.cols();
+
+    #pragma omp parallel for schedule(static)
+    for(int i0=0; i0<rows; i0+=TILE) {
+        const int i1 = std::min(rows, i0 + TILE);
+        for(int j0=0; j0<cols; j0+=TILE) {
+            const int j1 = std::min(cols, j0 + TILE);
+            for(int i=i0; i<i1; i++) {
+                for(int j=j0; j<j1; j++) {
+                    out(j,i) = in(i,j);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,193 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "matrices.h"
+#include "spectral.h"
+
+/**
+ * @brief      Implicit-explicit integrator with alternating-direction implicit diffusion
+ *
+ * Every time step consists of two Peaceman-Rachford half steps: the first
+ * treats diffusion along the rows implicitly and along the columns
+ * explicitly, the second vice versa. The reaction terms are explicit and
+ * are evaluated at the start of each half step, which makes the scheme
+ * first order in time overall. The diffusion part is unconditionally
+ * stable, such that dt is only limited by the kinetics.
+ *
+ * The implicit systems are tridiagonal per line and are solved for many
+ * lines at once: lines are stored as the columns of a matrix, such that the
+ * elimination runs over its rows and vectorizes across the lines. For the
+ * solves along the rows, the data is transposed first. Zero-flux lines use
+ * the Thomas algorithm and periodic lines are closed by a Sherman-Morrison
+ * correction. With a mask, every wall cell is an identity row and its
+ * neighbours have no coupling to it, such that the walls split the lines
+ * into independent zero-flux segments.
+ */
+class AdiIntegrator {
+private:
+    static constexpr uint8_t OPEN_PREV = 1 << 0;    //!< the previous cell along the line is coupled
+    static constexpr uint8_t OPEN_NEXT = 1 << 1;    //!< the next cell along the line is coupled
+    static constexpr uint8_t FLUID = 1 << 2;        //!< the cell is not a wall
+
+    /**
+     * @brief      Tridiagonal systems of all lines along one axis
+     *
+     * Without a mask, all lines are identical and the coefficients are
+     * stored per position along the line; with a mask they are stored per
+     * cell, in a matrix with one line per column.
+     */
+    struct LineSystems {
+        unsigned int n = 0;             //!< length of the lines
+        unsigned int nlines = 0;        //!< number of lines
+        bool cyclic = false;            //!< whether the lines are periodic
+        bool per_cell = false;          //!< whether the coefficients are stored per cell
+
+        std::vector<uint8_t> codes;     //!< coupling of every position (or cell) to its neighbours
+        double r[2];                    //!< half of D * dt / dx^2 for A and B
+        std::vector<double> inv[2];     //!< inverse pivots of the elimination for A and B
+        std::vector<double> cp[2];      //!< eliminated upper diagonal for A and B
+        std::vector<double> z[2];       //!< solution of the Sherman-Morrison correction for A and B
+        double zfact[2];                //!< denominator of the Sherman-Morrison correction for A and B
+        double bg[2];                   //!< ratio of the corner coefficient to the pivot shift for A and B
+    };
+
+    unsigned int width;     //!< width of the system
+    unsigned int height;    //!< height of the system
+    double dt;              //!< size of the time interval
+
+    LineSystems lines_x;    //!< systems along the rows, stored transposed
+    LineSystems lines_y;    //!< systems along the columns
+
+    MatrixXXd ra;           //!< reaction terms of A
+    MatrixXXd rb;           //!< reaction terms of B
+    MatrixXXd rhs[2];       //!< right-hand side of the first half step for A and B
+    MatrixXXd ut[2];        //!< transposed intermediate state of A and B
+    MatrixXXd rt[2];        //!< transposed reaction terms and right-hand side of the second half step for A and B
+    std::vector<double> fact;   //!< per-line factors of the Sherman-Morrison correction
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _width   width of the system
+     * @param[in]  _height  height of the system
+     * @param[in]  dx       size of the space interval
+     * @param[in]  _dt      size of the time interval
+     * @param[in]  Da       Diffusion coefficient of compound A
+     * @param[in]  Db       Diffusion coefficient of compound B
+     * @param[in]  pbc      Whether to employ periodic boundary conditions
+     * @param[in]  mask     Mask with walls set to one, or nullptr
+     */
+    AdiIntegrator(unsigned int _width, unsigned int _height,
+                  double dx, double _dt, double Da, double Db,
+                  bool pbc, const MatrixXXi* mask);
+
+    /**
+     * @brief      Advance the concentrations by a number of time steps
+     *
+     * @param      a         Concentration of A
+     * @param      b         Concentration of B
+     * @param[in]  nsteps    Number of time steps
+     * @param[in]  reaction  Function that evaluates the reaction terms
+     * @param[in]  ncores    Number of threads
+     */
+    void advance(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps,
+                 const ReactionTerms& reaction, unsigned int ncores);
+
+private:
+    /**
+     * @brief      Set up the codes and factorize the systems along one axis
+     *
+     * @param      ls      The line systems
+     * @param[in]  n       length of the lines
+     * @param[in]  nlines  number of lines
+     * @param[in]  cyclic  whether the lines are periodic
+     * @param[in]  mask    Mask with lines as columns, or nullptr
+     * @param[in]  r       half of D * dt / dx^2 for A and B
+     */
+    void build_lines(LineSystems& ls, unsigned int n, unsigned int nlines, bool cyclic,
+                     const MatrixXXi* mask, const double r[2]);
+
+    /**
+     * @brief      Calculate u + r * d2u + dt/2 * R along the lines
+     *
+     * @param[in]  ls    The line systems
+     * @param[in]  s     Species index
+     * @param[in]  u     Concentrations with lines as columns
+     * @param[in]  R     Reaction terms with lines as columns
+     * @param      out   Result; may be the same matrix as R
+     */
+    void explicit_half(const LineSystems& ls, unsigned int s,
+                       const MatrixXXd& u, const MatrixXXd& R, MatrixXXd& out) const;
+
+    /**
+     * @brief      Calculate u + r * d2u + dt/2 * R for a single position along the lines
+     *
+     * @param[in]  ls    The line systems
+     * @param[in]  s     Species index
+     * @param[in]  i     Position along the lines
+     * @param[in]  u     Concentrations with lines as columns
+     * @param[in]  R     Reaction terms with lines as columns
+     * @param      out   Result; may be the same matrix as R
+     *
+     * @tparam     PerCell  Whether the coefficients are stored per cell
+     */
+    template<bool PerCell>
+    void explicit_row(const LineSystems& ls, unsigned int s, unsigned int i,
+                      const MatrixXXd& u, const MatrixXXd& R, MatrixXXd& out) const;
+
+    /**
+     * @brief      Solve (1 - r * d2) x = d along the lines in place
+     *
+     * @param[in]  ls    The line systems
+     * @param[in]  s     Species index
+     * @param      d     Right-hand side with lines as columns; receives the solution
+     */
+    void solve(const LineSystems& ls, unsigned int s, MatrixXXd& d);
+
+    /**
+     * @brief      Solve the tridiagonal systems of a range of lines in place
+     *
+     * @param[in]  ls    The line systems
+     * @param[in]  s     Species index
+     * @param      d     Right-hand side with lines as columns; receives the solution
+     * @param[in]  c0    First line
+     * @param[in]  c1    Last line (exclusive)
+     *
+     * @tparam     PerCell  Whether the coefficients are stored per cell
+     */
+    template<bool PerCell>
+    void solve_lines(const LineSystems& ls, unsigned int s, MatrixXXd& d, unsigned int c0, unsigned int c1);
+
+    /**
+     * @brief      Transpose a matrix using cache-sized tiles
+     *
+     * @param[in]  in    The matrix
+     * @param      out   The transposed matrix
+     */
+    static void transpose(const MatrixXXd& in, MatrixXXd& out);
+};
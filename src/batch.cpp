@@ -0,0 +1,387 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include "distributed.h"
+#include "ensemble.h"
+#include "parameter_sweep.h"
+#include "three_dim_rd.h"
+#include "reaction_lotka_volterra.h"
+#include "reaction_gray_scott.h"
+#include "reaction_fitzhugh_nagumo.h"
+#include "reaction_brusselator.h"
+#include "reaction_barkley.h"
+
+/**
+ * @brief      Parse the kinetic system and numerical settings of a command line run
+ *
+ * @param[in]  kinetics  Name of the kinetic system, e.g. "gray-scott"
+ * @param[in]  settings  Numerical settings
+ *
+ * @return     The settings
+ */
+BatchSettings parse_batch_settings(const std::string& kinetics, const std::string& settings) {
+    BatchSettings bs;
+
+    if(kinetics == "lotka-volterra") {
+        bs.reacttype = KINETICS::LOTKA_VOLTERRA;
+    } else if(kinetics == "gray-scott") {
+        bs.reacttype = KINETICS::GRAY_SCOTT;
+    } else if(kinetics == "fitzhugh-nagumo") {
+        bs.reacttype = KINETICS::FITZHUGH_NAGUMO;
+    } else if(kinetics == "brusselator") {
+        bs.reacttype = KINETICS::BRUSSELATOR;
+    } else if(kinetics == "barkley") {
+        bs.reacttype = KINETICS::BARKLEY;
+    } else {
+        throw std::runtime_error("Invalid kinetic system encountered: " + kinetics +
+                                 "; use lotka-volterra, gray-scott, fitzhugh-nagumo, brusselator or barkley.");
+    }
+
+    const auto map = make_reaction_system(bs.reacttype)->parse_parameters(settings);
+    const auto get = [&](const std::string& name) {
+        const auto got = map.find(name);
+        if(got == map.end()) {
+            throw std::runtime_error("Cannot find setting " + name);
+        }
+        return got->second;
+    };
+
+    bs.Da = get("dX");
+    bs.Db = get("dY");
+    bs.dx = get("dx");
+    bs.dt = get("dt");
+    bs.width = (unsigned int)get("width");
+    bs.height = (unsigned int)get("height");
+    bs.steps = (unsigned int)get("steps");
+    bs.tsteps = (unsigned int)get("tsteps");
+    bs.pbc = get("pbc") != 0.0;
+
+    return bs;
+}
+
+/**
+ * @brief      Create a reaction system of a kinetic system
+ *
+ * @param[in]  reacttype  The kinetic system
+ *
+ * @return     The reaction system
+ */
+std::unique_ptr<ReactionSystem> make_reaction_system(KINETICS reacttype) {
+    switch(reacttype) {
+        case KINETICS::LOTKA_VOLTERRA:
+            return std::make_unique<ReactionLotkaVolterra>();
+        case KINETICS::GRAY_SCOTT:
+            return std::make_unique<ReactionGrayScott>();
+        case KINETICS::FITZHUGH_NAGUMO:
+            return std::make_unique<ReactionFitzhughNagumo>();
+        case KINETICS::BRUSSELATOR:
+            return std::make_unique<ReactionBrusselator>();
+        case KINETICS::BARKLEY:
+            return std::make_unique<ReactionBarkley>();
+        default:
+            throw std::logic_error("Invalid reaction system encountered.");
+    }
+}
+
+/**
+ * @brief      Create a two-dimensional system from the settings of a command line run
+ *
+ * @param[in]  settings  The settings
+ *
+ * @return     The system
+ */
+std::unique_ptr<TwoDimRD> make_two_dim_rd(const BatchSettings& settings) {
+    auto system = std::make_unique<TwoDimRD>(settings.Da, settings.Db, settings.width, settings.height,
+                                             settings.dx, settings.dt, settings.steps, settings.tsteps);
+    system->set_reaction(make_reaction_system(settings.reacttype).release());
+    system->set_pbc(settings.pbc);
+
+    return system;
+}
+
+/**
+ * @brief      Integrate an ensemble of simulations without a GUI
+ *
+ * The final state of every member is summarized. As a check of the batched
+ * integration, the first member is integrated once more as a single
+ * simulation, which has to give the same result.
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+int ensemble_main(int argc, char *argv[]) {
+    try {
+        if(argc < 5) {
+            throw std::runtime_error("Usage: lafluxxy --ensemble <kinetics> <settings> <params> [<params> ...]");
+        }
+
+        const BatchSettings settings = parse_batch_settings(argv[2], argv[3]);
+        const unsigned int ncores = std::max(1u, std::thread::hardware_concurrency());
+
+        EnsembleIntegrator ensemble(settings.width, settings.height, settings.dx, settings.dt,
+                                    settings.Da, settings.Db, settings.pbc, settings.reacttype);
+        for(int i=4; i<argc; i++) {
+            ensemble.add_member(argv[i]);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ensemble.init();
+        for(unsigned int i=0; i<settings.steps; i++) {
+            ensemble.update(settings.tsteps, ncores);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "Integrated " << ensemble.get_num_members() << " members in "
+                  << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+        for(unsigned int m=0; m<ensemble.get_num_members(); m++) {
+            const MatrixXXd& a = ensemble.get_concentrations(m, true).back();
+            std::cout << argv[4 + m] << ": A in [" << a.minCoeff() << ", " << a.maxCoeff()
+                      << "], mean " << a.mean() << std::endl;
+        }
+
+        auto system = make_two_dim_rd(settings);
+        system->set_cores(ncores);
+        system->set_parameters(argv[4]);
+        system->time_integrate();
+
+        const double deviation = std::max(
+            (system->get_concentrations(true).back() - ensemble.get_concentrations(0, true).back()).cwiseAbs().maxCoeff(),
+            (system->get_concentrations(false).back() - ensemble.get_concentrations(0, false).back()).cwiseAbs().maxCoeff());
+        std::cout << "Deviation of the first member from a single simulation: " << deviation << std::endl;
+        if(deviation > 1e-8) {
+            std::cerr << "The ensemble does not reproduce the single simulation." << std::endl;
+            return 1;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief      Perform or resume a parameter sweep without a GUI
+ *
+ * A range "name=start:stop:n" sweeps a kinetic parameter, or a diffusion
+ * coefficient for the names Da and Db. When all runs are done, their
+ * summaries are listed.
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+int sweep_main(int argc, char *argv[]) {
+    try {
+        if(argc < 7) {
+            throw std::runtime_error("Usage: lafluxxy --sweep <kinetics> <settings> <params> <outdir> "
+                                     "<name>=<start>:<stop>:<n> [...] [--resume] [--cores-per-run <n>]");
+        }
+
+        const BatchSettings settings = parse_batch_settings(argv[2], argv[3]);
+        const RunFactory factory = [settings](double Da, double Db) {
+            BatchSettings run_settings = settings;
+            run_settings.Da = Da;
+            run_settings.Db = Db;
+            return make_two_dim_rd(run_settings);
+        };
+        ParameterSweep sweep(factory, argv[4], settings.Da, settings.Db, argv[5]);
+
+        bool resume = false;
+        unsigned int cores_per_run = 1;
+        for(int i=6; i<argc; i++) {
+            const std::string arg = argv[i];
+            if(arg == "--resume") {
+                resume = true;
+            } else if(arg == "--cores-per-run" && i + 1 < argc) {
+                cores_per_run = std::stoul(argv[++i]);
+            } else {
+                const size_t eq = arg.find('=');
+                const size_t c1 = arg.find(':', eq);
+                const size_t c2 = arg.find(':', c1 + 1);
+                if(eq == std::string::npos || c1 == std::string::npos || c2 == std::string::npos) {
+                    throw std::runtime_error("Invalid range encountered: " + arg);
+                }
+
+                SweepRange range;
+                range.name = arg.substr(0, eq);
+                range.start = std::stod(arg.substr(eq + 1, c1 - eq - 1));
+                range.stop = std::stod(arg.substr(c1 + 1, c2 - c1 - 1));
+                range.n = std::stoul(arg.substr(c2 + 1));
+                sweep.add_range(range);
+            }
+        }
+
+        const unsigned int ncores = std::max(1u, std::thread::hardware_concurrency());
+        std::cout << "Sweeping " << sweep.get_num_runs() << " runs over " << ncores << " cores, "
+                  << cores_per_run << " per run" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        sweep.run(ncores, cores_per_run, resume);
+        auto end = std::chrono::steady_clock::now();
+
+        for(size_t idx=0; idx<sweep.get_num_runs(); idx++) {
+            const RunSummary summary = ParameterSweep::read_summary(sweep.get_summary_filename(idx));
+            std::cout << summary.params << " Da=" << summary.Da << " Db=" << summary.Db
+                      << ": " << summary.frames << " frames in " << summary.elapsed << " s, mean A "
+                      << summary.stats_a[2] << ", std A " << summary.stats_a[3] << std::endl;
+        }
+        std::cout << "Completed in " << std::chrono::duration<double>(end - start).count()
+                  << " s; the summaries are in " << argv[5] << std::endl;
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief      Perform a distributed integration and measure its strong scaling
+ *
+ * The threads of the machine are divided over the processes. After the
+ * integration of all frames, the time spent on the updates and the halo
+ * exchanges is listed per rank, followed by the strong scaling of a
+ * single frame on 1, 2, 4, ... processes.
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+int distributed_main(int argc, char *argv[]) {
+    try {
+        if(argc < 6) {
+            throw std::runtime_error("Usage: lafluxxy --distributed <kinetics> <settings> <params> <nprocs>");
+        }
+
+        const BatchSettings settings = parse_batch_settings(argv[2], argv[3]);
+        const unsigned int nprocs = std::max(1ul, std::stoul(argv[5]));
+        const unsigned int ncores = std::max(1u, std::thread::hardware_concurrency() / nprocs);
+
+        DistributedRD system(settings.Da, settings.Db, settings.width, settings.height,
+                             settings.dx, settings.dt, settings.steps, settings.tsteps, nprocs);
+        system.set_reaction(make_reaction_system(settings.reacttype).release());
+        system.set_pbc(settings.pbc);
+        system.set_cores(ncores);
+        system.set_parameters(argv[4]);
+
+        system.time_integrate();
+        const DistributedTimings& timings = system.get_timings();
+        std::cout << "Integrated " << settings.steps << " frames on " << nprocs << " processes of "
+                  << ncores << " threads in " << timings.wall << " s" << std::endl;
+        for(unsigned int r=0; r<timings.nprocs; r++) {
+            std::cout << "  rank " << r << ": update " << timings.compute[r]
+                      << " s, halo exchange " << timings.halo[r] << " s" << std::endl;
+        }
+
+        std::cout << "Strong scaling of " << settings.tsteps << " time steps:" << std::endl;
+        for(const ScalingPoint& point : system.measure_strong_scaling(settings.tsteps)) {
+            std::cout << "  " << point.nprocs << " processes: " << point.wall << " s, speedup "
+                      << point.speedup << ", efficiency " << point.efficiency << std::endl;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief      Integrate a three-dimensional system without a GUI
+ *
+ * The middle slice of every frame is summarized. As a check of the
+ * seven-point stencil, a system of a single slice is integrated as well,
+ * which has to reproduce the two-dimensional integration.
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+int three_dim_main(int argc, char *argv[]) {
+    try {
+        if(argc < 6) {
+            throw std::runtime_error("Usage: lafluxxy --three-dim <kinetics> <settings> <params> <depth>");
+        }
+
+        const BatchSettings settings = parse_batch_settings(argv[2], argv[3]);
+        const unsigned int depth = std::max(1ul, std::stoul(argv[5]));
+        const unsigned int ncores = std::max(1u, std::thread::hardware_concurrency());
+
+        const auto make_system = [&](unsigned int d) {
+            auto system = std::make_unique<ThreeDimRD>(settings.Da, settings.Db, settings.width, settings.height, d,
+                                                       settings.dx, settings.dt, settings.steps, settings.tsteps);
+            system->set_reaction(make_reaction_system(settings.reacttype).release());
+            system->set_pbc(settings.pbc);
+            system->set_cores(ncores);
+            system->set_parameters(argv[4]);
+            return system;
+        };
+
+        auto system = make_system(depth);
+        auto start = std::chrono::steady_clock::now();
+        system->time_integrate();
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout << "Integrated " << settings.width << " x " << settings.height << " x " << depth
+                  << " cells in " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+        const auto& slices = system->get_concentrations(true);
+        for(unsigned int i=0; i<slices.size(); i++) {
+            std::cout << "  frame " << i << ": A of the middle slice in [" << slices[i].minCoeff() << ", "
+                      << slices[i].maxCoeff() << "], mean " << slices[i].mean() << std::endl;
+        }
+
+        auto single = make_system(1);
+        single->time_integrate();
+        auto planar = make_two_dim_rd(settings);
+        planar->set_cores(ncores);
+        planar->set_parameters(argv[4]);
+        planar->time_integrate();
+
+        const double deviation = std::max(
+            (single->get_state(true) - planar->get_concentrations(true).back()).cwiseAbs().maxCoeff(),
+            (single->get_state(false) - planar->get_concentrations(false).back()).cwiseAbs().maxCoeff());
+        std::cout << "Deviation of a single slice from a two-dimensional simulation: " << deviation << std::endl;
+        if(deviation > 1e-8) {
+            std::cerr << "A single slice does not reproduce the two-dimensional simulation." << std::endl;
+            return 1;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "reaction_system.h"
+#include "two_dim_rd.h"
+
+/**
+ * @brief      Settings of a simulation started from the command line
+ *
+ * The numerical settings use the keys of the default sets of the input
+ * tab, e.g. "dX=0.16;dY=0.08;dx=1.0;dt=0.5;width=256;height=256;steps=20;tsteps=1000;pbc=1",
+ * where dX and dY are the diffusion coefficients of A and B.
+ */
+struct BatchSettings {
+    KINETICS reacttype;     //!< kinetic system
+    double Da;              //!< diffusion coefficient of A
+    double Db;              //!< diffusion coefficient of B
+    double dx;              //!< size of the space interval
+    double dt;              //!< size of the time interval
+    unsigned int width;     //!< width of the system
+    unsigned int height;    //!< height of the system
+    unsigned int steps;     //!< number of frames
+    unsigned int tsteps;    //!< number of time steps per frame
+    bool pbc;               //!< periodic boundary conditions
+};
+
+/**
+ * @brief      Parse the kinetic system and numerical settings of a command line run
+ *
+ * @param[in]  kinetics  Name of the kinetic system, e.g. "gray-scott"
+ * @param[in]  settings  Numerical settings
+ *
+ * @return     The settings
+ */
+BatchSettings parse_batch_settings(const std::string& kinetics, const std::string& settings);
+
+/**
+ * @brief      Create a reaction system of a kinetic system
+ *
+ * @param[in]  reacttype  The kinetic system
+ *
+ * @return     The reaction system
+ */
+std::unique_ptr<ReactionSystem> make_reaction_system(KINETICS reacttype);
+
+/**
+ * @brief      Create a two-dimensional system from the settings of a command line run
+ *
+ * The reaction and boundary conditions are set, but not the parameters.
+ *
+ * @param[in]  settings  The settings
+ *
+ * @return     The system
+ */
+std::unique_ptr<TwoDimRD> make_two_dim_rd(const BatchSettings& settings);
+
+/**
+ * @brief      Integrate an ensemble of simulations without a GUI
+ *
+ * Invoked as "lafluxxy --ensemble <kinetics> <settings> <params> [<params> ...]"
+ * with one parameter string per member.
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+int ensemble_main(int argc, char *argv[]);
+
+/**
+ * @brief      Perform or resume a parameter sweep without a GUI
+ *
+ * Invoked as "lafluxxy --sweep <kinetics> <settings> <params> <outdir> <range> [<range> ...]"
+ * with ranges such as "f=0.02:0.05:7", optionally followed by "--resume"
+ * and "--cores-per-run <n>".
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+int sweep_main(int argc, char *argv[]);
+
+/**
+ * @brief      Perform a distributed integration and measure its strong scaling
+ *
+ * Invoked as "lafluxxy --distributed <kinetics> <settings> <params> <nprocs>".
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+int distributed_main(int argc, char *argv[]);
+
+/**
+ * @brief      Integrate a three-dimensional system without a GUI
+ *
+ * Invoked as "lafluxxy --three-dim <kinetics> <settings> <params> <depth>".
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+int three_dim_main(int argc, char *argv[]);
@@ -24,6 +24,7 @@
 
 #define PROGRAM_NAME "LaFluxxy"
 #define PROGRAM_VERSION "0.8.2.2"
+#define CHECKPOINT_FILENAME "lafluxxy.ckpt"
 
 enum class KINETICS {
     NONE,
@@ -34,6 +35,26 @@ enum class KINETICS {
     BARKLEY
 };
 
+enum class PRECISION {
+    DOUBLE,
+    SINGLE
+};
+
+enum class TIME_INTEGRATOR {
+    EULER,
+    ETD1,
+    ETDRK2,
+    ETDRK4,
+    ADAPTIVE_HEUN_EULER,
+    ADAPTIVE_BOGACKI_SHAMPINE,
+    ADI,
+    MULTIGRID_BACKWARD_EULER,
+    MULTIGRID_CRANK_NICOLSON,
+    RKL2,
+    HEUN,
+    RK4
+};
+
 static const std::vector<KINETICS> kinetic_types = {
     KINETICS::NONE,
     KINETICS::LOTKA_VOLTERRA,
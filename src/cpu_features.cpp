@@ -0,0 +1,422 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "cpu_features.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LAFLUXXY_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef LAFLUXXY_X86
+/**
+ * @brief      Execute the CPUID instruction
+ *
+ * @param[in]  leaf     The leaf
+ * @param[in]  subleaf  The subleaf
+ * @param      regs     Output registers eax, ebx, ecx and edx
+ */
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    for(unsigned int i=0; i<4; i++) {
+        regs[i] = (unsigned int)r[i];
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/**
+ * @brief      Read the extended control register XCR0
+ *
+ * @return     Value of XCR0
+ */
+static uint64_t read_xcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax = 0;
+    uint32_t edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+/**
+ * @brief      Detect the highest supported SIMD instruction set using CPUID
+ *
+ * @return     The SIMD level
+ */
+SIMD_LEVEL detect_simd_level() {
+    SIMD_LEVEL level = SIMD_LEVEL::GENERIC;
+
+#ifdef LAFLUXXY_X86
+    unsigned int regs[4] = {0, 0, 0, 0};
+    cpuid(0, 0, regs);
+    const unsigned int max_leaf = regs[0];
+
+    if(max_leaf >= 1) {
+        cpuid(1, 0, regs);
+        const bool sse42 = (regs[2] >> 20) & 1;
+        const bool osxsave = (regs[2] >> 27) & 1;
+        const bool avx = (regs[2] >> 28) & 1;
+
+        if(sse42) {
+            level = SIMD_LEVEL::SSE42;
+        }
+
+        if(osxsave && avx && max_leaf >= 7) {
+            const uint64_t xcr0 = read_xcr0();
+            const bool os_avx = (xcr0 & 0x6) == 0x6;         // XMM and YMM state
+            const bool os_avx512 = (xcr0 & 0xE6) == 0xE6;    // additionally opmask and ZMM state
+
+            cpuid(7, 0, regs);
+            const bool avx2 = (regs[1] >> 5) & 1;
+            const bool avx512f = (regs[1] >> 16) & 1;
+
+            if(os_avx && avx2) {
+                level = SIMD_LEVEL::AVX2;
+            }
+
+            if(os_avx512 && avx512f) {
+                level = SIMD_LEVEL::AVX512;
+            }
+        }
+    }
+#endif
+
+    // allow the user to cap the instruction set
+    const char* env = std::getenv("LAFLUXXY_SIMD");
+    if(env != nullptr) {
+        const std::string cap(env);
+        SIMD_LEVEL maxlevel = level;
+        if(cap == "generic") {
+            maxlevel = SIMD_LEVEL::GENERIC;
+        } else if(cap == "sse4.2") {
+            maxlevel = SIMD_LEVEL::SSE42;
+        } else if(cap == "avx2") {
+            maxlevel = SIMD_LEVEL::AVX2;
+        }
+
+        if((int)maxlevel < (int)level) {
+            level = maxlevel;
+        }
+    }
+
+    return level;
+}
+
+/**
+ * @brief      Get a printable name of a SIMD level
+ *
+ * @param[in]  level  The SIMD level
+ *
+ * @return     The name
+ */
+const char* get_simd_level_name(SIMD_LEVEL level) {
+    switch(level) {
+        case SIMD_LEVEL::SSE42:
+            return "SSE4.2";
+        case SIMD_LEVEL::AVX2:
+            return "AVX2";
+        case SIMD_LEVEL::AVX512:
+            return "AVX-512";
+        default:
+            return "generic";
+    }
+}
+
+/**
+ * @brief      Read the logical CPUs this process is allowed to run on
+ *
+ * @return     The indices of the logical CPUs
+ */
+static std::vector<unsigned int> read_process_cpus() {
+    std::vector<unsigned int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for(unsigned int i=0; i<CPU_SETSIZE; i++) {
+            if(CPU_ISSET(i, &set)) {
+                cpus.push_back(i);
+            }
+        }
+    }
+#elif defined(_WIN32)
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if(GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+        for(unsigned int i=0; i<sizeof(DWORD_PTR) * 8; i++) {
+            if(process_mask & ((DWORD_PTR)1 << i)) {
+                cpus.push_back(i);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+// read before any thread has been pinned
+static const std::vector<unsigned int> process_cpus = read_process_cpus();
+
+/**
+ * @brief      Read the logical CPUs of every NUMA node this process is allowed to run on
+ *
+ * @return     The indices of the logical CPUs per node; nodes without such CPUs are omitted
+ */
+static std::vector<std::vector<unsigned int>> read_numa_nodes() {
+    std::vector<std::vector<unsigned int>> nodes;
+    const auto allowed = [](unsigned int cpu) {
+        return std::find(process_cpus.begin(), process_cpus.end(), cpu) != process_cpus.end();
+    };
+
+#if defined(__linux__)
+    // node directories are numbered contiguously; the lists read like "0-7,16-23"
+    for(unsigned int node=0; ; node++) {
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if(!in) {
+            break;
+        }
+
+        std::vector<unsigned int> cpus;
+        std::string range;
+        while(std::getline(in, range, ',')) {
+            unsigned int first = 0;
+            unsigned int last = 0;
+            char dash = 0;
+            std::istringstream ss(range);
+            if(!(ss >> first)) {
+                continue;
+            }
+            last = (ss >> dash >> last) ? last : first;
+            for(unsigned int cpu=first; cpu<=last; cpu++) {
+                if(allowed(cpu)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+
+        if(!cpus.empty()) {
+            nodes.push_back(cpus);
+        }
+    }
+#elif defined(_WIN32)
+    ULONG highest = 0;
+    if(GetNumaHighestNodeNumber(&highest)) {
+        for(ULONG node=0; node<=highest; node++) {
+            ULONGLONG mask = 0;
+            if(!GetNumaNodeProcessorMask((UCHAR)node, &mask)) {
+                continue;
+            }
+
+            std::vector<unsigned int> cpus;
+            for(unsigned int i=0; i<sizeof(ULONGLONG) * 8; i++) {
+                if((mask & ((ULONGLONG)1 << i)) && allowed(i)) {
+                    cpus.push_back(i);
+                }
+            }
+
+            if(!cpus.empty()) {
+                nodes.push_back(cpus);
+            }
+        }
+    }
+#endif
+
+    if(nodes.empty() && !process_cpus.empty()) {
+        nodes.push_back(process_cpus);
+    }
+
+    return nodes;
+}
+
+// read after the CPUs of the process
+static const std::vector<std::vector<unsigned int>> numa_nodes = read_numa_nodes();
+
+/**
+ * @brief      Get the number of logical CPUs this process is allowed to run on
+ *
+ * @return     The number of logical CPUs
+ */
+unsigned int get_num_available_cpus() {
+    return std::max<unsigned int>(process_cpus.size(), 1);
+}
+
+/**
+ * @brief      Get the number of NUMA nodes with logical CPUs this process is allowed to run on
+ *
+ * @return     The number of NUMA nodes
+ */
+unsigned int get_num_numa_nodes() {
+    return std::max<unsigned int>(numa_nodes.size(), 1);
+}
+
+/**
+ * @brief      Restrict the calling thread to a set of logical CPUs
+ *
+ * @param[in]  cpus  The indices of the logical CPUs
+ *
+ * @return     Whether the affinity of the thread has been set
+ */
+static bool set_thread_cpus(const std::vector<unsigned int>& cpus) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(unsigned int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for(unsigned int cpu : cpus) {
+        mask |= (DWORD_PTR)1 << cpu;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+/**
+ * @brief      Pin the calling thread according to a pinning policy
+ *
+ * @param[in]  policy    The pinning policy
+ * @param[in]  tid       Thread index
+ * @param[in]  nthreads  Number of threads
+ *
+ * @return     Whether the affinity of the thread has been set
+ */
+bool pin_current_thread(THREAD_PINNING policy, unsigned int tid, unsigned int nthreads) {
+    if(policy == THREAD_PINNING::NONE || process_cpus.empty()) {
+        return false;
+    }
+
+    const unsigned int ncpus = process_cpus.size();
+    std::vector<unsigned int> cpus;
+    switch(policy) {
+        case THREAD_PINNING::COMPACT:
+            cpus.push_back(process_cpus[tid % ncpus]);
+        break;
+        case THREAD_PINNING::SCATTER:
+            cpus.push_back(process_cpus[(unsigned int)((unsigned long)(tid % ncpus) * ncpus / std::min(std::max(nthreads, 1u), ncpus))]);
+        break;
+        case THREAD_PINNING::SOCKET:
+            // consecutive threads work on adjacent bands and share a node
+            cpus = numa_nodes[(unsigned int)((unsigned long)tid * numa_nodes.size() / std::max(nthreads, tid + 1))];
+        break;
+        default:
+            return false;
+    }
+
+    return set_thread_cpus(cpus);
+}
+
+/**
+ * @brief      Save the affinity of the calling thread
+ *
+ * @param[in]  active  Whether to save and restore the affinity
+ */
+ThreadAffinityGuard::ThreadAffinityGuard(bool active) {
+    if(!active) {
+        return;
+    }
+
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for(unsigned int i=0; i<CPU_SETSIZE; i++) {
+            if(CPU_ISSET(i, &set)) {
+                this->cpus.push_back(i);
+            }
+        }
+    }
+#elif defined(_WIN32)
+    // the affinity of a thread can only be read by replacing it
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if(GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+        const DWORD_PTR mask = SetThreadAffinityMask(GetCurrentThread(), process_mask);
+        if(mask != 0) {
+            SetThreadAffinityMask(GetCurrentThread(), mask);
+            for(unsigned int i=0; i<sizeof(DWORD_PTR) * 8; i++) {
+                if(mask & ((DWORD_PTR)1 << i)) {
+                    this->cpus.push_back(i);
+                }
+            }
+        }
+    }
+#endif
+}
+
+/**
+ * @brief      Restore the affinity of the calling thread
+ */
+ThreadAffinityGuard::~ThreadAffinityGuard() {
+    if(!this->cpus.empty()) {
+        set_thread_cpus(this->cpus);
+    }
+}
+
+/**
+ * @brief      Get a printable name of a thread pinning policy
+ *
+ * @param[in]  policy  The pinning policy
+ *
+ * @return     The name
+ */
+const char* get_thread_pinning_name(THREAD_PINNING policy) {
+    switch(policy) {
+        case THREAD_PINNING::COMPACT:
+            return "compact";
+        case THREAD_PINNING::SCATTER:
+            return "scatter";
+        case THREAD_PINNING::SOCKET:
+            return "socket";
+        default:
+            return "none";
+    }
+}
@@ -0,0 +1,138 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#pragma once
+
+#include <vector>
+
+/**
+ * @brief      SIMD instruction sets for which specialized kernels exist
+ */
+enum class SIMD_LEVEL {
+    GENERIC,
+    SSE42,
+    AVX2,
+    AVX512
+};
+
+/**
+ * @brief      Detect the highest supported SIMD instruction set using CPUID
+ *
+ * Both the CPU and the operating system need to support the instruction set,
+ * the latter is verified via XGETBV for the AVX variants. The result can be
+ * capped by setting the environment variable LAFLUXXY_SIMD to one of
+ * "generic", "sse4.2", "avx2" or "avx512".
+ *
+ * @return     The SIMD level
+ */
+SIMD_LEVEL detect_simd_level();
+
+/**
+ * @brief      Get a printable name of a SIMD level
+ *
+ * @param[in]  level  The SIMD level
+ *
+ * @return     The name
+ */
+const char* get_simd_level_name(SIMD_LEVEL level);
+
+/**
+ * @brief      Policies for pinning the OpenMP threads to logical CPUs
+ */
+enum class THREAD_PINNING {
+    NONE,       //!< leave the affinity of the threads untouched, e.g. to OMP_PROC_BIND or taskset
+    COMPACT,    //!< place consecutive threads on consecutive logical CPUs
+    SCATTER,    //!< spread the threads evenly over the available logical CPUs
+    SOCKET      //!< divide consecutive threads evenly over the NUMA nodes, each free to move within its node
+};
+
+/**
+ * @brief      Get the number of logical CPUs this process is allowed to run on
+ *
+ * The affinity mask of the process is read once, when the program starts.
+ *
+ * @return     The number of logical CPUs
+ */
+unsigned int get_num_available_cpus();
+
+/**
+ * @brief      Get the number of NUMA nodes with logical CPUs this process is allowed to run on
+ *
+ * The topology is read once, when the program starts. Without NUMA
+ * information all logical CPUs are considered to be on a single node.
+ *
+ * @return     The number of NUMA nodes
+ */
+unsigned int get_num_numa_nodes();
+
+/**
+ * @brief      Pin the calling thread according to a pinning policy
+ *
+ * With THREAD_PINNING::NONE, the affinity of the calling thread is left
+ * untouched, such that OMP_PROC_BIND, OMP_PLACES or an affinity set from
+ * outside the program keep their effect. Pinning is not supported on all
+ * platforms, in which case nothing happens.
+ *
+ * @param[in]  policy    The pinning policy
+ * @param[in]  tid       Thread index
+ * @param[in]  nthreads  Number of threads
+ *
+ * @return     Whether the affinity of the thread has been set
+ */
+bool pin_current_thread(THREAD_PINNING policy, unsigned int tid, unsigned int nthreads);
+
+/**
+ * @brief      Saves the affinity of the calling thread and restores it on destruction
+ *
+ * The calling thread takes part in a parallel region as thread 0 and is
+ * pinned along with the others; without restoring its affinity, threads it
+ * creates afterwards inherit the single logical CPU of compute thread 0.
+ */
+class ThreadAffinityGuard {
+private:
+    std::vector<unsigned int> cpus;     //!< logical CPUs the calling thread was allowed to run on
+
+public:
+    /**
+     * @brief      Save the affinity of the calling thread
+     *
+     * @param[in]  active  Whether to save and restore the affinity; without
+     *                     pinning there is nothing to restore
+     */
+    explicit ThreadAffinityGuard(bool active = true);
+
+    /**
+     * @brief      Restore the affinity of the calling thread
+     */
+    ~ThreadAffinityGuard();
+
+    ThreadAffinityGuard(const ThreadAffinityGuard&) = delete;
+    ThreadAffinityGuard& operator=(const ThreadAffinityGuard&) = delete;
+};
+
+/**
+ * @brief      Get a printable name of a thread pinning policy
+ *
+ * @param[in]  policy  The pinning policy
+ *
+ * @return     The name
+ */
+const char* get_thread_pinning_name(THREAD_PINNING policy);
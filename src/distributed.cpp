@@ -0,0 +1,676 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "distributed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <functional>
+#include <stdexcept>
+#include <omp.h>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "kinetics.h"
+#include "stencil_kernels.h"
+
+static const char* WORKER_FLAG = "--distributed-rank";  //!< first argument of the other ranks
+
+#if defined(__linux__)
+
+/**
+ * @brief      Write a buffer to a socket
+ *
+ * @param[in]  fd    The socket
+ * @param[in]  data  The data
+ * @param[in]  n     Number of bytes
+ */
+static void write_all(int fd, const void* data, size_t n) {
+    const char* p = (const char*)data;
+    while(n > 0) {
+        const ssize_t k = send(fd, p, n, MSG_NOSIGNAL);
+        if(k < 0 && errno == EINTR) {
+            continue;
+        }
+        if(k <= 0) {
+            throw std::runtime_error("Lost connection to another rank.");
+        }
+        p += k;
+        n -= k;
+    }
+}
+
+/**
+ * @brief      Read a buffer from a socket
+ *
+ * @param[in]  fd    The socket
+ * @param      data  The data
+ * @param[in]  n     Number of bytes
+ */
+static void read_all(int fd, void* data, size_t n) {
+    char* p = (char*)data;
+    while(n > 0) {
+        const ssize_t k = recv(fd, p, n, 0);
+        if(k < 0 && errno == EINTR) {
+            continue;
+        }
+        if(k <= 0) {
+            throw std::runtime_error("Lost connection to another rank.");
+        }
+        p += k;
+        n -= k;
+    }
+}
+
+/**
+ * @brief      Send and receive on up to two non-blocking sockets at once
+ *
+ * Every rank sends to and receives from both of its neighbours, such that
+ * blocking sends could wait on each other all around the ring. Instead,
+ * all transfers progress together as the sockets become ready.
+ *
+ * @param[in]  fds     The sockets; -1 for none
+ * @param[in]  out     Data to send per socket
+ * @param      in      Data to receive per socket
+ * @param[in]  n       Number of bytes per transfer
+ */
+static void exchange(const int fds[2], const char* const out[2], char* const in[2], size_t n) {
+    size_t sent[2] = {0, 0};
+    size_t received[2] = {0, 0};
+
+    for(;;) {
+        struct pollfd pfd[2];
+        unsigned int npfd = 0;
+        int which[2] = {-1, -1};
+        for(unsigned int k=0; k<2; k++) {
+            if(fds[k] < 0 || (sent[k] == n && received[k] == n)) {
+                continue;
+            }
+            pfd[npfd].fd = fds[k];
+            pfd[npfd].events = (sent[k] < n ? POLLOUT : 0) | (received[k] < n ? POLLIN : 0);
+            pfd[npfd].revents = 0;
+            which[npfd++] = k;
+        }
+        if(npfd == 0) {
+            return;
+        }
+
+        if(poll(pfd, npfd, -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot wait for the halos of the other ranks.");
+        }
+
+        for(unsigned int q=0; q<npfd; q++) {
+            const int k = which[q];
+            if(pfd[q].revents & (POLLERR | POLLNVAL)) {
+                throw std::runtime_error("Lost connection to another rank.");
+            }
+            if((pfd[q].revents & POLLOUT) && sent[k] < n) {
+                const ssize_t m = send(fds[k], out[k] + sent[k], n - sent[k], MSG_NOSIGNAL | MSG_DONTWAIT);
+                if(m < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    throw std::runtime_error("Lost connection to another rank.");
+                }
+                sent[k] += std::max<ssize_t>(m, 0);
+            }
+            if((pfd[q].revents & (POLLIN | POLLHUP)) && received[k] < n) {
+                const ssize_t m = recv(fds[k], in[k] + received[k], n - received[k], MSG_DONTWAIT);
+                if(m == 0 || (m < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    throw std::runtime_error("Lost connection to another rank.");
+                }
+                received[k] += std::max<ssize_t>(m, 0);
+            }
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief      Integrate the band of a single rank
+ *
+ * The band is stored in rows 1 to h of the matrices, with the ghost rows
+ * 0 and h+1. Every time step starts by filling the ghost rows, either from
+ * the neighbouring ranks or from the band itself, after which the band is
+ * updated in one sweep into the second generation.
+ *
+ * @param[in]  cfg       Configuration of the band
+ * @param      a         Concentration of A including the ghost rows
+ * @param      b         Concentration of B including the ghost rows
+ * @param[in]  prev_fd   Socket to the rank of the band above; -1 for none
+ * @param[in]  next_fd   Socket to the rank of the band below; -1 for none
+ * @param[in]  frame     Called with the band after every frame
+ * @param      timings   Time spent on the update and on the halo exchange
+ *
+ * @tparam     Kinetics  Kinetic system
+ */
+template<class Kinetics>
+static void integrate_band(const DistributedRD::RankConfig& cfg, MatrixXXd& a, MatrixXXd& b,
+                           int prev_fd, int next_fd,
+                           const std::function<void(const MatrixXXd&, const MatrixXXd&)>& frame,
+                           double timings[2]) {
+    const unsigned int w = cfg.width;
+    const unsigned int h = cfg.r1 - cfg.r0;
+    const bool single = (cfg.r0 == 0 && cfg.r1 == cfg.height);
+    const double idx2 = 1.0 / (cfg.dx * cfg.dx);
+    const StencilKernels& sk = get_stencil_kernels();
+    const auto kp = make_kinetic_parameters<double>(cfg.c);
+
+    MatrixXXd a_next = MatrixXXd::Zero(h + 2, w);
+    MatrixXXd b_next = MatrixXXd::Zero(h + 2, w);
+
+    // outgoing and incoming edge rows of A and B, for the band above and below
+    std::vector<double> sendbuf(4 * w);
+    std::vector<double> recvbuf(4 * w);
+
+    omp_set_num_threads(cfg.ncores);
+    MatrixXXd lap = MatrixXXd::Zero(2 * cfg.ncores, w);
+
+    timings[0] = 0.0;
+    timings[1] = 0.0;
+
+    for(unsigned int f=0; f<cfg.steps; f++) {
+        for(unsigned int s=0; s<cfg.tsteps; s++) {
+            auto start = std::chrono::steady_clock::now();
+
+            // ghost rows without a neighbouring rank
+            if(prev_fd < 0) {
+                a.row(0) = (cfg.pbc && single) ? a.row(h) : a.row(1);
+                b.row(0) = (cfg.pbc && single) ? b.row(h) : b.row(1);
+            }
+            if(next_fd < 0) {
+                a.row(h+1) = (cfg.pbc && single) ? a.row(1) : a.row(h);
+                b.row(h+1) = (cfg.pbc && single) ? b.row(1) : b.row(h);
+            }
+
+#if defined(__linux__)
+            if(prev_fd >= 0 || next_fd >= 0) {
+                std::copy(a.row(1).data(), a.row(1).data() + w, &sendbuf[0]);
+                std::copy(b.row(1).data(), b.row(1).data() + w, &sendbuf[w]);
+                std::copy(a.row(h).data(), a.row(h).data() + w, &sendbuf[2*w]);
+                std::copy(b.row(h).data(), b.row(h).data() + w, &sendbuf[3*w]);
+
+                const int fds[2] = {prev_fd, next_fd};
+                const char* const out[2] = {(const char*)&sendbuf[0], (const char*)&sendbuf[2*w]};
+                char* const in[2] = {(char*)&recvbuf[0], (char*)&recvbuf[2*w]};
+                exchange(fds, out, in, 2 * w * sizeof(double));
+
+                if(prev_fd >= 0) {
+                    std::copy(&recvbuf[0], &recvbuf[w], a.row(0).data());
+                    std::copy(&recvbuf[w], &recvbuf[2*w], b.row(0).data());
+                }
+                if(next_fd >= 0) {
+                    std::copy(&recvbuf[2*w], &recvbuf[3*w], a.row(h+1).data());
+                    std::copy(&recvbuf[3*w], &recvbuf[4*w], b.row(h+1).data());
+                }
+            }
+#endif
+            auto mid = std::chrono::steady_clock::now();
+
+            #pragma omp parallel for schedule(static)
+            for(int i=1; i<=(int)h; i++) {
+                double* lap_a = lap.row(2 * omp_get_thread_num()).data();
+                double* lap_b = lap.row(2 * omp_get_thread_num() + 1).data();
+                if(cfg.pbc) {
+                    laplacian_row_pbc(sk, lap_a, a.row(i-1).data(), a.row(i).data(), a.row(i+1).data(), w, idx2);
+                    laplacian_row_pbc(sk, lap_b, b.row(i-1).data(), b.row(i).data(), b.row(i+1).data(), w, idx2);
+                } else {
+                    laplacian_row_zeroflux(sk, lap_a, a.row(i-1).data(), a.row(i).data(), a.row(i+1).data(), w, idx2);
+                    laplacian_row_zeroflux(sk, lap_b, b.row(i-1).data(), b.row(i).data(), b.row(i+1).data(), w, idx2);
+                }
+
+                const double* a_cur = a.row(i).data();
+                const double* b_cur = b.row(i).data();
+                double* a_out = a_next.row(i).data();
+                double* b_out = b_next.row(i).data();
+
+                #pragma omp simd
+                for(unsigned int j=0; j<w; j++) {
+                    double ra = 0;
+                    double rb = 0;
+                    Kinetics::reaction(a_cur[j], b_cur[j], kp, &ra, &rb);
+
+                    a_out[j] = a_cur[j] + (lap_a[j] * cfg.Da + ra) * cfg.dt;
+                    b_out[j] = b_cur[j] + (lap_b[j] * cfg.Db + rb) * cfg.dt;
+                }
+            }
+
+            a.swap(a_next);
+            b.swap(b_next);
+
+            auto end = std::chrono::steady_clock::now();
+            timings[0] += std::chrono::duration<double>(end - mid).count();
+            timings[1] += std::chrono::duration<double>(mid - start).count();
+        }
+
+        if(frame) {
+            frame(a, b);
+        }
+    }
+}
+
+/**
+ * @brief      Integrate the band of a single rank with the kinetics of its configuration
+ *
+ * @param[in]  cfg       Configuration of the band
+ * @param      a         Concentration of A including the ghost rows
+ * @param      b         Concentration of B including the ghost rows
+ * @param[in]  prev_fd   Socket to the rank of the band above; -1 for none
+ * @param[in]  next_fd   Socket to the rank of the band below; -1 for none
+ * @param[in]  frame     Called with the band after every frame
+ * @param      timings   Time spent on the update and on the halo exchange
+ */
+static void run_band(const DistributedRD::RankConfig& cfg, MatrixXXd& a, MatrixXXd& b,
+                     int prev_fd, int next_fd,
+                     const std::function<void(const MatrixXXd&, const MatrixXXd&)>& frame,
+                     double timings[2]) {
+    switch(cfg.reacttype) {
+        case KINETICS::LOTKA_VOLTERRA:
+            integrate_band<KineticsLotkaVolterra>(cfg, a, b, prev_fd, next_fd, frame, timings);
+        break;
+        case KINETICS::GRAY_SCOTT:
+            integrate_band<KineticsGrayScott>(cfg, a, b, prev_fd, next_fd, frame, timings);
+        break;
+        case KINETICS::FITZHUGH_NAGUMO:
+            integrate_band<KineticsFitzhughNagumo>(cfg, a, b, prev_fd, next_fd, frame, timings);
+        break;
+        case KINETICS::BRUSSELATOR:
+            integrate_band<KineticsBrusselator>(cfg, a, b, prev_fd, next_fd, frame, timings);
+        break;
+        case KINETICS::BARKLEY:
+            integrate_band<KineticsBarkley>(cfg, a, b, prev_fd, next_fd, frame, timings);
+        break;
+        default:
+            throw std::logic_error("Invalid reaction system encountered.");
+        break;
+    }
+}
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _Da      Diffusion coefficient of compound A
+ * @param[in]  _Db      Diffusion coefficient of compound B
+ * @param[in]  _width   width of the system
+ * @param[in]  _height  height of the system
+ * @param[in]  _dx      size of the space interval
+ * @param[in]  _dt      size of the time interval
+ * @param[in]  _steps   number of frames
+ * @param[in]  _tsteps  number of time steps when to write a frame
+ * @param[in]  _nprocs  number of processes
+ */
+DistributedRD::DistributedRD(double _Da, double _Db,
+                             unsigned int _width, unsigned int _height,
+                             double _dx, double _dt, unsigned int _steps, unsigned int _tsteps,
+                             unsigned int _nprocs) :
+    Da(_Da),
+    Db(_Db),
+    width(_width),
+    height(_height),
+    dx(_dx),
+    dt(_dt),
+    steps(_steps),
+    tsteps(_tsteps),
+    nprocs(std::max(1u, std::min(_nprocs, _height))) {
+
+}
+
+/**
+ * @brief      Sets the reaction.
+ *
+ * @param      _reaction_system  The reaction system
+ */
+void DistributedRD::set_reaction(ReactionSystem* _reaction_system) {
+    this->reaction_system = std::unique_ptr<ReactionSystem>(_reaction_system);
+}
+
+/**
+ * @brief      Sets the parameters and the initial state.
+ *
+ * @param[in]  params  The parameters
+ */
+void DistributedRD::set_parameters(const std::string& params) {
+    this->reaction_system->set_parameters(params);
+    this->reaction_system->set_seed(params);
+
+    this->a = MatrixXXd::Zero(this->height, this->width);
+    this->b = MatrixXXd::Zero(this->height, this->width);
+    this->reaction_system->init(this->a, this->b);
+
+    this->ta.clear();
+    this->tb.clear();
+    this->ta.push_back(this->a);
+    this->tb.push_back(this->b);
+}
+
+/**
+ * @brief      Perform time integration of all frames
+ */
+void DistributedRD::time_integrate() {
+    this->timings = this->launch(this->nprocs, this->steps, this->tsteps, true);
+}
+
+/**
+ * @brief      Measure the strong scaling from the initial state
+ *
+ * Integrates nsteps time steps on 1, 2, 4, ... up to the number of
+ * processes, without gathering frames.
+ *
+ * @param[in]  nsteps  Number of time steps
+ *
+ * @return     The wall time, speedup and efficiency per number of processes
+ */
+std::vector<ScalingPoint> DistributedRD::measure_strong_scaling(unsigned int nsteps) {
+    std::vector<ScalingPoint> points;
+
+    for(unsigned int p=1; ; p = std::min(2 * p, this->nprocs)) {
+        const double wall = this->launch(p, 1, nsteps, false).wall;
+        const double speedup = points.empty() ? 1.0 : points.front().wall / wall;
+        points.push_back({p, wall, speedup, speedup / p});
+
+        if(p == this->nprocs) {
+            break;
+        }
+    }
+
+    return points;
+}
+
+/**
+ * @brief      Whether the program was executed as one of the other ranks
+ *
+ * @param[in]  argc  Number of arguments
+ * @param      argv  The arguments
+ *
+ * @return     True if worker_main() needs to be called
+ */
+bool DistributedRD::is_worker(int argc, char** argv) {
+    return argc == 5 && std::strcmp(argv[1], WORKER_FLAG) == 0;
+}
+
+#if defined(__linux__)
+
+/**
+ * @brief      Run one of the other ranks
+ *
+ * The arguments are the sockets to rank 0 and to the neighbouring ranks.
+ * The configuration and the initial band are received from rank 0, and
+ * the band is sent back after every frame, followed by the timings.
+ *
+ * @param[in]  argc  Number of arguments
+ * @param      argv  The arguments
+ *
+ * @return     Exit code of the program
+ */
+int DistributedRD::worker_main(int argc, char** argv) {
+    if(!is_worker(argc, argv)) {
+        return 1;
+    }
+
+    const int ctrl_fd = std::atoi(argv[2]);
+    const int prev_fd = std::atoi(argv[3]);
+    const int next_fd = std::atoi(argv[4]);
+
+    try {
+        RankConfig cfg;
+        read_all(ctrl_fd, &cfg, sizeof(RankConfig));
+
+        const unsigned int h = cfg.r1 - cfg.r0;
+        MatrixXXd a = MatrixXXd::Zero(h + 2, cfg.width);
+        MatrixXXd b = MatrixXXd::Zero(h + 2, cfg.width);
+        read_all(ctrl_fd, a.row(1).data(), h * cfg.width * sizeof(double));
+        read_all(ctrl_fd, b.row(1).data(), h * cfg.width * sizeof(double));
+
+        const auto frame = [ctrl_fd, h](const MatrixXXd& a, const MatrixXXd& b) {
+            write_all(ctrl_fd, a.row(1).data(), h * a.cols() * sizeof(double));
+            write_all(ctrl_fd, b.row(1).data(), h * b.cols() * sizeof(double));
+        };
+
+        double timings[2];
+        run_band(cfg, a, b, prev_fd, next_fd, frame, timings);
+        write_all(ctrl_fd, timings, sizeof(timings));
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief      Start the other ranks, integrate the band of rank 0 and gather the frames
+ *
+ * Link k connects rank k to rank k+1, and with periodic boundary conditions
+ * link n-1 connects the last rank to the first. Every other rank gets a
+ * control socket to rank 0 as well. The ranks are started by forking and
+ * executing the program, as the OpenMP runtime cannot be used in a forked
+ * copy of a process that used it before.
+ *
+ * @param[in]  _nprocs  Number of processes
+ * @param[in]  _steps   Number of frames
+ * @param[in]  _tsteps  Number of time steps per frame
+ * @param[in]  gather   Whether to store the frames
+ *
+ * @return     The timings
+ */
+DistributedTimings DistributedRD::launch(unsigned int _nprocs, unsigned int _steps, unsigned int _tsteps, bool gather) {
+    if(!this->reaction_system || this->a.size() == 0) {
+        throw std::logic_error("The parameters need to be set before the integration.");
+    }
+
+    const unsigned int n = _nprocs;
+    const auto band = [this, n](unsigned int r) {
+        return (unsigned int)((unsigned long)r * this->height / n);
+    };
+
+    std::vector<int> fds;
+    const auto make_pair = [&fds](int pair[2]) {
+        if(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) != 0) {
+            throw std::runtime_error("Cannot create the sockets between the ranks.");
+        }
+        fds.push_back(pair[0]);
+        fds.push_back(pair[1]);
+    };
+
+    std::vector<std::array<int, 2>> links(n, {-1, -1});
+    std::vector<std::array<int, 2>> ctrl(n, {-1, -1});
+    std::vector<pid_t> pids;
+
+    // stop the other ranks and release the sockets also when anything fails
+    const auto cleanup = [&]() {
+        for(int fd : fds) {
+            close(fd);
+        }
+        fds.clear();
+        for(pid_t pid : pids) {
+            int status = 0;
+            waitpid(pid, &status, 0);
+        }
+        pids.clear();
+    };
+
+    DistributedTimings result = {n, 0.0, std::vector<double>(n), std::vector<double>(n)};
+
+    try {
+        const unsigned int nlinks = (this->pbc && n > 1) ? n : n - 1;
+        for(unsigned int k=0; k<nlinks; k++) {
+            make_pair(links[k].data());
+        }
+        for(unsigned int r=1; r<n; r++) {
+            make_pair(ctrl[r].data());
+        }
+
+        const auto prev_fd = [&](unsigned int r) { return links[(r + n - 1) % n][1]; };
+        const auto next_fd = [&](unsigned int r) { return links[r][0]; };
+
+        // the sockets of the halos use non-blocking transfers
+        for(unsigned int k=0; k<nlinks; k++) {
+            fcntl(links[k][0], F_SETFL, fcntl(links[k][0], F_GETFL) | O_NONBLOCK);
+            fcntl(links[k][1], F_SETFL, fcntl(links[k][1], F_GETFL) | O_NONBLOCK);
+        }
+
+        for(unsigned int r=1; r<n; r++) {
+            // everything the child needs is prepared before forking
+            std::vector<std::string> args = {this->executable, WORKER_FLAG,
+                                             std::to_string(ctrl[r][1]),
+                                             std::to_string(prev_fd(r)),
+                                             std::to_string(next_fd(r))};
+            std::vector<char*> argv;
+            for(std::string& arg : args) {
+                argv.push_back(&arg[0]);
+            }
+            argv.push_back(nullptr);
+            const int keep[3] = {ctrl[r][1], prev_fd(r), next_fd(r)};
+
+            const pid_t pid = fork();
+            if(pid < 0) {
+                throw std::runtime_error("Cannot start the other ranks.");
+            }
+            if(pid == 0) {
+                for(int fd : keep) {
+                    if(fd >= 0) {
+                        fcntl(fd, F_SETFD, 0);
+                    }
+                }
+                execv(argv[0], argv.data());
+                _exit(127);
+            }
+            pids.push_back(pid);
+        }
+
+        // rank 0 only keeps its own ends, such that the sockets of a rank that
+        // dies are closed for good and its neighbours see the connection end
+        std::vector<int> own;
+        for(unsigned int r=1; r<n; r++) {
+            own.push_back(ctrl[r][0]);
+        }
+        if(n > 1) {
+            own.push_back(prev_fd(0));
+            own.push_back(next_fd(0));
+        }
+        std::vector<int> kept;
+        for(int fd : fds) {
+            if(std::find(own.begin(), own.end(), fd) != own.end()) {
+                kept.push_back(fd);
+            } else {
+                close(fd);
+            }
+        }
+        fds.swap(kept);
+
+        RankConfig cfg;
+        cfg.width = this->width;
+        cfg.height = this->height;
+        cfg.steps = _steps;
+        cfg.tsteps = _tsteps;
+        cfg.ncores = this->ncores;
+        cfg.pbc = this->pbc;
+        cfg.reacttype = this->reaction_system->get_reacttype();
+        cfg.dx = this->dx;
+        cfg.dt = this->dt;
+        cfg.Da = this->Da;
+        cfg.Db = this->Db;
+        cfg.c = this->reaction_system->get_kinetic_parameters();
+
+        for(unsigned int r=1; r<n; r++) {
+            cfg.r0 = band(r);
+            cfg.r1 = band(r + 1);
+            write_all(ctrl[r][0], &cfg, sizeof(RankConfig));
+            write_all(ctrl[r][0], this->a.row(cfg.r0).data(), (cfg.r1 - cfg.r0) * this->width * sizeof(double));
+            write_all(ctrl[r][0], this->b.row(cfg.r0).data(), (cfg.r1 - cfg.r0) * this->width * sizeof(double));
+        }
+
+        cfg.r0 = band(0);
+        cfg.r1 = band(1);
+        const unsigned int h = cfg.r1 - cfg.r0;
+        MatrixXXd a0 = MatrixXXd::Zero(h + 2, this->width);
+        MatrixXXd b0 = MatrixXXd::Zero(h + 2, this->width);
+        a0.middleRows(1, h) = this->a.topRows(h);
+        b0.middleRows(1, h) = this->b.topRows(h);
+
+        // frames are assembled from the band of rank 0 and those received from the others
+        const auto frame = [&](const MatrixXXd& a, const MatrixXXd& b) {
+            MatrixXXd fa(this->height, this->width);
+            MatrixXXd fb(this->height, this->width);
+            fa.topRows(h) = a.middleRows(1, h);
+            fb.topRows(h) = b.middleRows(1, h);
+            for(unsigned int r=1; r<n; r++) {
+                const unsigned int r0 = band(r);
+                const unsigned int r1 = band(r + 1);
+                read_all(ctrl[r][0], fa.row(r0).data(), (r1 - r0) * this->width * sizeof(double));
+                read_all(ctrl[r][0], fb.row(r0).data(), (r1 - r0) * this->width * sizeof(double));
+            }
+            if(gather) {
+                this->ta.push_back(std::move(fa));
+                this->tb.push_back(std::move(fb));
+            }
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        double timings[2];
+        run_band(cfg, a0, b0, n > 1 ? prev_fd(0) : -1, n > 1 ? next_fd(0) : -1, frame, timings);
+        result.compute[0] = timings[0];
+        result.halo[0] = timings[1];
+
+        for(unsigned int r=1; r<n; r++) {
+            read_all(ctrl[r][0], timings, sizeof(timings));
+            result.compute[r] = timings[0];
+            result.halo[r] = timings[1];
+        }
+        auto end = std::chrono::steady_clock::now();
+        result.wall = std::chrono::duration<double>(end - start).count();
+    } catch(...) {
+        for(pid_t pid : pids) {
+            kill(pid, SIGTERM);
+        }
+        cleanup();
+        throw;
+    }
+
+    cleanup();
+
+    return result;
+}
+
+#else
+
+int DistributedRD::worker_main(int, char**) {
+    return 1;
+}
+
+DistributedTimings DistributedRD::launch(unsigned int, unsigned int, unsigned int, bool) {
+    throw std::runtime_error("The distributed integration is only available on Linux.");
+}
+
+#endif
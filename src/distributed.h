@@ -0,0 +1,246 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "matrices.h"
+#include "reaction_system.h"
+
+/**
+ * @brief      Timings of a distributed integration
+ */
+struct DistributedTimings {
+    unsigned int nprocs;            //!< number of processes
+    double wall;                    //!< wall time of the integration in seconds
+    std::vector<double> compute;    //!< time spent on the update of the band per rank
+    std::vector<double> halo;       //!< time spent exchanging halos per rank, including waiting
+};
+
+/**
+ * @brief      Strong-scaling measurement for a single number of processes
+ */
+struct ScalingPoint {
+    unsigned int nprocs;    //!< number of processes
+    double wall;            //!< wall time in seconds
+    double speedup;         //!< speedup over a single process
+    double efficiency;      //!< speedup divided by the number of processes
+};
+
+/**
+ * @brief      Explicit Euler integration distributed over several processes
+ *
+ * The grid is split in bands of rows, one per process. Every process keeps
+ * its band with a ghost row above and below and exchanges its edge rows
+ * with the neighbouring processes each time step over Unix sockets, such
+ * that the processes can run on different sockets of a machine and each
+ * bring their own memory bandwidth. At the edges of the domain the ghost
+ * rows wrap around for periodic boundary conditions, or reflect the edge
+ * row for zero-flux boundaries. The frames are gathered on rank 0, which
+ * is the calling process.
+ *
+ * The other ranks are started by executing this program again with the
+ * arguments recognized by is_worker(); main() needs to hand these over to
+ * worker_main() before doing anything else. Only Linux is supported.
+ */
+class DistributedRD {
+public:
+    /**
+     * @brief      Configuration of the band of a single rank
+     */
+    struct RankConfig {
+        unsigned int width;         //!< width of the system
+        unsigned int height;        //!< height of the system
+        unsigned int r0;            //!< first row of the band
+        unsigned int r1;            //!< one past the last row of the band
+        unsigned int steps;         //!< number of frames
+        unsigned int tsteps;        //!< number of time steps per frame
+        unsigned int ncores;        //!< number of threads of the rank
+        unsigned int pbc;           //!< periodic boundary conditions
+        KINETICS reacttype;         //!< kinetic system
+        double dx;                  //!< size of the space interval
+        double dt;                  //!< size of the time interval
+        double Da;                  //!< diffusion coefficient of A
+        double Db;                  //!< diffusion coefficient of B
+        std::array<double, 4> c;    //!< generalized kinetic parameters
+    };
+
+private:
+    double Da;              //!< diffusion coefficient of A
+    double Db;              //!< diffusion coefficient of B
+    unsigned int width;     //!< width of the system
+    unsigned int height;    //!< height of the system
+    double dx;              //!< size of the space interval
+    double dt;              //!< size of the time interval
+    unsigned int steps;     //!< number of frames
+    unsigned int tsteps;    //!< number of time steps when to write a frame
+    unsigned int nprocs;    //!< number of processes
+    unsigned int ncores = 1;    //!< number of threads per process
+    bool pbc = false;       //!< periodic boundary conditions
+    std::string executable = "/proc/self/exe";  //!< program that is executed for the other ranks
+
+    MatrixXXd a;            //!< initial concentration of A
+    MatrixXXd b;            //!< initial concentration of B
+
+    std::vector<MatrixXXd> ta;  //!< matrix to hold temporal data
+    std::vector<MatrixXXd> tb;  //!< matrix to hold temporal data
+
+    DistributedTimings timings; //!< timings of the last integration
+
+    std::unique_ptr<ReactionSystem> reaction_system;    //!< reaction system
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _Da      Diffusion coefficient of compound A
+     * @param[in]  _Db      Diffusion coefficient of compound B
+     * @param[in]  _width   width of the system
+     * @param[in]  _height  height of the system
+     * @param[in]  _dx      size of the space interval
+     * @param[in]  _dt      size of the time interval
+     * @param[in]  _steps   number of frames
+     * @param[in]  _tsteps  number of time steps when to write a frame
+     * @param[in]  _nprocs  number of processes
+     */
+    DistributedRD(double _Da, double _Db,
+                  unsigned int _width, unsigned int _height,
+                  double _dx, double _dt, unsigned int _steps, unsigned int _tsteps,
+                  unsigned int _nprocs);
+
+    /**
+     * @brief      Sets the reaction.
+     *
+     * @param      _reaction_system  The reaction system
+     */
+    void set_reaction(ReactionSystem* _reaction_system);
+
+    /**
+     * @brief      Set whether system has periodic boundary conditions
+     *
+     * @param[in]  _pbc  Periodic boundary conditions
+     */
+    inline void set_pbc(bool _pbc) {
+        this->pbc = _pbc;
+    }
+
+    /**
+     * @brief      Set the number of threads of every process
+     *
+     * @param[in]  _ncores  Number of cores
+     */
+    inline void set_cores(unsigned int _ncores) {
+        this->ncores = std::max(1u, _ncores);
+    }
+
+    /**
+     * @brief      Set the program that is executed for the other ranks
+     *
+     * @param[in]  _executable  Path of the program
+     */
+    inline void set_executable(const std::string& _executable) {
+        this->executable = _executable;
+    }
+
+    /**
+     * @brief      Sets the parameters and the initial state.
+     *
+     * @param[in]  params  The parameters
+     */
+    void set_parameters(const std::string& params);
+
+    /**
+     * @brief      Perform time integration of all frames
+     */
+    void time_integrate();
+
+    /**
+     * @brief      Measure the strong scaling from the initial state
+     *
+     * Integrates nsteps time steps on 1, 2, 4, ... up to the number of
+     * processes, without gathering frames.
+     *
+     * @param[in]  nsteps  Number of time steps
+     *
+     * @return     The wall time, speedup and efficiency per number of processes
+     */
+    std::vector<ScalingPoint> measure_strong_scaling(unsigned int nsteps);
+
+    /**
+     * @brief      Gets the concentrations.
+     *
+     * @param[in]  first  Whether to return concentrations of X
+     *
+     * @return     The concentrations.
+     */
+    inline const auto& get_concentrations(bool first) const {
+        return first ? this->ta : this->tb;
+    }
+
+    /**
+     * @brief      Get the timings of the last integration
+     *
+     * @return     The timings
+     */
+    inline const auto& get_timings() const {
+        return this->timings;
+    }
+
+    /**
+     * @brief      Whether the program was executed as one of the other ranks
+     *
+     * @param[in]  argc  Number of arguments
+     * @param      argv  The arguments
+     *
+     * @return     True if worker_main() needs to be called
+     */
+    static bool is_worker(int argc, char** argv);
+
+    /**
+     * @brief      Run one of the other ranks
+     *
+     * @param[in]  argc  Number of arguments
+     * @param      argv  The arguments
+     *
+     * @return     Exit code of the program
+     */
+    static int worker_main(int argc, char** argv);
+
+private:
+    /**
+     * @brief      Start the other ranks, integrate the band of rank 0 and gather the frames
+     *
+     * @param[in]  _nprocs  Number of processes
+     * @param[in]  _steps   Number of frames
+     * @param[in]  _tsteps  Number of time steps per frame
+     * @param[in]  gather   Whether to store the frames
+     *
+     * @return     The timings
+     */
+    DistributedTimings launch(unsigned int _nprocs, unsigned int _steps, unsigned int _tsteps, bool gather);
+};
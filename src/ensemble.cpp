@@ -0,0 +1,295 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "ensemble.h"
+
+#include <stdexcept>
+#include <omp.h>
+
+#include "kinetics.h"
+#include "reaction_lotka_volterra.h"
+#include "reaction_gray_scott.h"
+#include "reaction_fitzhugh_nagumo.h"
+#include "reaction_brusselator.h"
+#include "reaction_barkley.h"
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _width      width of the system
+ * @param[in]  _height     height of the system
+ * @param[in]  _dx         size of the space interval
+ * @param[in]  _dt         size of the time interval
+ * @param[in]  _Da         diffusion coefficient of A
+ * @param[in]  _Db         diffusion coefficient of B
+ * @param[in]  _pbc        periodic boundary conditions
+ * @param[in]  _reacttype  kinetic system of all members
+ */
+EnsembleIntegrator::EnsembleIntegrator(unsigned int _width, unsigned int _height, double _dx, double _dt,
+                                       double _Da, double _Db, bool _pbc, KINETICS _reacttype) :
+    width(_width),
+    height(_height),
+    dx(_dx),
+    dt(_dt),
+    Da(_Da),
+    Db(_Db),
+    pbc(_pbc),
+    reacttype(_reacttype) {
+
+    switch(this->reacttype) {
+        case KINETICS::LOTKA_VOLTERRA:
+            this->select_pack_function<KineticsLotkaVolterra>();
+        break;
+        case KINETICS::GRAY_SCOTT:
+            this->select_pack_function<KineticsGrayScott>();
+        break;
+        case KINETICS::FITZHUGH_NAGUMO:
+            this->select_pack_function<KineticsFitzhughNagumo>();
+        break;
+        case KINETICS::BRUSSELATOR:
+            this->select_pack_function<KineticsBrusselator>();
+        break;
+        case KINETICS::BARKLEY:
+            this->select_pack_function<KineticsBarkley>();
+        break;
+        default:
+            throw std::logic_error("Invalid reaction system encountered.");
+        break;
+    }
+}
+
+/**
+ * @brief      Add a member to the ensemble
+ *
+ * The parameters are parsed by the reaction system of the member, such
+ * that they follow the same format as for a single simulation.
+ *
+ * @param[in]  params  Parameters of the reaction system, e.g. "f=0.035;k=0.06"
+ *
+ * @return     Index of the member
+ */
+unsigned int EnsembleIntegrator::add_member(const std::string& params) {
+    auto reaction_system = this->make_reaction_system();
+    reaction_system->set_parameters(params);
+    reaction_system->set_seed(params);
+    this->members.push_back(std::move(reaction_system));
+
+    return this->members.size() - 1;
+}
+
+/**
+ * @brief      Set the initial state of all members and store it as the first frame
+ *
+ * Lanes of the last pack without a member carry the kinetic parameters of
+ * the first lane and an empty state.
+ */
+void EnsembleIntegrator::init() {
+    if(this->members.empty()) {
+        throw std::runtime_error("The ensemble has no members.");
+    }
+
+    const unsigned int npacks = (this->members.size() + LANES - 1) / LANES;
+    this->packs.assign(npacks, Pack());
+    this->ta.assign(this->members.size(), std::vector<MatrixXXd>());
+    this->tb.assign(this->members.size(), std::vector<MatrixXXd>());
+
+    MatrixXXd a(this->height, this->width);
+    MatrixXXd b(this->height, this->width);
+
+    for(unsigned int p=0; p<npacks; p++) {
+        Pack& pack = this->packs[p];
+        pack.a = MatrixXXd::Zero(this->height, this->width * LANES);
+        pack.b = MatrixXXd::Zero(this->height, this->width * LANES);
+        pack.a_next = MatrixXXd::Zero(this->height, this->width * LANES);
+        pack.b_next = MatrixXXd::Zero(this->height, this->width * LANES);
+
+        for(unsigned int l=0; l<LANES; l++) {
+            const bool used = (p * LANES + l < this->members.size());
+            const unsigned int m = used ? p * LANES + l : p * LANES;
+            const auto c = this->members[m]->get_kinetic_parameters();
+            for(unsigned int k=0; k<4; k++) {
+                pack.c[k][l] = c[k];
+            }
+
+            if(!used) {
+                continue;
+            }
+
+            this->members[m]->init(a, b);
+            for(unsigned int i=0; i<this->height; i++) {
+                for(unsigned int j=0; j<this->width; j++) {
+                    pack.a(i, j * LANES + l) = a(i, j);
+                    pack.b(i, j * LANES + l) = b(i, j);
+                }
+            }
+        }
+
+        this->store_frames(p);
+    }
+}
+
+/**
+ * @brief      Advance all members by a number of time steps and store a frame
+ *
+ * Every thread advances whole packs, such that the threads only
+ * synchronize once per call.
+ *
+ * @param[in]  nsteps  Number of time steps
+ * @param[in]  ncores  Number of threads
+ */
+void EnsembleIntegrator::update(unsigned int nsteps, unsigned int ncores) {
+    const int npacks = this->packs.size();
+
+    omp_set_num_threads(ncores);
+    #pragma omp parallel for schedule(dynamic)
+    for(int p=0; p<npacks; p++) {
+        (this->*pack_function)(this->packs[p], nsteps);
+        this->store_frames(p);
+    }
+}
+
+/**
+ * @brief      Create a reaction system of the kinetic system of the ensemble
+ *
+ * @return     The reaction system
+ */
+std::unique_ptr<ReactionSystem> EnsembleIntegrator::make_reaction_system() const {
+    switch(this->reacttype) {
+        case KINETICS::LOTKA_VOLTERRA:
+            return std::make_unique<ReactionLotkaVolterra>();
+        case KINETICS::GRAY_SCOTT:
+            return std::make_unique<ReactionGrayScott>();
+        case KINETICS::FITZHUGH_NAGUMO:
+            return std::make_unique<ReactionFitzhughNagumo>();
+        case KINETICS::BRUSSELATOR:
+            return std::make_unique<ReactionBrusselator>();
+        case KINETICS::BARKLEY:
+            return std::make_unique<ReactionBarkley>();
+        default:
+            throw std::logic_error("Invalid reaction system encountered.");
+    }
+}
+
+/**
+ * @brief      Select the time steps that are specialized for the kinetic system
+ *
+ * @tparam     Kinetics  Kinetic system
+ */
+template<class Kinetics>
+void EnsembleIntegrator::select_pack_function() {
+    this->pack_function = &EnsembleIntegrator::advance_pack<Kinetics>;
+}
+
+/**
+ * @brief      Advance a pack by a number of explicit Euler steps
+ *
+ * Each step reads one generation and writes the other. The neighbours of
+ * a cell are LANES values apart, such that the loop over the lanes is
+ * contiguous and runs in vector registers. At the edges of the domain the
+ * neighbours either wrap around or reflect onto the cell itself.
+ *
+ * @param      pack    The pack
+ * @param[in]  nsteps  Number of time steps
+ *
+ * @tparam     Kinetics  Kinetic system
+ */
+template<class Kinetics>
+void EnsembleIntegrator::advance_pack(Pack& pack, unsigned int nsteps) const {
+    const double idx2 = 1.0 / (this->dx * this->dx);
+    const double Da = this->Da;
+    const double Db = this->Db;
+    const double dt = this->dt;
+    const int nrows = this->height;
+    const int ncols = this->width;
+
+    const double* c1 = pack.c[0].data();
+    const double* c2 = pack.c[1].data();
+    const double* c3 = pack.c[2].data();
+    const double* c4 = pack.c[3].data();
+
+    for(unsigned int s=0; s<nsteps; s++) {
+        for(int i=0; i<nrows; i++) {
+            const int iprev = (i > 0) ? i - 1 : (this->pbc ? nrows - 1 : i);
+            const int inext = (i + 1 < nrows) ? i + 1 : (this->pbc ? 0 : i);
+
+            const double* a_prev = pack.a.row(iprev).data();
+            const double* a_cur = pack.a.row(i).data();
+            const double* a_next = pack.a.row(inext).data();
+            const double* b_prev = pack.b.row(iprev).data();
+            const double* b_cur = pack.b.row(i).data();
+            const double* b_next = pack.b.row(inext).data();
+            double* a_out = pack.a_next.row(i).data();
+            double* b_out = pack.b_next.row(i).data();
+
+            for(int j=0; j<ncols; j++) {
+                const int jprev = (j > 0) ? j - 1 : (this->pbc ? ncols - 1 : j);
+                const int jnext = (j + 1 < ncols) ? j + 1 : (this->pbc ? 0 : j);
+                const unsigned int o = j * LANES;
+                const unsigned int ow = jprev * LANES;
+                const unsigned int oe = jnext * LANES;
+
+                #pragma omp simd
+                for(unsigned int l=0; l<LANES; l++) {
+                    const KineticParameters<double> kp = {c1[l], c2[l], c3[l], c4[l]};
+                    const double a = a_cur[o + l];
+                    const double b = b_cur[o + l];
+
+                    const double lap_a = (a_prev[o + l] + a_next[o + l] + a_cur[ow + l] + a_cur[oe + l] - 4.0 * a) * idx2;
+                    const double lap_b = (b_prev[o + l] + b_next[o + l] + b_cur[ow + l] + b_cur[oe + l] - 4.0 * b) * idx2;
+
+                    double ra = 0;
+                    double rb = 0;
+                    Kinetics::reaction(a, b, kp, &ra, &rb);
+
+                    a_out[o + l] = a + (lap_a * Da + ra) * dt;
+                    b_out[o + l] = b + (lap_b * Db + rb) * dt;
+                }
+            }
+        }
+
+        pack.a.swap(pack.a_next);
+        pack.b.swap(pack.b_next);
+    }
+}
+
+/**
+ * @brief      Append the current state of all members of a pack to their frames
+ *
+ * @param[in]  p     Index of the pack
+ */
+void EnsembleIntegrator::store_frames(unsigned int p) {
+    const Pack& pack = this->packs[p];
+
+    for(unsigned int l=0; l<LANES && p * LANES + l < this->members.size(); l++) {
+        const unsigned int m = p * LANES + l;
+        MatrixXXd a(this->height, this->width);
+        MatrixXXd b(this->height, this->width);
+        for(unsigned int i=0; i<this->height; i++) {
+            for(unsigned int j=0; j<this->width; j++) {
+                a(i, j) = pack.a(i, j * LANES + l);
+                b(i, j) = pack.b(i, j * LANES + l);
+            }
+        }
+        this->ta[m].push_back(std::move(a));
+        this->tb[m].push_back(std::move(b));
+    }
+}
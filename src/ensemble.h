@@ -0,0 +1,174 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "matrices.h"
+#include "reaction_system.h"
+
+/**
+ * @brief      Explicit Euler integrator for an ensemble of small simulations
+ *
+ * Parameter scans run hundreds of small simulations that differ only in
+ * their kinetic parameters. Each of them is too small to keep several
+ * cores busy, such that they are batched instead: the members are grouped
+ * in packs of LANES simulations whose concentrations are interleaved per
+ * cell, i.e. cell (i,j) of lane l is stored at column j * LANES + l. The
+ * innermost loop runs over the lanes, such that one vector lane integrates
+ * one simulation with its own kinetic parameters, and the threads work on
+ * whole packs without synchronizing between time steps.
+ *
+ * All members share the grid, the diffusion coefficients and the kinetic
+ * system; their parameters are given as the same parameter strings as for
+ * a single simulation.
+ */
+class EnsembleIntegrator {
+public:
+    static constexpr unsigned int LANES = 8;    //!< number of members per pack
+
+private:
+    /**
+     * @brief      Interleaved state of a pack of members
+     */
+    struct Pack {
+        MatrixXXd a;                            //!< interleaved concentration of A
+        MatrixXXd b;                            //!< interleaved concentration of B
+        MatrixXXd a_next;                       //!< second generation of A
+        MatrixXXd b_next;                       //!< second generation of B
+        std::array<std::array<double, LANES>, 4> c; //!< generalized kinetic parameters per lane
+    };
+
+    unsigned int width;     //!< width of the system
+    unsigned int height;    //!< height of the system
+    double dx;              //!< size of the space interval
+    double dt;              //!< size of the time interval
+    double Da;              //!< diffusion coefficient of A
+    double Db;              //!< diffusion coefficient of B
+    bool pbc;               //!< periodic boundary conditions
+    KINETICS reacttype;     //!< kinetic system of all members
+
+    std::vector<std::unique_ptr<ReactionSystem>> members;  //!< reaction system of every member
+    std::vector<Pack> packs;                                //!< interleaved state of the members
+    std::vector<std::vector<MatrixXXd>> ta;                 //!< frames of A per member
+    std::vector<std::vector<MatrixXXd>> tb;                 //!< frames of B per member
+
+    void (EnsembleIntegrator::*pack_function)(Pack&, unsigned int) const = nullptr;   //!< time steps specialized for the kinetic system
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _width      width of the system
+     * @param[in]  _height     height of the system
+     * @param[in]  _dx         size of the space interval
+     * @param[in]  _dt         size of the time interval
+     * @param[in]  _Da         diffusion coefficient of A
+     * @param[in]  _Db         diffusion coefficient of B
+     * @param[in]  _pbc        periodic boundary conditions
+     * @param[in]  _reacttype  kinetic system of all members
+     */
+    EnsembleIntegrator(unsigned int _width, unsigned int _height, double _dx, double _dt,
+                       double _Da, double _Db, bool _pbc, KINETICS _reacttype);
+
+    /**
+     * @brief      Add a member to the ensemble
+     *
+     * @param[in]  params  Parameters of the reaction system, e.g. "f=0.035;k=0.06"
+     *
+     * @return     Index of the member
+     */
+    unsigned int add_member(const std::string& params);
+
+    /**
+     * @brief      Set the initial state of all members and store it as the first frame
+     */
+    void init();
+
+    /**
+     * @brief      Advance all members by a number of time steps and store a frame
+     *
+     * @param[in]  nsteps  Number of time steps
+     * @param[in]  ncores  Number of threads
+     */
+    void update(unsigned int nsteps, unsigned int ncores);
+
+    /**
+     * @brief      Get the number of members
+     *
+     * @return     The number of members
+     */
+    inline size_t get_num_members() const {
+        return this->members.size();
+    }
+
+    /**
+     * @brief      Get the frames of a member
+     *
+     * @param[in]  member  Index of the member
+     * @param[in]  first   Whether to return the concentrations of A
+     *
+     * @return     The frames
+     */
+    inline const auto& get_concentrations(unsigned int member, bool first) const {
+        return first ? this->ta[member] : this->tb[member];
+    }
+
+private:
+    /**
+     * @brief      Create a reaction system of the kinetic system of the ensemble
+     *
+     * @return     The reaction system
+     */
+    std::unique_ptr<ReactionSystem> make_reaction_system() const;
+
+    /**
+     * @brief      Select the time steps that are specialized for the kinetic system
+     *
+     * @tparam     Kinetics  Kinetic system
+     */
+    template<class Kinetics>
+    void select_pack_function();
+
+    /**
+     * @brief      Advance a pack by a number of explicit Euler steps
+     *
+     * @param      pack    The pack
+     * @param[in]  nsteps  Number of time steps
+     *
+     * @tparam     Kinetics  Kinetic system
+     */
+    template<class Kinetics>
+    void advance_pack(Pack& pack, unsigned int nsteps) const;
+
+    /**
+     * @brief      Append the current state of all members of a pack to their frames
+     *
+     * @param[in]  p     Index of the pack
+     */
+    void store_frames(unsigned int p);
+};
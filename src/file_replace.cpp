@@ -0,0 +1,82 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "file_replace.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+/**
+ * @brief      Widen a filename with the code page that the narrow file streams use
+ *
+ * @param[in]  str   The filename
+ *
+ * @return     The wide filename
+ */
+static std::wstring widen(const std::string& str) {
+    const int n = MultiByteToWideChar(CP_ACP, 0, str.c_str(), -1, nullptr, 0);
+    std::wstring wstr(n > 0 ? n : 1, L'\0');
+    MultiByteToWideChar(CP_ACP, 0, str.c_str(), -1, &wstr[0], n);
+    return wstr;
+}
+#endif
+
+/**
+ * @brief      Replace a file by a completely written temporary file
+ *
+ * @param[in]  tmpname   The temporary file, which needs to be closed
+ * @param[in]  filename  The file to replace
+ *
+ * @return     Whether the file has been replaced
+ */
+bool replace_file(const std::string& tmpname, const std::string& filename) {
+#ifdef _WIN32
+    const std::wstring wtmpname = widen(tmpname);
+    HANDLE handle = CreateFileW(wtmpname.c_str(), GENERIC_WRITE, 0, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    const bool flushed = FlushFileBuffers(handle) != 0;
+    CloseHandle(handle);
+
+    return flushed && MoveFileExW(wtmpname.c_str(), widen(filename).c_str(),
+                                  MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    const int fd = open(tmpname.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    const bool flushed = fsync(fd) == 0;
+    close(fd);
+
+    return flushed && std::rename(tmpname.c_str(), filename.c_str()) == 0;
+#endif
+}
@@ -0,0 +1,40 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+/**
+ * @brief      Replace a file by a completely written temporary file
+ *
+ * The temporary file is flushed to disk before it takes the place of the
+ * file, such that a crash never leaves an empty or truncated file under the
+ * name of the file. An existing file of that name is replaced, also on
+ * Windows, where std::rename fails in that case.
+ *
+ * @param[in]  tmpname   The temporary file, which needs to be closed
+ * @param[in]  filename  The file to replace
+ *
+ * @return     Whether the file has been replaced
+ */
+bool replace_file(const std::string& tmpname, const std::string& filename);
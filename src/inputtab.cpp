@@ -89,53 +89,93 @@ InputTab::InputTab(QWidget *parent) : QWidget(parent), reaction_settings(nullptr
     connect(this->reaction_selector, SIGNAL(currentIndexChanged(int)), SLOT(set_reaction_input(int)));
     connect(this->checkbox_enable_maze, SIGNAL(stateChanged(int)), SLOT(action_enable_maze(int)));
     connect(this->compute_device, SIGNAL(currentIndexChanged(int)), SLOT(select_computer_device(int)));
+    connect(this->input_integrator, SIGNAL(currentIndexChanged(int)), SLOT(select_integrator(int)));
+    connect(this->input_stencil, SIGNAL(currentIndexChanged(int)), SLOT(select_stencil(int)));
+    connect(this->checkbox_adaptive_mesh, SIGNAL(stateChanged(int)), SLOT(select_adaptive_mesh(int)));
+    connect(this->input_width, SIGNAL(valueChanged(int)), SLOT(select_grid_size(int)));
+    connect(this->input_height, SIGNAL(valueChanged(int)), SLOT(select_grid_size(int)));
 }
 
-TwoDimRD* InputTab::build_reaction_system() {
-    TwoDimRD* reaction_system = new TwoDimRD(this->input_diffusion_X->value(),
-                                             this->input_diffusion_Y->value(),
-                                             this->input_width->value(),
-                                             this->input_height->value(),
-                                             this->input_dx->value(),
-                                             this->input_dt->value(),
-                                             this->input_steps->value(),
-                                             this->input_tsteps->value());
-    reaction_system->set_cores(this->input_ncores->value());
+/**
+ * @brief      Build the reaction system from the input or resume it from a checkpoint
+ *
+ * @param[in]  checkpoint  The checkpoint to resume from; empty for a new run
+ *
+ * @return     The reaction system
+ */
+TwoDimRD* InputTab::build_reaction_system(const QString& checkpoint) {
+    TwoDimRD* reaction_system = nullptr;
+    const bool resume = !checkpoint.isEmpty();
 
-    KINETICS reacttype = kinetic_types[this->reaction_selector->currentIndex()];
-    switch(reacttype) {
-        case KINETICS::LOTKA_VOLTERRA:
-            reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionLotkaVolterra()));
-        break;
-        case KINETICS::GRAY_SCOTT:
-            reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionGrayScott()));
-        break;
-        case KINETICS::BARKLEY:
-            reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionBarkley()));
-        break;
-        case KINETICS::FITZHUGH_NAGUMO:
-            reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionFitzhughNagumo()));
-        break;
-        case KINETICS::BRUSSELATOR:
-            reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionBrusselator()));
-        break;
-        default:
-            throw std::logic_error("Invalid reaction system encountered.");
-        break;
-    }
+    if(resume) {
+        reaction_system = TwoDimRD::from_checkpoint(checkpoint.toStdString()).release();
+    } else {
+        reaction_system = new TwoDimRD(this->input_diffusion_X->value(),
+                                       this->input_diffusion_Y->value(),
+                                       this->input_width->value(),
+                                       this->input_height->value(),
+                                       this->input_dx->value(),
+                                       this->input_dt->value(),
+                                       this->input_steps->value(),
+                                       this->input_tsteps->value());
+
+        KINETICS reacttype = kinetic_types[this->reaction_selector->currentIndex()];
+        switch(reacttype) {
+            case KINETICS::LOTKA_VOLTERRA:
+                reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionLotkaVolterra()));
+            break;
+            case KINETICS::GRAY_SCOTT:
+                reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionGrayScott()));
+            break;
+            case KINETICS::BARKLEY:
+                reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionBarkley()));
+            break;
+            case KINETICS::FITZHUGH_NAGUMO:
+                reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionFitzhughNagumo()));
+            break;
+            case KINETICS::BRUSSELATOR:
+                reaction_system->set_reaction(dynamic_cast<ReactionSystem*>(new ReactionBrusselator()));
+            break;
+            default:
+                throw std::logic_error("Invalid reaction system encountered.");
+            break;
+        }
 
-    // set periodic boundary conditions
-    reaction_system->set_pbc(this->checkbox_pbc->isChecked());
+        // set periodic boundary conditions
+        reaction_system->set_pbc(this->checkbox_pbc->isChecked());
 
-    // check for maze and apply mask
-    if(this->maze != nullptr && this->checkbox_enable_maze->checkState() == Qt::Checked) {
-        reaction_system->set_mask(this->maze->get_mask(this->mask_cell_size));
+        // check for maze and apply mask
+        if(this->maze != nullptr && this->checkbox_enable_maze->checkState() == Qt::Checked) {
+            reaction_system->set_mask(this->maze->get_mask(this->mask_cell_size));
+        }
     }
 
+    reaction_system->set_cores(this->input_ncores->value());
+    reaction_system->set_thread_pinning((THREAD_PINNING)this->input_pinning->currentIndex());
     reaction_system->set_do_cuda(this->compute_device->currentIndex() > 0 ? true : false);
 
+    // set time integrator; the order of the items follows TIME_INTEGRATOR
+    reaction_system->set_integrator((TIME_INTEGRATOR)this->input_integrator->currentIndex());
+    reaction_system->set_tolerances(this->input_atol->value(), this->input_rtol->value());
+    reaction_system->set_steady_state(this->input_steady->value());
+    reaction_system->set_stencil((STENCIL)this->input_stencil->currentIndex());
+
+    // set floating point precision
+    reaction_system->set_precision(this->input_precision->currentIndex() > 0 ? PRECISION::SINGLE : PRECISION::DOUBLE);
+    reaction_system->set_validate_precision(this->input_precision->currentIndex() == 2);
+    reaction_system->set_temporal_blocking(this->checkbox_temporal_blocking->isChecked());
+    reaction_system->set_blocking_measurement(this->checkbox_temporal_blocking->isChecked());
+    reaction_system->set_adaptive_mesh(this->checkbox_adaptive_mesh->isEnabled() &&
+                                       this->checkbox_adaptive_mesh->isChecked());
+
+    reaction_system->set_checkpoint(CHECKPOINT_FILENAME, this->input_checkpoint->value());
+
     // !! always do this at the very end !!
-    reaction_system->set_parameters(this->reaction_settings->get_parameter_string());
+    if(resume) {
+        reaction_system->resume();
+    } else {
+        reaction_system->set_parameters(this->reaction_settings->get_parameter_string());
+    }
 
     return reaction_system;
 }
@@ -301,6 +341,94 @@ void InputTab::build_general_parameters(QGridLayout *gridlayout) {
     gridlayout->addWidget(new QLabel("Which computing device to use (CPU or CUDA-GPU)"), row, 2);
     row++;
 
+    this->input_integrator = new QComboBox();
+    this->input_integrator->addItem("explicit Euler");
+    this->input_integrator->addItem("ETD1");
+    this->input_integrator->addItem("ETDRK2");
+    this->input_integrator->addItem("ETDRK4");
+    this->input_integrator->addItem("adaptive Heun-Euler");
+    this->input_integrator->addItem("adaptive Bogacki-Shampine");
+    this->input_integrator->addItem("ADI (implicit diffusion)");
+    this->input_integrator->addItem("multigrid backward Euler");
+    this->input_integrator->addItem("multigrid Crank-Nicolson");
+    this->input_integrator->addItem("RKL2 super-time-stepping");
+    this->input_integrator->addItem("Heun");
+    this->input_integrator->addItem("classical RK4");
+    gridlayout->addWidget(new QLabel("integrator"), row, 0);
+    gridlayout->addWidget(this->input_integrator, row, 1);
+    gridlayout->addWidget(new QLabel("Time integrator on the CPU; the ETD schemes (no maze), ADI, multigrid and RKL2 allow much larger time steps"), row, 2);
+    row++;
+
+    // order of the items follows STENCIL
+    this->input_stencil = new QComboBox();
+    this->input_stencil->addItem(get_stencil_name(STENCIL::FIVE_POINT));
+    this->input_stencil->addItem(get_stencil_name(STENCIL::NINE_POINT));
+    this->input_stencil->addItem(get_stencil_name(STENCIL::FOURTH_ORDER));
+    gridlayout->addWidget(new QLabel("stencil"), row, 0);
+    gridlayout->addWidget(this->input_stencil, row, 1);
+    gridlayout->addWidget(new QLabel("Laplacian stencil on the CPU (no maze); the 9-point stencil is isotropic, the 4th order stencil allows a coarser dx"), row, 2);
+    row++;
+
+    this->input_atol = new QDoubleSpinBox();
+    this->input_atol->setDecimals(10);
+    this->input_atol->setRange(1e-10, 1.0);
+    this->input_atol->setValue(1e-6);
+    this->input_atol->setEnabled(false);
+    gridlayout->addWidget(new QLabel("atol"), row, 0);
+    gridlayout->addWidget(this->input_atol, row, 1);
+    gridlayout->addWidget(new QLabel("Absolute tolerance of the adaptive integrators; dt is used as the initial time step"), row, 2);
+    row++;
+
+    this->input_rtol = new QDoubleSpinBox();
+    this->input_rtol->setDecimals(10);
+    this->input_rtol->setRange(1e-10, 1.0);
+    this->input_rtol->setValue(1e-4);
+    this->input_rtol->setEnabled(false);
+    gridlayout->addWidget(new QLabel("rtol"), row, 0);
+    gridlayout->addWidget(this->input_rtol, row, 1);
+    gridlayout->addWidget(new QLabel("Relative tolerance of the adaptive integrators"), row, 2);
+    row++;
+
+    this->input_steady = new QDoubleSpinBox();
+    this->input_steady->setDecimals(10);
+    this->input_steady->setRange(0.0, 1.0);
+    this->input_steady->setValue(0.0);
+    gridlayout->addWidget(new QLabel("steady state"), row, 0);
+    gridlayout->addWidget(this->input_steady, row, 1);
+    gridlayout->addWidget(new QLabel("Stop when the largest rate of change stays below this value for 5 frames (0 disables)"), row, 2);
+    row++;
+
+    this->input_checkpoint = new QSpinBox();
+    this->input_checkpoint->setRange(0, 100000);
+    this->input_checkpoint->setValue(0);
+    gridlayout->addWidget(new QLabel("checkpoint"), row, 0);
+    gridlayout->addWidget(this->input_checkpoint, row, 1);
+    gridlayout->addWidget(new QLabel("Write the state to " CHECKPOINT_FILENAME " every this many frames and when the run ends (0 disables)"), row, 2);
+    row++;
+
+    this->input_precision = new QComboBox();
+    this->input_precision->addItem("double");
+    this->input_precision->addItem("single");
+    this->input_precision->addItem("single (validate)");
+    gridlayout->addWidget(new QLabel("precision"), row, 0);
+    gridlayout->addWidget(this->input_precision, row, 1);
+    gridlayout->addWidget(new QLabel("Floating point precision on the CPU; validation also runs in double precision and reports the deviation"), row, 2);
+    row++;
+
+    this->checkbox_temporal_blocking = new QCheckBox;
+    this->checkbox_temporal_blocking->setCheckState(Qt::Unchecked);
+    gridlayout->addWidget(new QLabel("temporal blocking"), row, 0);
+    gridlayout->addWidget(this->checkbox_temporal_blocking, row, 1);
+    gridlayout->addWidget(new QLabel("Advance the grid through several time steps per sweep (CPU, for grids larger than the cache)"), row, 2);
+    row++;
+
+    this->checkbox_adaptive_mesh = new QCheckBox;
+    this->checkbox_adaptive_mesh->setCheckState(Qt::Unchecked);
+    gridlayout->addWidget(new QLabel("adaptive mesh"), row, 0);
+    gridlayout->addWidget(this->checkbox_adaptive_mesh, row, 1);
+    gridlayout->addWidget(new QLabel("Integrate nearly uniform regions on cells of twice the size (CPU, double precision)"), row, 2);
+    row++;
+
     gridlayout->addWidget(new QLabel("ncores"), row, 0);
     gridlayout->addWidget(this->input_ncores, row, 1);
     this->input_ncores->setMinimum(1);
@@ -320,6 +448,17 @@ void InputTab::build_general_parameters(QGridLayout *gridlayout) {
     label_cores_info->setToolTip("Too high numbers will actually slow down the calculation as the process becomes limited by inter-process communication.");
     gridlayout->addWidget(label_cores_info, row, 3);
     row++;
+
+    // order of the items follows THREAD_PINNING
+    this->input_pinning = new QComboBox();
+    this->input_pinning->addItem(get_thread_pinning_name(THREAD_PINNING::NONE));
+    this->input_pinning->addItem(get_thread_pinning_name(THREAD_PINNING::COMPACT));
+    this->input_pinning->addItem(get_thread_pinning_name(THREAD_PINNING::SCATTER));
+    this->input_pinning->addItem(get_thread_pinning_name(THREAD_PINNING::SOCKET));
+    gridlayout->addWidget(new QLabel("thread pinning"), row, 0);
+    gridlayout->addWidget(this->input_pinning, row, 1);
+    gridlayout->addWidget(new QLabel("Pin the OpenMP threads to consecutive (compact) or evenly spread (scatter) logical CPUs, or divide them over the NUMA nodes (socket)"), row, 2);
+    row++;
 }
 
 /**
@@ -509,10 +648,90 @@ void InputTab::action_enable_maze(int state) {
  *
  * @param[in]  state  The state
  */
-void InputTab::select_computer_device(int state) {
-    if(state == 0) {
-        this->input_ncores->setEnabled(true);
-    } else {
-        this->input_ncores->setEnabled(false);
+void InputTab::select_computer_device(int /* state */) {
+    this->update_cpu_options();
+}
+
+/**
+ * @brief      Select a time integrator
+ *
+ * @param[in]  state  The state
+ */
+void InputTab::select_integrator(int /* state */) {
+    this->update_cpu_options();
+}
+
+/**
+ * @brief      Select a stencil of the Laplacian
+ *
+ * @param[in]  state  The state
+ */
+void InputTab::select_stencil(int /* state */) {
+    this->update_cpu_options();
+}
+
+/**
+ * @brief      Toggle the adaptive mesh
+ *
+ * @param[in]  state  The state
+ */
+void InputTab::select_adaptive_mesh(int /* state */) {
+    this->update_cpu_options();
+}
+
+/**
+ * @brief      Change the size of the grid
+ *
+ * @param[in]  value  The width or height
+ */
+void InputTab::select_grid_size(int /* value */) {
+    this->update_cpu_options();
+}
+
+/**
+ * @brief      Enable the options that apply to the selected device and integrator
+ */
+void InputTab::update_cpu_options() {
+    const TIME_INTEGRATOR integrator = (TIME_INTEGRATOR)this->input_integrator->currentIndex();
+    const bool cpu = this->compute_device->currentIndex() == 0;
+    const bool euler = integrator == TIME_INTEGRATOR::EULER;
+    const bool adaptive = integrator == TIME_INTEGRATOR::ADAPTIVE_HEUN_EULER ||
+                          integrator == TIME_INTEGRATOR::ADAPTIVE_BOGACKI_SHAMPINE;
+    const bool spectral = integrator == TIME_INTEGRATOR::ETD1 ||
+                          integrator == TIME_INTEGRATOR::ETDRK2 ||
+                          integrator == TIME_INTEGRATOR::ETDRK4;
+
+    this->input_ncores->setEnabled(cpu);
+    this->input_pinning->setEnabled(cpu);
+    this->input_integrator->setEnabled(cpu);
+    // the blocks of the adaptive mesh need to tile the grid
+    const bool tiled = AdaptiveMesh::choose_block_size(this->input_width->value(), this->input_height->value()) > 0;
+    this->checkbox_adaptive_mesh->setEnabled(cpu && euler && tiled);
+    const bool amr = cpu && euler && tiled && this->checkbox_adaptive_mesh->isChecked();
+
+    // the adaptive mesh integrates the five-point stencil in double precision
+    if(amr) {
+        this->input_precision->setCurrentIndex(0);
+        this->input_stencil->setCurrentIndex((int)STENCIL::FIVE_POINT);
+    }
+    this->input_precision->setEnabled(cpu && euler && !amr);
+    this->checkbox_temporal_blocking->setEnabled(cpu && euler && !amr);
+    this->input_atol->setEnabled(cpu && adaptive);
+    this->input_rtol->setEnabled(cpu && adaptive);
+
+    // the implicit integrators only discretize the five-point stencil
+    const bool implicit = integrator == TIME_INTEGRATOR::ADI ||
+                          integrator == TIME_INTEGRATOR::MULTIGRID_BACKWARD_EULER ||
+                          integrator == TIME_INTEGRATOR::MULTIGRID_CRANK_NICOLSON;
+    if(!cpu || implicit) {
+        this->input_stencil->setCurrentIndex((int)STENCIL::FIVE_POINT);
+    }
+    this->input_stencil->setEnabled(cpu && !implicit && !amr);
+    const bool wide = (STENCIL)this->input_stencil->currentIndex() != STENCIL::FIVE_POINT;
+
+    // the spectral integrators, the higher-order stencils and the adaptive mesh cannot handle a maze
+    if(cpu && (spectral || wide || amr)) {
+        this->checkbox_enable_maze->setCheckState(Qt::Unchecked);
     }
+    this->checkbox_enable_maze->setEnabled(!cpu || !(spectral || wide || amr));
 }
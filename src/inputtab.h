@@ -57,6 +57,9 @@ class InputTab : public QWidget {
 private:
     QComboBox* reaction_selector;       // set reaction type
     QComboBox* compute_device;          // set reaction type
+    QComboBox* input_precision;         // set floating point precision of the CPU integration
+    QComboBox* input_integrator;        // set time integrator of the CPU integration
+    QComboBox* input_stencil;           // set stencil of the Laplacian of the CPU integration
 
     InputReaction* reaction_settings;   // widget that holds reaction settings
 
@@ -64,16 +67,23 @@ private:
     QDoubleSpinBox* input_diffusion_Y;  // set diffusion of component Y
     QDoubleSpinBox* input_dx;           // set distance interval
     QDoubleSpinBox* input_dt;           // set time interval
+    QDoubleSpinBox* input_atol;         // set absolute tolerance of the adaptive integrators
+    QDoubleSpinBox* input_steady;       // set rate of change below which the integration stops
+    QSpinBox* input_checkpoint;         // set number of frames between two checkpoints
+    QDoubleSpinBox* input_rtol;         // set relative tolerance of the adaptive integrators
 
     QSpinBox* input_width;              // set width of box
     QSpinBox* input_height;             // set height of box
     QSpinBox* input_steps;              // set number of integration steps
     QSpinBox* input_tsteps;             // set number of time steps for each integration step
     QSpinBox* input_ncores;             // set number of computing cores
+    QComboBox* input_pinning;           // set how threads are pinned to logical CPUs
 
     QGridLayout* gridlayout_reaction;
     QPushButton* button_submit;
     QCheckBox* checkbox_pbc;
+    QCheckBox* checkbox_temporal_blocking;
+    QCheckBox* checkbox_adaptive_mesh;
 
     QPushButton* button_maze_select;
     QLabel* label_maze_img;
@@ -101,7 +111,17 @@ public:
         return this->button_maze_select;
     }
 
-    TwoDimRD* build_reaction_system();
+    /**
+     * @brief      Build the reaction system from the input or resume it from a checkpoint
+     *
+     * Upon a resume, the physical problem is taken from the checkpoint and
+     * only the numerical settings from the input.
+     *
+     * @param[in]  checkpoint  The checkpoint to resume from; empty for a new run
+     *
+     * @return     The reaction system
+     */
+    TwoDimRD* build_reaction_system(const QString& checkpoint = QString());
 
     /**
      * @brief      Sets the maze.
@@ -156,6 +176,40 @@ private slots:
      * @param[in]  state  The state
      */
     void select_computer_device(int state);
+
+    /**
+     * @brief      Select a time integrator
+     *
+     * @param[in]  state  The state
+     */
+    void select_integrator(int state);
+
+    /**
+     * @brief      Select a stencil of the Laplacian
+     *
+     * @param[in]  state  The state
+     */
+    void select_stencil(int state);
+
+    /**
+     * @brief      Toggle the adaptive mesh
+     *
+     * @param[in]  state  The state
+     */
+    void select_adaptive_mesh(int state);
+
+    /**
+     * @brief      Change the size of the grid
+     *
+     * @param[in]  value  The width or height
+     */
+    void select_grid_size(int value);
+
+private:
+    /**
+     * @brief      Enable the options that apply to the selected device and integrator
+     */
+    void update_cpu_options();
 };
 
 #endif // INPUTTAB_H
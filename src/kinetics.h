@@ -0,0 +1,123 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "config.h"
+
+/*
+ * Inlineable CPU counterparts of the reaction kernels in kernels/. Every
+ * kinetic system is expressed in the generalized parameters c1-c4 as
+ * returned by ReactionSystem::get_kinetic_parameters(), such that the
+ * time integrators can be specialized at compile time on the kinetics.
+ */
+
+/**
+ * @brief      Generalized kinetic parameters
+ */
+template<typename T>
+struct KineticParameters {
+    T c1;
+    T c2;
+    T c3;
+    T c4;
+};
+
+/**
+ * @brief      Build generalized kinetic parameters
+ *
+ * @param[in]  c     Kinetic parameters as provided by the reaction system
+ *
+ * @return     The kinetic parameters
+ */
+template<typename T>
+inline KineticParameters<T> make_kinetic_parameters(const std::array<double, 4>& c) {
+    return {(T)c[0], (T)c[1], (T)c[2], (T)c[3]};
+}
+
+/**
+ * @brief      Lotka-Volterra kinetics (c1 = alpha, c2 = beta, c3 = gamma, c4 = delta)
+ */
+struct KineticsLotkaVolterra {
+    static constexpr KINETICS type = KINETICS::LOTKA_VOLTERRA;
+
+    template<typename T>
+    static inline void reaction(T a, T b, const KineticParameters<T>& p, T* ra, T* rb) {
+        *ra = p.c1 * a - p.c2 * a * b;
+        *rb = p.c4 * a * b - p.c3 * b;
+    }
+};
+
+/**
+ * @brief      Gray-Scott kinetics (c1 = f, c2 = k)
+ */
+struct KineticsGrayScott {
+    static constexpr KINETICS type = KINETICS::GRAY_SCOTT;
+
+    template<typename T>
+    static inline void reaction(T a, T b, const KineticParameters<T>& p, T* ra, T* rb) {
+        const T r = a * b * b;
+        *ra = -r + p.c1 * ((T)1.0 - a);
+        *rb =  r - (p.c1 + p.c2) * b;
+    }
+};
+
+/**
+ * @brief      Fitzhugh-Nagumo kinetics (c1 = alpha, c2 = beta)
+ */
+struct KineticsFitzhughNagumo {
+    static constexpr KINETICS type = KINETICS::FITZHUGH_NAGUMO;
+
+    template<typename T>
+    static inline void reaction(T a, T b, const KineticParameters<T>& p, T* ra, T* rb) {
+        *ra = a - (a * a * a) - b + p.c1;
+        *rb = (a - b) * p.c2;
+    }
+};
+
+/**
+ * @brief      Brusselator kinetics (c1 = alpha, c2 = beta)
+ */
+struct KineticsBrusselator {
+    static constexpr KINETICS type = KINETICS::BRUSSELATOR;
+
+    template<typename T>
+    static inline void reaction(T a, T b, const KineticParameters<T>& p, T* ra, T* rb) {
+        *ra = p.c1 - (p.c2 + (T)1.0) * a + (a * a * b);
+        *rb = (p.c2 * a) - (a * a * b);
+    }
+};
+
+/**
+ * @brief      Barkley kinetics (c1 = alpha, c2 = beta, c3 = epsilon)
+ */
+struct KineticsBarkley {
+    static constexpr KINETICS type = KINETICS::BARKLEY;
+
+    template<typename T>
+    static inline void reaction(T a, T b, const KineticParameters<T>& p, T* ra, T* rb) {
+        *ra = p.c3 * a * ((T)1.0 - a) * (a - (b + p.c2) / p.c1);
+        *rb = a * a * a - b;
+    }
+};
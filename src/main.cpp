@@ -20,11 +20,83 @@
  **************************************************************************/
 
 #include "mainwindow.h"
+#include "distributed.h"
+#include "batch.h"
 #include <QApplication>
 #include <QIcon>
 
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/**
+ * @brief      Resume a run from a checkpoint without a GUI
+ *
+ * Invoked as "lafluxxy --resume <checkpoint> [interval]". The run continues
+ * until its last frame, writing checkpoints to the same file every interval
+ * frames (10 by default) and at the end.
+ *
+ * @param[in]  argc  The count of arguments
+ * @param      argv  The arguments array
+ *
+ * @return     Exit code
+ */
+static int resume_main(int argc, char *argv[]) {
+    try {
+        const std::string filename = argv[2];
+        const unsigned int interval = argc > 3 ? std::stoul(argv[3]) : 10;
+
+        auto system = TwoDimRD::from_checkpoint(filename);
+        system->set_cores(std::max(1u, std::thread::hardware_concurrency()));
+        system->set_checkpoint(filename, interval);
+        system->resume();
+
+        std::cout << "Resuming " << filename << " at frame " << system->get_frame_offset()
+                  << ", " << system->get_num_steps() << " frames remaining" << std::endl;
+        system->time_integrate();
+        system->clean();
+
+        if(!system->get_checkpoint_error().empty()) {
+            std::cerr << system->get_checkpoint_error() << std::endl;
+            return 1;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
+    // the other ranks of a distributed integration run without a GUI
+    if(DistributedRD::is_worker(argc, argv)) {
+        return DistributedRD::worker_main(argc, argv);
+    }
+
+    if(argc >= 3 && std::strcmp(argv[1], "--resume") == 0) {
+        return resume_main(argc, argv);
+    }
+
+    if(argc >= 2 && std::strcmp(argv[1], "--ensemble") == 0) {
+        return ensemble_main(argc, argv);
+    }
+
+    if(argc >= 2 && std::strcmp(argv[1], "--sweep") == 0) {
+        return sweep_main(argc, argv);
+    }
+
+    if(argc >= 2 && std::strcmp(argv[1], "--distributed") == 0) {
+        return distributed_main(argc, argv);
+    }
+
+    if(argc >= 2 && std::strcmp(argv[1], "--three-dim") == 0) {
+        return three_dim_main(argc, argv);
+    }
+
     QApplication a(argc, argv);
     QGuiApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 
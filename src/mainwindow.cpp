@@ -114,6 +114,33 @@ void MainWindow::acknowledgements() {
  * @brief      Launch the simulation
  */
 void MainWindow::launch_calculation() {
+    this->start_calculation(QString());
+}
+
+/**
+ * @brief      Resume an RD simulation from a checkpoint
+ */
+void MainWindow::resume_calculation() {
+    // a running simulation has to be stopped first
+    if(!this->input_tab->get_button_submit()->isEnabled()) {
+        return;
+    }
+
+    const QString filename = QFileDialog::getOpenFileName(this, tr("Resume from checkpoint"), "",
+                                                          tr("Checkpoints (*.ckpt);;All files (*)"));
+    if(filename.isEmpty()) {
+        return;
+    }
+
+    this->start_calculation(filename);
+}
+
+/**
+ * @brief      Start a new simulation or resume one from a checkpoint
+ *
+ * @param[in]  checkpoint  The checkpoint to resume from; empty for a new run
+ */
+void MainWindow::start_calculation(const QString& checkpoint) {
     if(this->results_tab->get_num_frames() > 0) {
         QMessageBox msgBox;
         msgBox.setText(tr("<b>Warning</b>: This action will delete all previous simulation results!"));
@@ -128,8 +155,18 @@ void MainWindow::launch_calculation() {
         }
     }
 
+    std::unique_ptr<TwoDimRD> system;
+    try {
+        system = std::unique_ptr<TwoDimRD>(this->input_tab->build_reaction_system(checkpoint));
+    } catch(const std::exception& e) {
+        // an invalid setup or unreadable checkpoint leaves the previous results in place
+        QMessageBox::critical(this, checkpoint.isEmpty() ? tr("Launch calculation") : tr("Resume from checkpoint"),
+                              QString::fromStdString(e.what()));
+        return;
+    }
+
     this->results_tab->clear();
-    this->tdrd = std::unique_ptr<TwoDimRD>(this->input_tab->build_reaction_system());
+    this->tdrd = std::move(system);
     this->results_tab->set_reaction_system(this->tdrd.get());
 
     this->input_tab->get_button_submit()->setEnabled(false);
@@ -142,13 +179,24 @@ void MainWindow::launch_calculation() {
     WorkerThread *workerThread = new WorkerThread(this->tdrd.get());
     connect(workerThread, &WorkerThread::simulation_finished, this, &MainWindow::handle_simulation_finished);
     connect(workerThread, &WorkerThread::simulation_cancelled, this, &MainWindow::handle_simulation_canceled);
+    connect(workerThread, &WorkerThread::simulation_converged, this, &MainWindow::handle_simulation_converged);
+    connect(workerThread, &WorkerThread::simulation_failed, this, &MainWindow::handle_simulation_failed);
     connect(workerThread, &WorkerThread::step_finished, this, &MainWindow::handle_results_step);
     connect(workerThread, &WorkerThread::finished, workerThread, &QObject::deleteLater);
     connect(this->results_tab->get_stop_button(), SIGNAL(clicked()), workerThread, SLOT(kill_job()));
     workerThread->start();
 
     this->tabs->setCurrentIndex(this->tabs->indexOf(this->results_tab));
-    statusBar()->showMessage(tr("Simulation running..."));
+    if(this->tdrd->get_blocking_speedup() > 0.0) {
+        statusBar()->showMessage(tr("Simulation running... (temporal blocking speedup: ") +
+                                 QString::number(this->tdrd->get_blocking_speedup(), 'f', 2) +
+                                 (this->tdrd->get_blocking_speedup() > 1.0 ? tr("x)") : tr("x; using the plain path)")));
+    } else if(this->tdrd->get_frame_offset() > 0) {
+        statusBar()->showMessage(tr("Simulation resumed at frame ") +
+                                 QString::number(this->tdrd->get_frame_offset()) + tr("..."));
+    } else {
+        statusBar()->showMessage(tr("Simulation running..."));
+    }
 }
 
 /**
@@ -157,6 +205,43 @@ void MainWindow::launch_calculation() {
 void MainWindow::handle_simulation_finished() {
     this->input_tab->get_button_submit()->setEnabled(true);
     this->results_tab->get_stop_button()->setEnabled(false);
+    this->report_checkpoint_error();
+
+    // report the deviation of a validated single-precision run at the last frame
+    const auto& deviations = this->tdrd->get_precision_deviations();
+    if(!deviations.empty()) {
+        statusBar()->showMessage(tr("Simulation complete. Deviation from double precision: max ") +
+                                 QString::number(deviations.back().max_abs, 'e', 3) +
+                                 tr(", relative L2 ") +
+                                 QString::number(deviations.back().rel_l2, 'e', 3) + tr("."));
+        return;
+    }
+
+    // report the number of adaptive time steps over all frames
+    const auto& stats = this->tdrd->get_step_statistics();
+    if(!stats.empty()) {
+        unsigned int accepted = 0;
+        unsigned int rejected = 0;
+        for(const auto& s : stats) {
+            accepted += s.accepted;
+            rejected += s.rejected;
+        }
+        statusBar()->showMessage(tr("Simulation complete. Adaptive time steps: ") +
+                                 QString::number(accepted) + tr(" accepted, ") +
+                                 QString::number(rejected) + tr(" rejected."));
+        return;
+    }
+
+    // report the stage count of super-time-stepping
+    const unsigned int stages = this->tdrd->get_sts_stages();
+    if(stages > 0) {
+        statusBar()->showMessage(tr("Simulation complete. RKL2 super-time-stepping: ") +
+                                 QString::number(stages) + tr(" stages per step, speedup ") +
+                                 QString::number(this->tdrd->get_sts_speedup(), 'f', 1) +
+                                 tr(" over explicit Euler."));
+        return;
+    }
+
     statusBar()->showMessage(tr("Simulation complete."));
 }
 
@@ -167,6 +252,48 @@ void MainWindow::handle_simulation_canceled() {
     this->input_tab->get_button_submit()->setEnabled(true);
     this->results_tab->get_stop_button()->setEnabled(false);
     statusBar()->showMessage(tr("Simulation canceled."));
+    this->report_checkpoint_error();
+}
+
+/**
+ * @brief      Handle results when the simulation has reached a steady state
+ *
+ * @param[in]  i     Number of frames that have been integrated
+ */
+void MainWindow::handle_simulation_converged(unsigned int i) {
+    this->input_tab->get_button_submit()->setEnabled(true);
+    this->results_tab->get_stop_button()->setEnabled(false);
+
+    const auto& norms = this->tdrd->get_update_norms();
+    statusBar()->showMessage(tr("Steady state reached at frame ") + QString::number(i) +
+                             tr(" of ") + QString::number(this->tdrd->get_num_steps()) +
+                             tr(" (rate of change: max ") +
+                             QString::number(norms.back().max_abs, 'e', 3) +
+                             tr(", RMS ") + QString::number(norms.back().rms, 'e', 3) +
+                             tr("); the remaining frames were skipped."));
+    this->report_checkpoint_error();
+}
+
+/**
+ * @brief      Handle a simulation that was aborted by an error
+ *
+ * @param[in]  message  Description of the error
+ */
+void MainWindow::handle_simulation_failed(const QString& message) {
+    this->input_tab->get_button_submit()->setEnabled(true);
+    this->results_tab->get_stop_button()->setEnabled(false);
+    statusBar()->showMessage(tr("Simulation aborted."));
+    QMessageBox::critical(this, tr("Simulation aborted"), message);
+}
+
+/**
+ * @brief      Warn when a checkpoint of the finished simulation could not be written
+ */
+void MainWindow::report_checkpoint_error() {
+    const std::string& error = this->tdrd->get_checkpoint_error();
+    if(!error.empty()) {
+        QMessageBox::warning(this, tr("Write checkpoint"), QString::fromStdString(error));
+    }
 }
 
 /**
@@ -214,6 +341,7 @@ void MainWindow::build_menu() {
     // build menu bar items
     QAction *action_open = new QAction(menuFile);
     QAction *action_save = new QAction(menuFile);
+    QAction *action_resume = new QAction(menuFile);
     QAction *action_quit = new QAction(menuFile);
     QAction *action_about = new QAction(menuHelp);
     QAction *action_acknowledgements = new QAction(menuHelp);
@@ -225,6 +353,8 @@ void MainWindow::build_menu() {
     action_save->setText(tr("Save"));
     action_save->setShortcuts(QKeySequence::Save);
 
+    action_resume->setText(tr("Resume from checkpoint..."));
+
     action_quit->setText(tr("Quit"));
     action_quit->setShortcuts(QKeySequence::Quit);
 
@@ -235,12 +365,15 @@ void MainWindow::build_menu() {
     // add options to menu
     // menuFile->addAction(action_open);
     // menuFile->addAction(action_save);
+    menuFile->addAction(action_resume);
+    menuFile->addSeparator();
     menuFile->addAction(action_quit);
     menuHelp->addAction(action_acknowledgements);
     menuHelp->addSeparator();
     menuHelp->addAction(action_about);
 
     // connect actions
+    connect(action_resume, &QAction::triggered, this, &MainWindow::resume_calculation);
     connect(action_quit, &QAction::triggered, this, &MainWindow::exit);
     connect(action_about, &QAction::triggered, this, &MainWindow::about);
     connect(action_acknowledgements, &QAction::triggered, this, &MainWindow::acknowledgements);
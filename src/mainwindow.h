@@ -30,6 +30,7 @@
 #include <QTabWidget>
 #include <QMenuBar>
 #include <QMenu>
+#include <QFileDialog>
 
 #include <iostream>
 #include <thread>
@@ -92,6 +93,11 @@ private slots:
      */
     void launch_calculation();
 
+    /**
+     * @brief      Resume an RD simulation from a checkpoint
+     */
+    void resume_calculation();
+
     /**
      * @brief      Handle results when the simulation is finished
      */
@@ -102,6 +108,20 @@ private slots:
      */
     void handle_simulation_canceled();
 
+    /**
+     * @brief      Handle results when the simulation has reached a steady state
+     *
+     * @param[in]  i     Number of frames that have been integrated
+     */
+    void handle_simulation_converged(unsigned int i);
+
+    /**
+     * @brief      Handle a simulation that was aborted by an error
+     *
+     * @param[in]  message  Description of the error
+     */
+    void handle_simulation_failed(const QString& message);
+
     /**
      * @brief      Handle the results of a single frame
      *
@@ -135,6 +155,18 @@ private:
      * @brief      Build the drop-down menus
      */
     void build_menu();
+
+    /**
+     * @brief      Start a new simulation or resume one from a checkpoint
+     *
+     * @param[in]  checkpoint  The checkpoint to resume from; empty for a new run
+     */
+    void start_calculation(const QString& checkpoint);
+
+    /**
+     * @brief      Warn when a checkpoint of the finished simulation could not be written
+     */
+    void report_checkpoint_error();
 };
 
 #endif // MAINWINDOW_H
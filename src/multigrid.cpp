@@ -0,0 +1,558 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "multigrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _width   width of the system
+ * @param[in]  _height  height of the system
+ * @param[in]  dx       size of the space interval
+ * @param[in]  _dt      size of the time interval
+ * @param[in]  Da       Diffusion coefficient of compound A
+ * @param[in]  Db       Diffusion coefficient of compound B
+ * @param[in]  _pbc     Whether to employ periodic boundary conditions
+ * @param[in]  mask     Mask with walls set to one, or nullptr
+ * @param[in]  _theta   1 for backward Euler, 1/2 for Crank-Nicolson
+ */
+MultigridIntegrator::MultigridIntegrator(unsigned int _width, unsigned int _height,
+                                         double dx, double _dt, double Da, double Db,
+                                         bool _pbc, const MatrixXXi* mask, double _theta) :
+    width(_width),
+    height(_height),
+    dt(_dt),
+    theta(_theta),
+    // walls already close the domain, hence masked domains are never periodic
+    pbc(_pbc && mask == nullptr) {
+
+    this->D[0] = Da;
+    this->D[1] = Db;
+
+    // finest level: unit mass in the fluid and 1/dx^2 between adjacent fluid cells
+    Level fine;
+    fine.width = this->width;
+    fine.height = this->height;
+    fine.m = MatrixXXd::Zero(this->height, this->width);
+    fine.we = MatrixXXd::Zero(this->height, this->width);
+    fine.ws = MatrixXXd::Zero(this->height, this->width);
+
+    const auto fluid = [mask](int i, int j) {
+        return mask == nullptr || (*mask)(i,j) != 1;
+    };
+
+    const double idx2 = 1.0 / (dx * dx);
+    for(int i=0; i<(int)this->height; i++) {
+        for(int j=0; j<(int)this->width; j++) {
+            if(!fluid(i,j)) {
+                continue;
+            }
+            fine.m(i,j) = 1.0;
+            const int je = this->next(j, this->width);
+            const int is = this->next(i, this->height);
+            if(je >= 0 && fluid(i,je)) {
+                fine.we(i,j) = idx2;
+            }
+            if(is >= 0 && fluid(is,j)) {
+                fine.ws(i,j) = idx2;
+            }
+        }
+    }
+    this->finalize_level(fine);
+    this->levels.push_back(std::move(fine));
+
+    // coarsen until the grid is small enough to be solved by smoothing alone
+    while(this->levels.back().width > 4 || this->levels.back().height > 4) {
+        Level coarse = this->coarsen(this->levels.back());
+        this->finalize_level(coarse);
+        this->build_transfer(this->levels.back(), coarse);
+        this->levels.push_back(std::move(coarse));
+    }
+
+    for(auto& lv : this->levels) {
+        lv.u = MatrixXXd::Zero(lv.height, lv.width);
+        lv.f = MatrixXXd::Zero(lv.height, lv.width);
+        lv.r = MatrixXXd::Zero(lv.height, lv.width);
+    }
+
+    this->ra = MatrixXXd::Zero(this->height, this->width);
+    this->rb = MatrixXXd::Zero(this->height, this->width);
+    this->rhs = MatrixXXd::Zero(this->height, this->width);
+    this->res = MatrixXXd::Zero(this->height, this->width);
+    this->dir = MatrixXXd::Zero(this->height, this->width);
+    this->adir = MatrixXXd::Zero(this->height, this->width);
+}
+
+/**
+ * @brief      Advance the concentrations by a number of time steps
+ *
+ * @param      a         Concentration of A
+ * @param      b         Concentration of B
+ * @param[in]  nsteps    Number of time steps
+ * @param[in]  reaction  Function that evaluates the reaction terms
+ * @param[in]  ncores    Number of threads
+ */
+void MultigridIntegrator::advance(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps,
+                                  const ReactionTerms& reaction, unsigned int ncores) {
+    omp_set_num_threads(ncores);
+
+    MatrixXXd* u[2] = {&a, &b};
+    const MatrixXXd* R[2] = {&this->ra, &this->rb};
+    const Level& fine = this->levels[0];
+
+    this->cycles = 0;
+    for(unsigned int j=0; j<nsteps; j++) {
+        reaction(a.data(), b.data(), this->ra.data(), this->rb.data());
+        for(unsigned int s=0; s<2; s++) {
+            // explicit part of the diffusion and the reaction terms; zero at the walls
+            this->apply(fine, -(1.0 - this->theta) * this->dt * this->D[s], *u[s], this->rhs);
+            this->rhs += this->dt * fine.m.cwiseProduct(*R[s]);
+
+            this->solve(this->theta * this->dt * this->D[s], *u[s]);
+        }
+    }
+}
+
+/**
+ * @brief      Derive the conductances of the previous faces and the neighbour indices of a level
+ *
+ * @param      lv    The level
+ */
+void MultigridIntegrator::finalize_level(Level& lv) const {
+    const int w = lv.width;
+    const int h = lv.height;
+
+    lv.iprev.resize(h);
+    lv.inext.resize(h);
+    lv.jprev.resize(w);
+    lv.jnext.resize(w);
+    for(int i=0; i<h; i++) {
+        lv.iprev[i] = this->prev(i, h) >= 0 ? this->prev(i, h) : i;
+        lv.inext[i] = this->next(i, h) >= 0 ? this->next(i, h) : i;
+    }
+    for(int j=0; j<w; j++) {
+        lv.jprev[j] = this->prev(j, w) >= 0 ? this->prev(j, w) : j;
+        lv.jnext[j] = this->next(j, w) >= 0 ? this->next(j, w) : j;
+    }
+
+    lv.ww = MatrixXXd::Zero(h, w);
+    lv.wn = MatrixXXd::Zero(h, w);
+    for(int i=0; i<h; i++) {
+        for(int j=0; j<w; j++) {
+            if(this->prev(j, w) >= 0) {
+                lv.ww(i,j) = lv.we(i, lv.jprev[j]);
+            }
+            if(this->prev(i, h) >= 0) {
+                lv.wn(i,j) = lv.ws(lv.iprev[i], j);
+            }
+        }
+    }
+    lv.wsum = lv.we + lv.ws + lv.ww + lv.wn;
+}
+
+/**
+ * @brief      Build a coarse level from the next finer level
+ *
+ * A coarse cell aggregates up to 2x2 fine cells. Its mass is the average
+ * over its children and the conductance of a face is half of the sum over
+ * the fine faces that cross it, which reproduces the five-point stencil
+ * with twice the spacing on an unmasked grid.
+ *
+ * @param[in]  fine  The fine level
+ *
+ * @return     The coarse level
+ */
+MultigridIntegrator::Level MultigridIntegrator::coarsen(const Level& fine) const {
+    Level coarse;
+    coarse.width = (fine.width + 1) / 2;
+    coarse.height = (fine.height + 1) / 2;
+    coarse.m = MatrixXXd::Zero(coarse.height, coarse.width);
+    coarse.we = MatrixXXd::Zero(coarse.height, coarse.width);
+    coarse.ws = MatrixXXd::Zero(coarse.height, coarse.width);
+
+    for(unsigned int I=0; I<coarse.height; I++) {
+        const unsigned int i0 = 2 * I;
+        const unsigned int i1 = std::min(i0 + 1, fine.height - 1);
+        for(unsigned int J=0; J<coarse.width; J++) {
+            const unsigned int j0 = 2 * J;
+            const unsigned int j1 = std::min(j0 + 1, fine.width - 1);
+
+            double m = 0.0;
+            for(unsigned int i=i0; i<=i1; i++) {
+                for(unsigned int j=j0; j<=j1; j++) {
+                    m += fine.m(i,j);
+                }
+            }
+            coarse.m(I,J) = 0.25 * m;
+
+            // the faces of the last fine column and row of the aggregate cross to the next coarse cell
+            double we = 0.0;
+            for(unsigned int i=i0; i<=i1; i++) {
+                we += fine.we(i,j1);
+            }
+            double ws = 0.0;
+            for(unsigned int j=j0; j<=j1; j++) {
+                ws += fine.ws(i1,j);
+            }
+            coarse.we(I,J) = 0.125 * we;
+            coarse.ws(I,J) = 0.125 * ws;
+        }
+    }
+
+    return coarse;
+}
+
+/**
+ * @brief      Solve A u = rhs on the finest level
+ *
+ * @param[in]  c     theta * dt * D
+ * @param      u     Initial guess; receives the solution
+ */
+void MultigridIntegrator::solve(double c, MatrixXXd& u) {
+    Level& fine = this->levels[0];
+
+    const double fnorm = this->rhs.cwiseAbs().maxCoeff();
+    if(fnorm == 0.0) {
+        u.setZero();
+        return;
+    }
+
+    this->apply(fine, c, u, this->res);
+    this->res = this->rhs - this->res;
+    if(this->res.cwiseAbs().maxCoeff() <= TOLERANCE * fnorm) {
+        return;
+    }
+
+    this->precondition(c);
+    this->dir = fine.u;
+    double rz = this->res.cwiseProduct(fine.u).sum();
+
+    for(unsigned int k=0; k<MAXCYCLES; k++) {
+        this->apply(fine, c, this->dir, this->adir);
+        const double alpha = rz / this->dir.cwiseProduct(this->adir).sum();
+        u += alpha * this->dir;
+        this->res -= alpha * this->adir;
+
+        if(this->res.cwiseAbs().maxCoeff() <= TOLERANCE * fnorm) {
+            break;
+        }
+
+        this->precondition(c);
+        const double rznew = this->res.cwiseProduct(fine.u).sum();
+        this->dir = fine.u + (rznew / rz) * this->dir;
+        rz = rznew;
+    }
+}
+
+/**
+ * @brief      Apply the V-cycle preconditioner to the residual
+ *
+ * The result is stored in the correction of the finest level.
+ *
+ * @param[in]  c     theta * dt * D
+ */
+void MultigridIntegrator::precondition(double c) {
+    Level& fine = this->levels[0];
+    fine.f = this->res;
+    fine.u.setZero();
+    this->vcycle(0, c);
+    this->cycles++;
+}
+
+/**
+ * @brief      Perform a V-cycle for the correction of a level
+ *
+ * The sweeps after the coarse-grid correction visit the cells in the
+ * reverse order of those before it, such that the cycle is symmetric.
+ *
+ * @param[in]  l     Index of the level
+ * @param[in]  c     theta * dt * D
+ */
+void MultigridIntegrator::vcycle(unsigned int l, double c) {
+    Level& lv = this->levels[l];
+
+    if(l + 1 == this->levels.size()) {
+        this->smooth(lv, c, NCOARSESMOOTH / 2, false);
+        this->smooth(lv, c, NCOARSESMOOTH / 2, true);
+        return;
+    }
+
+    Level& coarse = this->levels[l+1];
+
+    this->smooth(lv, c, NPRESMOOTH, false);
+    this->residual(lv, c);
+    this->restrict_residual(lv, coarse);
+    coarse.u.setZero();
+    this->vcycle(l + 1, c);
+    this->prolongate(coarse, lv);
+    this->smooth(lv, c, NPOSTSMOOTH, true);
+}
+
+/**
+ * @brief      Calculate out = m u + c sum_f w_f (u - u_f)
+ *
+ * @param[in]  lv    The level
+ * @param[in]  c     Scaling of the diffusion part
+ * @param[in]  u     The field
+ * @param      out   The result
+ */
+void MultigridIntegrator::apply(const Level& lv, double c, const MatrixXXd& u, MatrixXXd& out) const {
+    const int w = lv.width;
+    const int h = lv.height;
+
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<h; i++) {
+        const double* un = &u(lv.iprev[i], 0);
+        const double* uc = &u(i, 0);
+        const double* us = &u(lv.inext[i], 0);
+        for(int j=0; j<w; j++) {
+            const double flux = lv.wsum(i,j) * uc[j] -
+                                lv.we(i,j) * uc[lv.jnext[j]] - lv.ww(i,j) * uc[lv.jprev[j]] -
+                                lv.ws(i,j) * us[j] - lv.wn(i,j) * un[j];
+            out(i,j) = lv.m(i,j) * uc[j] + c * flux;
+        }
+    }
+}
+
+/**
+ * @brief      Calculate the residual f - A u of a level
+ *
+ * @param      lv    The level
+ * @param[in]  c     theta * dt * D
+ */
+void MultigridIntegrator::residual(Level& lv, double c) const {
+    this->apply(lv, c, lv.u, lv.r);
+    lv.r = lv.f - lv.r;
+}
+
+/**
+ * @brief      Perform red-black Gauss-Seidel sweeps on a level
+ *
+ * Cells are coloured by the parity of i + j. On a periodic grid with an odd
+ * width or height, the last column or row would neighbour cells of its own
+ * colour across the wrap; these are relaxed serially after both colours.
+ *
+ * @param      lv       The level
+ * @param[in]  c        theta * dt * D
+ * @param[in]  nsweeps  Number of sweeps
+ * @param[in]  reverse  Whether to visit the cells in reverse order
+ */
+void MultigridIntegrator::smooth(Level& lv, double c, unsigned int nsweeps, bool reverse) const {
+    const int w = lv.width;
+    const int h = lv.height;
+    const int wc = (this->pbc && (w % 2 == 1)) ? w - 1 : w;
+    const int hc = (this->pbc && (h % 2 == 1)) ? h - 1 : h;
+
+    const auto sweep_colour = [&](int colour) {
+        #pragma omp parallel for schedule(static)
+        for(int i=0; i<hc; i++) {
+            for(int j=(i + colour) % 2; j<wc; j+=2) {
+                this->relax(lv, c, i, j);
+            }
+        }
+    };
+
+    for(unsigned int k=0; k<nsweeps; k++) {
+        if(!reverse) {
+            sweep_colour(0);
+            sweep_colour(1);
+            for(int i=0; i<hc && wc < w; i++) {
+                this->relax(lv, c, i, w-1);
+            }
+            for(int j=0; j<w && hc < h; j++) {
+                this->relax(lv, c, h-1, j);
+            }
+        } else {
+            for(int j=w-1; j>=0 && hc < h; j--) {
+                this->relax(lv, c, h-1, j);
+            }
+            for(int i=hc-1; i>=0 && wc < w; i--) {
+                this->relax(lv, c, i, w-1);
+            }
+            sweep_colour(1);
+            sweep_colour(0);
+        }
+    }
+}
+
+/**
+ * @brief      Get the coarse cells and weights that a fine cell interpolates from
+ *
+ * A fluid fine cell interpolates bilinearly from its parent and the three
+ * coarse cells nearest to it. A coarse neighbour only contributes if it is
+ * connected to the parent by a conducting face (or a path of two such faces
+ * for the diagonal one); the weights are renormalized over the contributing
+ * cells.
+ *
+ * @param[in]  coarse  The coarse level
+ * @param[in]  i       Row of the fine cell
+ * @param[in]  j       Column of the fine cell
+ * @param      idx     Row and column of up to four coarse cells
+ * @param      wts     Weights of the coarse cells
+ *
+ * @return     The number of coarse cells
+ */
+unsigned int MultigridIntegrator::interpolation(const Level& coarse, int i, int j, int idx[4][2], double wts[4]) const {
+    const int I = i / 2;
+    const int J = j / 2;
+    const bool south = (i % 2 == 1);
+    const bool east = (j % 2 == 1);
+    const int In = south ? this->next(I, coarse.height) : this->prev(I, coarse.height);
+    const int Jn = east ? this->next(J, coarse.width) : this->prev(J, coarse.width);
+    const bool hasi = In >= 0 && In != I;
+    const bool hasj = Jn >= 0 && Jn != J;
+
+    // conductance between horizontally or vertically adjacent coarse cells
+    const auto cx = [&](int row) {
+        return hasj && (east ? coarse.we(row,J) : coarse.ww(row,J)) > 0.0;
+    };
+    const auto cy = [&](int col) {
+        return hasi && (south ? coarse.ws(I,col) : coarse.wn(I,col)) > 0.0;
+    };
+
+    unsigned int n = 0;
+    double wsum = 0.0;
+    const auto add = [&](int row, int col, double wt) {
+        idx[n][0] = row;
+        idx[n][1] = col;
+        wts[n] = wt;
+        wsum += wt;
+        n++;
+    };
+
+    add(I, J, 9.0);
+    const bool hx = cx(I);
+    const bool hy = cy(J);
+    if(hx) {
+        add(I, Jn, 3.0);
+    }
+    if(hy) {
+        add(In, J, 3.0);
+    }
+    if((hx && cy(Jn)) || (hy && cx(In))) {
+        add(In, Jn, 1.0);
+    }
+
+    for(unsigned int k=0; k<n; k++) {
+        wts[k] /= wsum;
+    }
+
+    return n;
+}
+
+/**
+ * @brief      Tabulate the transfer operators between a level and the next coarser level
+ *
+ * The restriction is the transpose of the prolongation, scaled by 1/4,
+ * which keeps the preconditioner symmetric.
+ *
+ * @param      fine    The fine level
+ * @param[in]  coarse  The coarse level
+ */
+void MultigridIntegrator::build_transfer(Level& fine, const Level& coarse) const {
+    const size_t nfine = (size_t)fine.width * fine.height;
+    const size_t ncoarse = (size_t)coarse.width * coarse.height;
+
+    fine.pidx.assign(4 * nfine, 0);
+    fine.pwts.assign(4 * nfine, 0.0);
+
+    std::vector<int> count(ncoarse + 1, 0);
+    int idx[4][2];
+    double wts[4];
+    for(unsigned int i=0; i<fine.height; i++) {
+        for(unsigned int j=0; j<fine.width; j++) {
+            if(fine.m(i,j) == 0.0) {
+                continue;
+            }
+            const size_t k = (size_t)i * fine.width + j;
+            const unsigned int n = this->interpolation(coarse, i, j, idx, wts);
+            for(unsigned int l=0; l<n; l++) {
+                const int c = idx[l][0] * coarse.width + idx[l][1];
+                fine.pidx[4*k+l] = c;
+                fine.pwts[4*k+l] = wts[l];
+                count[c+1]++;
+            }
+        }
+    }
+
+    // transpose the interpolation into lists of fine cells per coarse cell
+    fine.rstart.assign(ncoarse + 1, 0);
+    for(size_t c=0; c<ncoarse; c++) {
+        fine.rstart[c+1] = fine.rstart[c] + count[c+1];
+    }
+    fine.ridx.resize(fine.rstart[ncoarse]);
+    fine.rwts.resize(fine.rstart[ncoarse]);
+    std::vector<int> pos(fine.rstart.begin(), fine.rstart.end() - 1);
+    for(size_t k=0; k<nfine; k++) {
+        for(unsigned int l=0; l<4; l++) {
+            if(fine.pwts[4*k+l] != 0.0) {
+                const int c = fine.pidx[4*k+l];
+                fine.ridx[pos[c]] = k;
+                fine.rwts[pos[c]] = 0.25 * fine.pwts[4*k+l];
+                pos[c]++;
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Restrict the residual of a level to the right-hand side of the next level
+ *
+ * @param[in]  fine    The fine level
+ * @param      coarse  The coarse level
+ */
+void MultigridIntegrator::restrict_residual(const Level& fine, Level& coarse) const {
+    const int ncoarse = coarse.width * coarse.height;
+    const double* r = fine.r.data();
+    double* f = coarse.f.data();
+
+    #pragma omp parallel for schedule(static)
+    for(int c=0; c<ncoarse; c++) {
+        double sum = 0.0;
+        for(int l=fine.rstart[c]; l<fine.rstart[c+1]; l++) {
+            sum += fine.rwts[l] * r[fine.ridx[l]];
+        }
+        f[c] = sum;
+    }
+}
+
+/**
+ * @brief      Add the prolongated correction of a level to the next finer level
+ *
+ * @param[in]  coarse  The coarse level
+ * @param      fine    The fine level
+ */
+void MultigridIntegrator::prolongate(const Level& coarse, Level& fine) const {
+    const int nfine = fine.width * fine.height;
+    const double* uc = coarse.u.data();
+    double* u = fine.u.data();
+
+    #pragma omp parallel for schedule(static)
+    for(int k=0; k<nfine; k++) {
+        u[k] += fine.pwts[4*k] * uc[fine.pidx[4*k]] + fine.pwts[4*k+1] * uc[fine.pidx[4*k+1]] +
+                fine.pwts[4*k+2] * uc[fine.pidx[4*k+2]] + fine.pwts[4*k+3] * uc[fine.pidx[4*k+3]];
+    }
+}
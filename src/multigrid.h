@@ -0,0 +1,295 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+
+#include "matrices.h"
+#include "spectral.h"
+
+/**
+ * @brief      Implicit-explicit integrator that solves the diffusion step by geometric multigrid
+ *
+ * Every time step solves (1 - theta dt D L) u' = (1 + (1 - theta) dt D L) u + dt R(u)
+ * per species, with theta = 1 (backward Euler) or theta = 1/2
+ * (Crank-Nicolson) and explicit reaction terms R. L is the five-point
+ * Laplacian with no-flux walls, which is applied matrix-free from the
+ * conductances of the cell faces.
+ *
+ * The systems are solved by conjugate gradients, preconditioned by a
+ * symmetric V-cycle with red-black Gauss-Seidel smoothing. A coarse cell
+ * aggregates 2x2 fine cells and is fluid if any of them is; its faces
+ * conduct as much as the fine faces that cross them, such that walls and
+ * narrow channels of a maze survive the coarsening. Corrections are
+ * prolongated bilinearly from the coarse neighbours that are connected to
+ * the parent cell, such that no correction leaks through a wall, and
+ * residuals are restricted with the transpose of the prolongation. Coarse
+ * levels cannot resolve every wall of a fine maze, which makes the plain
+ * V-cycle slow to converge there; the Krylov acceleration restores
+ * convergence in a few iterations.
+ */
+class MultigridIntegrator {
+private:
+    /**
+     * @brief      Grid of one level of the hierarchy
+     *
+     * The operator reads (A u)_i = m_i u_i + c sum_f w_f (u_i - u_f) over the
+     * four faces f of cell i, where c = theta dt D. Walls have m = 0 and no
+     * conducting faces, and are left untouched. Neighbour indices at a
+     * closed edge point at the cell itself; their faces do not conduct.
+     */
+    struct Level {
+        unsigned int width = 0;     //!< width of the grid
+        unsigned int height = 0;    //!< height of the grid
+        MatrixXXd u;                //!< correction
+        MatrixXXd f;                //!< right-hand side
+        MatrixXXd r;                //!< residual
+        MatrixXXd m;                //!< fluid fraction of every cell
+        MatrixXXd we;               //!< conductance of the face to the next column
+        MatrixXXd ws;               //!< conductance of the face to the next row
+        MatrixXXd ww;               //!< conductance of the face to the previous column
+        MatrixXXd wn;               //!< conductance of the face to the previous row
+        MatrixXXd wsum;             //!< total conductance of the faces of every cell
+        std::vector<int> iprev;     //!< index of the previous row
+        std::vector<int> inext;     //!< index of the next row
+        std::vector<int> jprev;     //!< index of the previous column
+        std::vector<int> jnext;     //!< index of the next column
+
+        std::vector<int> pidx;      //!< four coarse cells that every cell interpolates from
+        std::vector<double> pwts;   //!< weights of the coarse cells; zero for unused entries
+        std::vector<int> rstart;    //!< start of the fine cells that restrict to every coarse cell
+        std::vector<int> ridx;      //!< fine cells that restrict to a coarse cell
+        std::vector<double> rwts;   //!< weights of the fine cells
+    };
+
+    unsigned int width;     //!< width of the system
+    unsigned int height;    //!< height of the system
+    double dt;              //!< size of the time interval
+    double theta;           //!< implicitness of the diffusion step
+    double D[2];            //!< diffusion coefficients of A and B
+    bool pbc;               //!< whether the faces wrap around the domain
+
+    std::vector<Level> levels;  //!< grid hierarchy, finest first
+
+    MatrixXXd ra;           //!< reaction terms of A
+    MatrixXXd rb;           //!< reaction terms of B
+    MatrixXXd rhs;          //!< right-hand side of the implicit step
+    MatrixXXd res;          //!< residual of the conjugate gradients
+    MatrixXXd dir;          //!< search direction of the conjugate gradients
+    MatrixXXd adir;         //!< operator applied to the search direction
+
+    unsigned int cycles = 0;    //!< number of V-cycles in the last call to advance
+
+    static constexpr unsigned int NPRESMOOTH = 2;       //!< smoothing sweeps before the coarse-grid correction
+    static constexpr unsigned int NPOSTSMOOTH = 2;      //!< smoothing sweeps after the coarse-grid correction
+    static constexpr unsigned int NCOARSESMOOTH = 64;   //!< smoothing sweeps on the coarsest level
+    static constexpr unsigned int MAXCYCLES = 100;      //!< maximum number of iterations per solve
+    static constexpr double TOLERANCE = 1e-10;          //!< residual relative to the right-hand side at convergence
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _width   width of the system
+     * @param[in]  _height  height of the system
+     * @param[in]  dx       size of the space interval
+     * @param[in]  _dt      size of the time interval
+     * @param[in]  Da       Diffusion coefficient of compound A
+     * @param[in]  Db       Diffusion coefficient of compound B
+     * @param[in]  _pbc     Whether to employ periodic boundary conditions
+     * @param[in]  mask     Mask with walls set to one, or nullptr
+     * @param[in]  _theta   1 for backward Euler, 1/2 for Crank-Nicolson
+     */
+    MultigridIntegrator(unsigned int _width, unsigned int _height,
+                        double dx, double _dt, double Da, double Db,
+                        bool _pbc, const MatrixXXi* mask, double _theta);
+
+    /**
+     * @brief      Advance the concentrations by a number of time steps
+     *
+     * @param      a         Concentration of A
+     * @param      b         Concentration of B
+     * @param[in]  nsteps    Number of time steps
+     * @param[in]  reaction  Function that evaluates the reaction terms
+     * @param[in]  ncores    Number of threads
+     */
+    void advance(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps,
+                 const ReactionTerms& reaction, unsigned int ncores);
+
+    /**
+     * @brief      Get the number of V-cycles in the last call to advance
+     *
+     * @return     The number of V-cycles over both species
+     */
+    inline unsigned int get_cycles() const {
+        return this->cycles;
+    }
+
+private:
+    /**
+     * @brief      Derive the conductances of the previous faces and the neighbour indices of a level
+     *
+     * @param      lv    The level
+     */
+    void finalize_level(Level& lv) const;
+
+    /**
+     * @brief      Tabulate the transfer operators between a level and the next coarser level
+     *
+     * @param      fine    The fine level
+     * @param[in]  coarse  The coarse level
+     */
+    void build_transfer(Level& fine, const Level& coarse) const;
+
+    /**
+     * @brief      Build a coarse level from the next finer level
+     *
+     * @param[in]  fine  The fine level
+     *
+     * @return     The coarse level
+     */
+    Level coarsen(const Level& fine) const;
+
+    /**
+     * @brief      Solve A u = rhs on the finest level
+     *
+     * @param[in]  c     theta * dt * D
+     * @param      u     Initial guess; receives the solution
+     */
+    void solve(double c, MatrixXXd& u);
+
+    /**
+     * @brief      Apply the V-cycle preconditioner to the residual
+     *
+     * The result is stored in the correction of the finest level.
+     *
+     * @param[in]  c     theta * dt * D
+     */
+    void precondition(double c);
+
+    /**
+     * @brief      Perform a V-cycle for the correction of a level
+     *
+     * @param[in]  l     Index of the level
+     * @param[in]  c     theta * dt * D
+     */
+    void vcycle(unsigned int l, double c);
+
+    /**
+     * @brief      Calculate out = m u + c sum_f w_f (u - u_f)
+     *
+     * @param[in]  lv    The level
+     * @param[in]  c     Scaling of the diffusion part
+     * @param[in]  u     The field
+     * @param      out   The result
+     */
+    void apply(const Level& lv, double c, const MatrixXXd& u, MatrixXXd& out) const;
+
+    /**
+     * @brief      Calculate the residual f - A u of a level
+     *
+     * @param      lv    The level
+     * @param[in]  c     theta * dt * D
+     */
+    void residual(Level& lv, double c) const;
+
+    /**
+     * @brief      Perform red-black Gauss-Seidel sweeps on a level
+     *
+     * @param      lv       The level
+     * @param[in]  c        theta * dt * D
+     * @param[in]  nsweeps  Number of sweeps
+     * @param[in]  reverse  Whether to visit the cells in reverse order
+     */
+    void smooth(Level& lv, double c, unsigned int nsweeps, bool reverse) const;
+
+    /**
+     * @brief      Relax a single cell of a level
+     *
+     * @param      lv    The level
+     * @param[in]  c     theta * dt * D
+     * @param[in]  i     Row of the cell
+     * @param[in]  j     Column of the cell
+     */
+    inline void relax(Level& lv, double c, int i, int j) const {
+        if(lv.m(i,j) == 0.0) {
+            return;
+        }
+        const double sum = lv.we(i,j) * lv.u(i, lv.jnext[j]) + lv.ww(i,j) * lv.u(i, lv.jprev[j]) +
+                           lv.ws(i,j) * lv.u(lv.inext[i], j) + lv.wn(i,j) * lv.u(lv.iprev[i], j);
+        lv.u(i,j) = (lv.f(i,j) + c * sum) / (lv.m(i,j) + c * lv.wsum(i,j));
+    }
+
+    /**
+     * @brief      Get the coarse cells and weights that a fine cell interpolates from
+     *
+     * @param[in]  coarse  The coarse level
+     * @param[in]  i       Row of the fine cell
+     * @param[in]  j       Column of the fine cell
+     * @param      idx     Row and column of up to four coarse cells
+     * @param      wts     Weights of the coarse cells
+     *
+     * @return     The number of coarse cells
+     */
+    unsigned int interpolation(const Level& coarse, int i, int j, int idx[4][2], double wts[4]) const;
+
+    /**
+     * @brief      Restrict the residual of a level to the right-hand side of the next level
+     *
+     * @param[in]  fine    The fine level
+     * @param      coarse  The coarse level
+     */
+    void restrict_residual(const Level& fine, Level& coarse) const;
+
+    /**
+     * @brief      Add the prolongated correction of a level to the next finer level
+     *
+     * @param[in]  coarse  The coarse level
+     * @param      fine    The fine level
+     */
+    void prolongate(const Level& coarse, Level& fine) const;
+
+    /**
+     * @brief      Get the index of the previous cell along an axis
+     *
+     * @param[in]  i     Index of the cell
+     * @param[in]  n     Number of cells along the axis
+     *
+     * @return     Index of the neighbour, or -1 at a closed edge
+     */
+    inline int prev(int i, int n) const {
+        return i > 0 ? i - 1 : (this->pbc ? n - 1 : -1);
+    }
+
+    /**
+     * @brief      Get the index of the next cell along an axis
+     *
+     * @param[in]  i     Index of the cell
+     * @param[in]  n     Number of cells along the axis
+     *
+     * @return     Index of the neighbour, or -1 at a closed edge
+     */
+    inline int next(int i, int n) const {
+        return i + 1 < n ? i + 1 : (this->pbc ? 0 : -1);
+    }
+};
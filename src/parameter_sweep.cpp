@@ -0,0 +1,435 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "parameter_sweep.h"
+#include "file_replace.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/algorithm/string.hpp>
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _factory      Creates the system of a run
+ * @param[in]  _base_params  Parameters shared by all runs, e.g. "f=0.035;k=0.06"
+ * @param[in]  _Da           Diffusion coefficient of A unless swept
+ * @param[in]  _Db           Diffusion coefficient of B unless swept
+ * @param[in]  _outdir       Existing directory receiving the summaries
+ */
+ParameterSweep::ParameterSweep(const RunFactory& _factory, const std::string& _base_params,
+                               double _Da, double _Db, const std::string& _outdir) :
+    factory(_factory),
+    base_params(_base_params),
+    Da(_Da),
+    Db(_Db),
+    outdir(_outdir) {
+
+}
+
+/**
+ * @brief      Add a swept parameter
+ *
+ * @param[in]  range  The range of values
+ */
+void ParameterSweep::add_range(const SweepRange& range) {
+    if(range.n == 0) {
+        throw std::runtime_error("The range of " + range.name + " has no values.");
+    }
+
+    this->ranges.push_back(range);
+}
+
+/**
+ * @brief      Get the number of runs
+ *
+ * @return     The number of runs
+ */
+size_t ParameterSweep::get_num_runs() const {
+    size_t nruns = 1;
+    for(const SweepRange& range : this->ranges) {
+        nruns *= range.n;
+    }
+
+    return nruns;
+}
+
+/**
+ * @brief      Perform all runs that do not have a summary yet
+ *
+ * The pending runs are dealt over the queues of ncores / cores_per_run
+ * workers. A worker takes runs from the front of its own queue and steals
+ * from the back of the other queues once its own queue is empty. As no
+ * runs are added during the sweep, a worker is done once all queues are
+ * empty. The first error stops all workers and is rethrown.
+ *
+ * @param[in]  ncores         Total number of cores
+ * @param[in]  cores_per_run  Number of cores of a single run
+ * @param[in]  resume         Whether to keep the summaries of an earlier sweep
+ */
+void ParameterSweep::run(unsigned int ncores, unsigned int cores_per_run, bool resume) {
+    this->write_manifest(resume);
+
+    const size_t nruns = this->get_num_runs();
+    std::vector<size_t> pending;
+    this->completed = 0;
+    for(size_t idx=0; idx<nruns; idx++) {
+        if(resume && std::ifstream(this->get_summary_filename(idx)).good()) {
+            this->completed++;
+        } else {
+            pending.push_back(idx);
+        }
+    }
+
+    if(pending.empty()) {
+        return;
+    }
+
+    cores_per_run = std::max(1u, cores_per_run);
+    const unsigned int nworkers = std::max<size_t>(1, std::min<size_t>(ncores / cores_per_run, pending.size()));
+
+    struct WorkQueue {
+        std::mutex mtx;
+        std::deque<size_t> runs;
+    };
+    std::vector<WorkQueue> queues(nworkers);
+    for(size_t k=0; k<pending.size(); k++) {
+        queues[k % nworkers].runs.push_back(pending[k]);
+    }
+
+    const auto take = [&queues, nworkers](unsigned int w, size_t* idx) {
+        for(unsigned int v=0; v<nworkers; v++) {
+            WorkQueue& queue = queues[(w + v) % nworkers];
+            std::lock_guard<std::mutex> lock(queue.mtx);
+            if(queue.runs.empty()) {
+                continue;
+            }
+
+            if(v == 0) {
+                *idx = queue.runs.front();
+                queue.runs.pop_front();
+            } else {
+                *idx = queue.runs.back();
+                queue.runs.pop_back();
+            }
+            return true;
+        }
+        return false;
+    };
+
+    std::exception_ptr error;
+    std::mutex error_mtx;
+    std::atomic<bool> abort{false};
+
+    std::vector<std::thread> workers;
+    for(unsigned int w=0; w<nworkers; w++) {
+        workers.emplace_back([&, w]() {
+            size_t idx = 0;
+            while(!abort && take(w, &idx)) {
+                try {
+                    this->perform_run(idx, cores_per_run);
+                    this->completed++;
+                } catch(...) {
+                    std::lock_guard<std::mutex> lock(error_mtx);
+                    if(!error) {
+                        error = std::current_exception();
+                    }
+                    abort = true;
+                }
+            }
+        });
+    }
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief      Get the filename of the summary of a run
+ *
+ * @param[in]  idx   Index of the run
+ *
+ * @return     The filename
+ */
+std::string ParameterSweep::get_summary_filename(size_t idx) const {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "run_%06zu.sum", idx);
+    return this->outdir + "/" + buf;
+}
+
+/**
+ * @brief      Read the summary of a run
+ *
+ * The dimensions and the length of the parameter string are checked
+ * against the size of the file before anything is allocated, such that a
+ * truncated or corrupt summary is rejected.
+ *
+ * @param[in]  filename  The filename
+ *
+ * @return     The summary
+ */
+RunSummary ParameterSweep::read_summary(const std::string& filename) {
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if(!in.good()) {
+        throw std::runtime_error("Cannot open summary " + filename);
+    }
+
+    in.seekg(0, std::ios::end);
+    const uint64_t filesize = (uint64_t)in.tellg();
+    in.seekg(0, std::ios::beg);
+
+    RunSummary summary;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned int length = 0;
+    in.read((char*) &width, sizeof(unsigned int));
+    in.read((char*) &height, sizeof(unsigned int));
+    in.read((char*) &length, sizeof(unsigned int));
+
+    // header, parameter string, scalars, statistics and both concentrations
+    const uint64_t cells = (uint64_t)width * height;
+    const uint64_t expected = 3 * sizeof(unsigned int) + (uint64_t)length + 3 * sizeof(double) +
+                              sizeof(unsigned int) + 8 * sizeof(double) + 2 * sizeof(double) * cells;
+    if(!in.good() || cells == 0 || cells > filesize / (2 * sizeof(double)) ||
+       length > (1u << 20) || expected != filesize) {
+        throw std::runtime_error("Corrupt summary " + filename);
+    }
+
+    summary.params.resize(length);
+    in.read(&summary.params[0], length);
+
+    in.read((char*) &summary.Da, sizeof(double));
+    in.read((char*) &summary.Db, sizeof(double));
+    in.read((char*) &summary.elapsed, sizeof(double));
+    in.read((char*) &summary.frames, sizeof(unsigned int));
+    in.read((char*) summary.stats_a.data(), 4 * sizeof(double));
+    in.read((char*) summary.stats_b.data(), 4 * sizeof(double));
+
+    summary.a.resize(height, width);
+    summary.b.resize(height, width);
+    in.read((char*) summary.a.data(), summary.a.size() * sizeof(double));
+    in.read((char*) summary.b.data(), summary.b.size() * sizeof(double));
+
+    if(!in.good()) {
+        throw std::runtime_error("Incomplete summary " + filename);
+    }
+
+    return summary;
+}
+
+/**
+ * @brief      Get the parameter string and diffusion coefficients of a run
+ *
+ * The last range varies fastest. Shared parameters that are also swept
+ * are left out.
+ *
+ * @param[in]  idx   Index of the run
+ * @param      Da    Diffusion coefficient of A
+ * @param      Db    Diffusion coefficient of B
+ *
+ * @return     The parameter string
+ */
+std::string ParameterSweep::get_run_parameters(size_t idx, double* Da, double* Db) const {
+    *Da = this->Da;
+    *Db = this->Db;
+
+    std::vector<std::string> pieces;
+    for(size_t r=this->ranges.size(); r-- > 0; ) {
+        const SweepRange& range = this->ranges[r];
+        const unsigned int k = idx % range.n;
+        idx /= range.n;
+
+        const double value = (range.n > 1) ? range.start + (range.stop - range.start) * k / (range.n - 1) : range.start;
+        if(range.name == "Da") {
+            *Da = value;
+        } else if(range.name == "Db") {
+            *Db = value;
+        } else {
+            std::ostringstream piece;
+            piece << std::setprecision(12) << range.name << "=" << value;
+            pieces.insert(pieces.begin(), piece.str());
+        }
+    }
+
+    std::vector<std::string> shared;
+    boost::split(shared, this->base_params, boost::is_any_of(";"), boost::token_compress_on);
+    for(const std::string& piece : shared) {
+        const std::string name = boost::trim_copy(piece.substr(0, piece.find('=')));
+        if(name.empty()) {
+            continue;
+        }
+
+        bool swept = false;
+        for(const SweepRange& range : this->ranges) {
+            swept |= (range.name == name);
+        }
+        if(!swept) {
+            pieces.push_back(piece);
+        }
+    }
+
+    std::string params;
+    for(const std::string& piece : pieces) {
+        params += (params.empty() ? "" : ";") + piece;
+    }
+
+    return params;
+}
+
+/**
+ * @brief      Write the manifest, or compare it to the existing one when resuming
+ *
+ * The manifest lists the index, diffusion coefficients and parameter
+ * string of every run, one run per line.
+ *
+ * @param[in]  resume  Whether to keep the summaries of an earlier sweep
+ */
+void ParameterSweep::write_manifest(bool resume) const {
+    std::ostringstream manifest;
+    manifest << std::setprecision(12);
+    for(size_t idx=0; idx<this->get_num_runs(); idx++) {
+        double Da = 0.0;
+        double Db = 0.0;
+        const std::string params = this->get_run_parameters(idx, &Da, &Db);
+        manifest << idx << " " << Da << " " << Db << " " << params << "\n";
+    }
+
+    const std::string filename = this->outdir + "/sweep.txt";
+    if(resume) {
+        std::ifstream in(filename);
+        if(in.good()) {
+            std::stringstream existing;
+            existing << in.rdbuf();
+            if(existing.str() != manifest.str()) {
+                throw std::runtime_error("The sweep does not match the manifest " + filename);
+            }
+            return;
+        }
+    }
+
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    if(!out.good()) {
+        throw std::runtime_error("Cannot write manifest " + filename);
+    }
+    out << manifest.str();
+}
+
+/**
+ * @brief      Perform a single run and write its summary
+ *
+ * The threads of a run are not pinned, as the pinning policies assign the
+ * same logical CPUs to the threads of every run. Neither is temporal
+ * blocking timed, as the concurrent runs distort the timing. A run stops early when
+ * its system has reached a steady state, see TwoDimRD::set_steady_state().
+ *
+ * @param[in]  idx     Index of the run
+ * @param[in]  ncores  Number of cores
+ */
+void ParameterSweep::perform_run(size_t idx, unsigned int ncores) const {
+    RunSummary summary;
+    const std::string params = this->get_run_parameters(idx, &summary.Da, &summary.Db);
+    summary.params = params;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::unique_ptr<TwoDimRD> system = this->factory(summary.Da, summary.Db);
+    system->set_cores(ncores);
+    system->set_thread_pinning(THREAD_PINNING::NONE);
+    system->set_blocking_measurement(false);
+    system->set_parameters(params);
+    summary.frames = 0;
+    for(unsigned int i=0; i<system->get_num_steps() && !system->is_steady(); i++) {
+        system->update();
+        summary.frames++;
+    }
+    system->clean();
+
+    auto end = std::chrono::steady_clock::now();
+    summary.elapsed = std::chrono::duration<double>(end - start).count();
+
+    summary.a = system->get_concentrations(true).back();
+    summary.b = system->get_concentrations(false).back();
+
+    const auto stats = [](const MatrixXXd& c) -> std::array<double, 4> {
+        const double mean = c.mean();
+        const double var = (c.array() - mean).square().mean();
+        return {c.minCoeff(), c.maxCoeff(), mean, std::sqrt(var)};
+    };
+    summary.stats_a = stats(summary.a);
+    summary.stats_b = stats(summary.b);
+
+    write_summary(this->get_summary_filename(idx), summary);
+}
+
+/**
+ * @brief      Write the summary of a run
+ *
+ * The summary is written to a temporary file that is flushed to disk and
+ * replaces the summary when complete, such that an interrupted write never
+ * counts as a summary.
+ *
+ * @param[in]  filename  The filename
+ * @param[in]  summary   The summary
+ */
+void ParameterSweep::write_summary(const std::string& filename, const RunSummary& summary) {
+    const std::string tmpname = filename + ".tmp";
+    std::ofstream out(tmpname, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    const unsigned int width = summary.a.cols();
+    const unsigned int height = summary.a.rows();
+    const unsigned int length = summary.params.size();
+    out.write((char*) &width, sizeof(unsigned int));
+    out.write((char*) &height, sizeof(unsigned int));
+    out.write((char*) &length, sizeof(unsigned int));
+    out.write(summary.params.data(), length);
+
+    out.write((char*) &summary.Da, sizeof(double));
+    out.write((char*) &summary.Db, sizeof(double));
+    out.write((char*) &summary.elapsed, sizeof(double));
+    out.write((char*) &summary.frames, sizeof(unsigned int));
+    out.write((char*) summary.stats_a.data(), 4 * sizeof(double));
+    out.write((char*) summary.stats_b.data(), 4 * sizeof(double));
+
+    out.write((char*) summary.a.data(), summary.a.size() * sizeof(double));
+    out.write((char*) summary.b.data(), summary.b.size() * sizeof(double));
+
+    out.close();
+    if(!out.good() || !replace_file(tmpname, filename)) {
+        std::remove(tmpname.c_str());
+        throw std::runtime_error("Cannot write summary " + filename);
+    }
+}
@@ -0,0 +1,194 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "matrices.h"
+#include "two_dim_rd.h"
+
+/**
+ * @brief      Range of values of a single parameter of a sweep
+ */
+struct SweepRange {
+    std::string name;       //!< name of the parameter; Da and Db select the diffusion coefficients
+    double start;           //!< first value
+    double stop;            //!< last value
+    unsigned int n;         //!< number of equidistant values
+};
+
+/**
+ * @brief      Summary of a single run of a sweep
+ */
+struct RunSummary {
+    std::string params;     //!< parameter string of the run
+    double Da;              //!< diffusion coefficient of A
+    double Db;              //!< diffusion coefficient of B
+    double elapsed;         //!< wall time of the run in seconds
+    unsigned int frames;    //!< number of integrated frames; fewer than requested when a steady state was reached
+    std::array<double, 4> stats_a;  //!< minimum, maximum, mean and standard deviation of the final A
+    std::array<double, 4> stats_b;  //!< minimum, maximum, mean and standard deviation of the final B
+    MatrixXXd a;            //!< final concentration of A
+    MatrixXXd b;            //!< final concentration of B
+};
+
+/**
+ * @brief      Creates a configured system for a run, given its diffusion coefficients
+ *
+ * The system needs to have its reaction set, but not its parameters.
+ */
+typedef std::function<std::unique_ptr<TwoDimRD>(double Da, double Db)> RunFactory;
+
+/**
+ * @brief      Scan of a grid of kinetic parameters and diffusion coefficients
+ *
+ * The runs span the Cartesian product of the ranges. They are scheduled
+ * over a pool of workers that each get a budget of cores for the OpenMP
+ * threads of their run. Every worker takes runs from its own queue and
+ * steals from the other queues once its own queue is empty, such that
+ * runs of very different duration still keep all workers busy.
+ *
+ * Each completed run is written as a compact summary file in the output
+ * directory, next to a manifest listing the parameters of all runs. An
+ * interrupted sweep resumes by skipping the runs that have a summary,
+ * provided the manifest matches.
+ */
+class ParameterSweep {
+private:
+    RunFactory factory;                 //!< creates the system of a run
+    std::string base_params;            //!< parameters shared by all runs
+    double Da;                          //!< diffusion coefficient of A unless swept
+    double Db;                          //!< diffusion coefficient of B unless swept
+    std::vector<SweepRange> ranges;     //!< swept parameters
+    std::string outdir;                 //!< directory receiving the summaries
+
+    std::atomic<size_t> completed{0};   //!< number of runs with a summary
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _factory      Creates the system of a run
+     * @param[in]  _base_params  Parameters shared by all runs, e.g. "f=0.035;k=0.06"
+     * @param[in]  _Da           Diffusion coefficient of A unless swept
+     * @param[in]  _Db           Diffusion coefficient of B unless swept
+     * @param[in]  _outdir       Existing directory receiving the summaries
+     */
+    ParameterSweep(const RunFactory& _factory, const std::string& _base_params,
+                   double _Da, double _Db, const std::string& _outdir);
+
+    /**
+     * @brief      Add a swept parameter
+     *
+     * @param[in]  range  The range of values
+     */
+    void add_range(const SweepRange& range);
+
+    /**
+     * @brief      Get the number of runs
+     *
+     * @return     The number of runs
+     */
+    size_t get_num_runs() const;
+
+    /**
+     * @brief      Get the number of runs that have completed, including resumed ones
+     *
+     * May be called while the sweep is running.
+     *
+     * @return     The number of runs
+     */
+    inline size_t get_num_completed() const {
+        return this->completed.load();
+    }
+
+    /**
+     * @brief      Perform all runs that do not have a summary yet
+     *
+     * @param[in]  ncores         Total number of cores
+     * @param[in]  cores_per_run  Number of cores of a single run
+     * @param[in]  resume         Whether to keep the summaries of an earlier sweep
+     */
+    void run(unsigned int ncores, unsigned int cores_per_run, bool resume);
+
+    /**
+     * @brief      Get the filename of the summary of a run
+     *
+     * @param[in]  idx   Index of the run
+     *
+     * @return     The filename
+     */
+    std::string get_summary_filename(size_t idx) const;
+
+    /**
+     * @brief      Read the summary of a run
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     The summary
+     */
+    static RunSummary read_summary(const std::string& filename);
+
+private:
+    /**
+     * @brief      Get the parameter string and diffusion coefficients of a run
+     *
+     * @param[in]  idx   Index of the run
+     * @param      Da    Diffusion coefficient of A
+     * @param      Db    Diffusion coefficient of B
+     *
+     * @return     The parameter string
+     */
+    std::string get_run_parameters(size_t idx, double* Da, double* Db) const;
+
+    /**
+     * @brief      Write the manifest, or compare it to the existing one when resuming
+     *
+     * @param[in]  resume  Whether to keep the summaries of an earlier sweep
+     */
+    void write_manifest(bool resume) const;
+
+    /**
+     * @brief      Perform a single run and write its summary
+     *
+     * @param[in]  idx     Index of the run
+     * @param[in]  ncores  Number of cores
+     */
+    void perform_run(size_t idx, unsigned int ncores) const;
+
+    /**
+     * @brief      Write the summary of a run
+     *
+     * The summary is written to a temporary file that is renamed when
+     * complete, such that an interrupted write never counts as a summary.
+     *
+     * @param[in]  filename  The filename
+     * @param[in]  summary   The summary
+     */
+    static void write_summary(const std::string& filename, const RunSummary& summary);
+};
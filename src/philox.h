@@ -0,0 +1,126 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief      Philox4x32-10 counter-based random number generator
+ *
+ * Every draw maps a 128-bit counter and a 64-bit key to four 32-bit random
+ * numbers through ten rounds of multiplications and exclusive ors, without
+ * any state in between draws (Salmon et al., "Parallel random numbers: as
+ * easy as 1, 2, 3", SC'11). Keying the generator by a seed and using the
+ * index of a cell as the counter gives every cell its own numbers, which
+ * are the same for any order and number of threads.
+ */
+class Philox {
+private:
+    uint64_t key;   //!< key of the generator, i.e. the seed
+
+    static constexpr uint32_t M0 = 0xD2511F53;  //!< multiplier of the first pair
+    static constexpr uint32_t M1 = 0xCD9E8D57;  //!< multiplier of the second pair
+    static constexpr uint32_t W0 = 0x9E3779B9;  //!< increment of the first half of the key per round
+    static constexpr uint32_t W1 = 0xBB67AE85;  //!< increment of the second half of the key per round
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _key  The key
+     */
+    explicit Philox(uint64_t _key) : key(_key) {}
+
+    /**
+     * @brief      Draw four random numbers
+     *
+     * @param[in]  ctr   The counter
+     *
+     * @return     Four random numbers
+     */
+    inline std::array<uint32_t, 4> operator()(std::array<uint32_t, 4> ctr) const {
+        uint32_t k0 = (uint32_t)this->key;
+        uint32_t k1 = (uint32_t)(this->key >> 32);
+
+        for(unsigned int r=0; r<10; r++) {
+            const uint64_t p0 = (uint64_t)M0 * ctr[0];
+            const uint64_t p1 = (uint64_t)M1 * ctr[2];
+            ctr = {(uint32_t)(p1 >> 32) ^ ctr[1] ^ k0, (uint32_t)p1,
+                   (uint32_t)(p0 >> 32) ^ ctr[3] ^ k1, (uint32_t)p0};
+            k0 += W0;
+            k1 += W1;
+        }
+
+        return ctr;
+    }
+
+    /**
+     * @brief      Draw a uniform number in [0,1)
+     *
+     * @param[in]  index   Index of the draw within the stream
+     * @param[in]  stream  Stream of draws
+     *
+     * @return     The number, with 53 random bits
+     */
+    inline double uniform(uint64_t index, uint64_t stream) const {
+        const auto r = (*this)({(uint32_t)index, (uint32_t)(index >> 32),
+                                (uint32_t)stream, (uint32_t)(stream >> 32)});
+        return to_double(r[0], r[1]);
+    }
+
+    /**
+     * @brief      Draw a number from the standard normal distribution
+     *
+     * Uses the Box-Muller transform on two uniform numbers of a single draw.
+     *
+     * @param[in]  index   Index of the draw within the stream
+     * @param[in]  stream  Stream of draws
+     *
+     * @return     The number
+     */
+    inline double normal(uint64_t index, uint64_t stream) const {
+        const auto r = (*this)({(uint32_t)index, (uint32_t)(index >> 32),
+                                (uint32_t)stream, (uint32_t)(stream >> 32)});
+
+        // the first number lies in (0,1] such that its logarithm is finite
+        const double u1 = 1.0 - to_double(r[0], r[1]);
+        const double u2 = to_double(r[2], r[3]);
+        constexpr double pi = 3.14159265358979323846;
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * pi * u2);
+    }
+
+private:
+    /**
+     * @brief      Convert two random numbers to a uniform number in [0,1)
+     *
+     * @param[in]  hi    Random number providing the upper 27 bits
+     * @param[in]  lo    Random number providing the lower 26 bits
+     *
+     * @return     The number
+     */
+    static inline double to_double(uint32_t hi, uint32_t lo) {
+        return ((double)(hi >> 5) * 67108864.0 + (double)(lo >> 6)) * (1.0 / 9007199254740992.0);
+    }
+};
@@ -42,8 +42,8 @@ void ReactionBarkley::init(MatrixXXd& a, MatrixXXd& b) const {
  * \frac{\partial Y}{\partial t} = X^{3} - Y
  */
 void ReactionBarkley::reaction(double a, double b, double *ra, double *rb) const {
-    *ra = epsilon * a * (1.0 - a) * (a - (b + this->beta)/this->alpha);
-    *rb = a*a*a - b;
+    const KineticParameters<double> p = {this->alpha, this->beta, this->epsilon, 0.0};
+    KineticsBarkley::reaction(a, b, p, ra, rb);
 }
 
 /**
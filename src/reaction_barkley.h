@@ -21,6 +21,7 @@
 #pragma once
 
 #include "reaction_system.h"
+#include "kinetics.h"
 
 /**
  * @brief      Class for Gray-Scott Reaction
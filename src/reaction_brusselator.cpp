@@ -43,8 +43,8 @@ void ReactionBrusselator::init(MatrixXXd& a, MatrixXXd& b) const {
  *
  */
 void ReactionBrusselator::reaction(double a, double b, double *ra, double *rb) const {
-    *ra = this->alpha - (this->beta + 1.0) * a + (a * a * b);
-    *rb = (this->beta * a) - (a * a * b);
+    const KineticParameters<double> p = {this->alpha, this->beta, 0.0, 0.0};
+    KineticsBrusselator::reaction(a, b, p, ra, rb);
 }
 
 /**
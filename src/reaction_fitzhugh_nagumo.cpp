@@ -42,8 +42,8 @@ void ReactionFitzhughNagumo::init(MatrixXXd& a, MatrixXXd& b) const {
  * \frac{\partial Y}{\partial t} = \beta(X - Y)
  */
 void ReactionFitzhughNagumo::reaction(double a, double b, double *ra, double *rb) const {
-    *ra = a - (a * a * a) - b + this->alpha;
-    *rb = (a - b) * this->beta;
+    const KineticParameters<double> p = {this->alpha, this->beta, 0.0, 0.0};
+    KineticsFitzhughNagumo::reaction(a, b, p, ra, rb);
 }
 
 /**
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "reaction_system.h"
+#include "kinetics.h"
 
 /**
  * @brief      Class for Fitzhugh-Nagumo Reaction
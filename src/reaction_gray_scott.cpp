@@ -40,9 +40,8 @@ ReactionGrayScott::ReactionGrayScott() {
  *
  */
 void ReactionGrayScott::reaction(double a, double b, double *ra, double *rb) const {
-    double r = a * b * b;
-    *ra = -r + this->f * (1.0 - a);
-    *rb =  r - (this->f + this->k) * b;
+    const KineticParameters<double> p = {this->f, this->k, 0.0, 0.0};
+    KineticsGrayScott::reaction(a, b, p, ra, rb);
 }
 
 
@@ -41,8 +41,8 @@ ReactionLotkaVolterra::ReactionLotkaVolterra() {
  * \frac{\partial Y}{\partial t} = -\gamma Y + \delta XY
  */
 void ReactionLotkaVolterra::reaction(double a, double b, double *ra, double *rb) const {
-    *ra = this->alpha * a - this->beta * a * b;
-    *rb = this->delta * a * b - this->gamma * b;
+    const KineticParameters<double> p = {this->alpha, this->beta, this->gamma, this->delta};
+    KineticsLotkaVolterra::reaction(a, b, p, ra, rb);
 }
 
 /**
@@ -21,6 +21,8 @@
 
 #include "reaction_system.h"
 
+#include <sstream>
+
 /**
  * @brief      Constructs the object.
  */
@@ -41,10 +43,14 @@ void ReactionSystem::init_random(MatrixXXd& a, MatrixXXd& b, double ca, double c
     a = MatrixXXd::Zero(height, width);
     b = MatrixXXd::Zero(height, width);
 
-    for(unsigned int i=0; i<height; i++) {
+    const uint64_t s = this->next_stream();
+
+    #pragma omp parallel for
+    for(int i=0; i<(int)height; i++) {
         for(unsigned int j=0; j<width; j++) {
-            a(i,j) = ca + this->uniform_dist() * delta;
-            b(i,j) = cb + this->uniform_dist() * delta;
+            const uint64_t idx = (uint64_t)i * width + j;
+            a(i,j) = ca + this->uniform_dist(2 * idx, s) * delta;
+            b(i,j) = cb + this->uniform_dist(2 * idx + 1, s) * delta;
         }
     }
 }
@@ -135,13 +141,15 @@ void ReactionSystem::init_random_rectangles(MatrixXXd& a, MatrixXXd& b) const {
     a = MatrixXXd::Ones(height, width) * 0.4201;
     b = MatrixXXd::Ones(height, width) * 0.2878;
 
+    const uint64_t s = this->next_stream();
+
     for(unsigned int k=0; k<100; k++) {
-        int f = height / 2 + (int)((this->uniform_dist()-0.5) * height * 0.90);
-        int g = width / 2 + (int)((this->uniform_dist()-0.5) * width * 0.90);
-        double val1 = this->uniform_dist();
-        double val2 = this->uniform_dist();
-        const int imax = (unsigned int)((this->uniform_dist() * 0.1 * height));
-        const int jmax = (unsigned int)((this->uniform_dist() * 0.1 * height));
+        int f = height / 2 + (int)((this->uniform_dist(6 * k, s)-0.5) * height * 0.90);
+        int g = width / 2 + (int)((this->uniform_dist(6 * k + 1, s)-0.5) * width * 0.90);
+        double val1 = this->uniform_dist(6 * k + 2, s);
+        double val2 = this->uniform_dist(6 * k + 3, s);
+        const int imax = (unsigned int)((this->uniform_dist(6 * k + 4, s) * 0.1 * height));
+        const int jmax = (unsigned int)((this->uniform_dist(6 * k + 5, s) * 0.1 * height));
         for(int i=-imax/2; i<imax/2; i++) {
             for(int j=-jmax/2; j<jmax/2; j++) {
                 a(f+i, g+j) = val1;
@@ -204,10 +212,14 @@ void ReactionSystem::init_central_square_gaussian_noise(MatrixXXd& a, MatrixXXd&
         }
     }
 
-    for(unsigned int i=0; i<height; i++) {
+    const uint64_t s = this->next_stream();
+
+    #pragma omp parallel for
+    for(int i=0; i<(int)height; i++) {
         for(unsigned int j=0; j<width; j++) {
-            a(i,j) += this->normal_dist() * noise;
-            b(i,j) += this->normal_dist() * noise;
+            const uint64_t idx = (uint64_t)i * width + j;
+            a(i,j) += this->normal_dist(2 * idx, s) * noise;
+            b(i,j) += this->normal_dist(2 * idx + 1, s) * noise;
         }
     }
 }
@@ -239,3 +251,50 @@ std::unordered_map<std::string, double> ReactionSystem::parse_parameters(const s
 
     return map;
 }
+
+/**
+ * @brief      Set the seed of the random initial conditions from the parameters
+ *
+ * @param[in]  params  The parameters
+ */
+void ReactionSystem::set_seed(const std::string& params) {
+    const auto map = this->parse_parameters(params);
+    const auto got = map.find("seed");
+    if(got != map.end()) {
+        if(got->second < 0.0 || got->second >= 9007199254740992.0) {
+            throw std::runtime_error("Invalid seed encountered: " + params);
+        }
+        this->seed = (uint64_t)got->second;
+    } else {
+        this->seed = 0;
+    }
+    this->stream = 0;
+}
+
+/**
+ * @brief      Get the state of the random number generator of the initial conditions
+ *
+ * @return     The seed and the number of streams drawn so far
+ */
+std::string ReactionSystem::get_random_state() const {
+    std::ostringstream out;
+    out << this->seed << ' ' << this->stream;
+    return out.str();
+}
+
+/**
+ * @brief      Restore the state of the random number generator of the initial conditions
+ *
+ * @param[in]  state  The state as obtained from get_random_state()
+ */
+void ReactionSystem::set_random_state(const std::string& state) {
+    uint64_t seed = 0;
+    uint64_t stream = 0;
+    std::istringstream in(state);
+    in >> seed >> stream;
+    if(in.fail()) {
+        throw std::runtime_error("Invalid state of the random number generator.");
+    }
+    this->seed = seed;
+    this->stream = stream;
+}
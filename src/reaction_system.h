@@ -21,7 +21,8 @@
 
 #pragma once
 
-#include <random>
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <unordered_map>
 #include <vector>
@@ -32,11 +33,15 @@
 
 #include "config.h"
 #include "matrices.h"
+#include "philox.h"
 
 class ReactionSystem {
 protected:
     KINETICS reacttype = KINETICS::NONE;
 
+    uint64_t seed = 0;              //!< key of the random number generator of the initial conditions
+    mutable uint64_t stream = 0;    //!< stream of the next random initialization
+
 public:
     /**
      * @brief      Constructs the object.
@@ -84,6 +89,40 @@ public:
         return this->reacttype;
     }
 
+    /**
+     * @brief      Parse parameters
+     *
+     * @param[in]  params  string containing list of parameters
+     *
+     * @return     unordered map with the parameters
+     */
+    std::unordered_map<std::string, double> parse_parameters(const std::string& params) const;
+
+    /**
+     * @brief      Set the seed of the random initial conditions from the parameters
+     *
+     * The seed is given as seed=<n> in the parameter string, below 2^53;
+     * without it the seed is zero. The random initial conditions only
+     * depend on the seed, and not on the number of threads.
+     *
+     * @param[in]  params  The parameters
+     */
+    void set_seed(const std::string& params);
+
+    /**
+     * @brief      Get the state of the random number generator of the initial conditions
+     *
+     * @return     The seed and the number of streams drawn so far
+     */
+    std::string get_random_state() const;
+
+    /**
+     * @brief      Restore the state of the random number generator of the initial conditions
+     *
+     * @param[in]  state  The state as obtained from get_random_state()
+     */
+    void set_random_state(const std::string& state);
+
 protected:
     /**
      * @brief      random initialization
@@ -148,37 +187,40 @@ protected:
     void init_central_square_gaussian_noise(MatrixXXd& a, MatrixXXd& b, double a0, double b0, double ca, double cb, double noise) const;
 
     /**
-     * @brief      provide normal distribution
+     * @brief      Draw from a normal distribution centred at 0.5, clamped to [0,1]
+     *
+     * @param[in]  index   Index of the draw, e.g. twice the index of the cell plus the component
+     * @param[in]  stream  Stream of the initialization, see next_stream()
      *
-     * @return     returns value at normal distribution
+     * @return     The number
      */
-    static double normal_dist() {
-        static std::mt19937 rng;
-        // center at zero and scale is 0.05
-        static std::normal_distribution<> nd(0.50, 0.50);
-
-        return std::min(1.0, std::max(0.0, nd(rng)));
+    inline double normal_dist(uint64_t index, uint64_t stream) const {
+        const double z = Philox(this->seed).normal(index, stream);
+        return std::min(1.0, std::max(0.0, 0.5 + 0.5 * z));
     }
 
     /**
-     * @brief      provide uniform distribution
+     * @brief      Draw from a uniform distribution on [0,1)
+     *
+     * @param[in]  index   Index of the draw, e.g. twice the index of the cell plus the component
+     * @param[in]  stream  Stream of the initialization, see next_stream()
      *
-     * @return     returns value at uniform distribution
+     * @return     The number
      */
-    static double uniform_dist() {
-        static std::mt19937 rng;
-        // center at zero and scale is 0.05
-        static std::uniform_real_distribution<> nd(0.0, 1.0);
-
-        return nd(rng);
+    inline double uniform_dist(uint64_t index, uint64_t stream) const {
+        return Philox(this->seed).uniform(index, stream);
     }
 
     /**
-     * @brief      Parse parameters
+     * @brief      Get the stream for the draws of a random initialization
      *
-     * @param[in]  params  string containing list of parameters
+     * Every random initialization takes the next stream, such that
+     * repeated initializations, e.g. of the slices of a three-dimensional
+     * system, differ from each other.
      *
-     * @return     unordered map with the parameters
+     * @return     The stream
      */
-    std::unordered_map<std::string, double> parse_parameters(const std::string& params) const;
+    inline uint64_t next_stream() const {
+        return this->stream++;
+    }
 };
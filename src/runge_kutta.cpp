@@ -0,0 +1,321 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "runge_kutta.h"
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <omp.h>
+
+/**
+ * @brief      Get Heun's second-order method
+ *
+ * @return     The tableau; without an embedded solution
+ */
+const ButcherTableau& get_tableau_heun() {
+    static const ButcherTableau tableau = {
+        2,
+        {0.0, 0.0,
+         1.0, 0.0},
+        {0.5, 0.5},
+        {0.5, 0.5},
+        2,
+        false
+    };
+    return tableau;
+}
+
+/**
+ * @brief      Get the classical fourth-order Runge-Kutta method
+ *
+ * @return     The tableau; without an embedded solution
+ */
+const ButcherTableau& get_tableau_rk4() {
+    static const ButcherTableau tableau = {
+        4,
+        {0.0,       0.0,       0.0,       0.0,
+         1.0/2.0,   0.0,       0.0,       0.0,
+         0.0,       1.0/2.0,   0.0,       0.0,
+         0.0,       0.0,       1.0,       0.0},
+        {1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0},
+        {1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0},
+        4,
+        false
+    };
+    return tableau;
+}
+
+/**
+ * @brief      Get the Heun-Euler 2(1) pair
+ *
+ * @return     The tableau
+ */
+const ButcherTableau& get_tableau_heun_euler() {
+    static const ButcherTableau tableau = {
+        2,
+        {0.0, 0.0,
+         1.0, 0.0},
+        {0.5, 0.5},
+        {1.0, 0.0},
+        2,
+        false
+    };
+    return tableau;
+}
+
+/**
+ * @brief      Get the Bogacki-Shampine 3(2) pair
+ *
+ * @return     The tableau
+ */
+const ButcherTableau& get_tableau_bogacki_shampine() {
+    static const ButcherTableau tableau = {
+        4,
+        {0.0,       0.0,       0.0,       0.0,
+         1.0/2.0,   0.0,       0.0,       0.0,
+         0.0,       3.0/4.0,   0.0,       0.0,
+         2.0/9.0,   1.0/3.0,   4.0/9.0,   0.0},
+        {2.0/9.0, 1.0/3.0, 4.0/9.0, 0.0},
+        {7.0/24.0, 1.0/4.0, 1.0/3.0, 1.0/8.0},
+        3,
+        true
+    };
+    return tableau;
+}
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _tableau  Coefficients of the method
+ * @param[in]  width     width of the system
+ * @param[in]  height    height of the system
+ * @param[in]  dt        initial time step
+ * @param[in]  _atol     absolute tolerance
+ * @param[in]  _rtol     relative tolerance
+ */
+RungeKuttaIntegrator::RungeKuttaIntegrator(const ButcherTableau& _tableau, unsigned int width, unsigned int height,
+                                           double dt, double _atol, double _rtol) :
+    tableau(_tableau),
+    h(dt),
+    atol(_atol),
+    rtol(_rtol) {
+
+    this->ka.assign(this->tableau.nstages, MatrixXXd::Zero(height, width));
+    this->kb.assign(this->tableau.nstages, MatrixXXd::Zero(height, width));
+    this->ya = MatrixXXd::Zero(height, width);
+    this->yb = MatrixXXd::Zero(height, width);
+    this->ya_new = MatrixXXd::Zero(height, width);
+    this->yb_new = MatrixXXd::Zero(height, width);
+
+    this->e.resize(this->tableau.nstages);
+    for(unsigned int j=0; j<this->tableau.nstages; j++) {
+        this->e[j] = this->tableau.b[j] - this->tableau.bhat[j];
+    }
+}
+
+/**
+ * @brief      Advance the concentrations over a time span
+ *
+ * @param      a       Concentration of A
+ * @param      b       Concentration of B
+ * @param[in]  tspan   time span
+ * @param[in]  rate    Function that evaluates the time derivatives
+ * @param[in]  ncores  Number of threads
+ *
+ * @return     Statistics of the steps taken
+ */
+StepStatistics RungeKuttaIntegrator::advance(MatrixXXd& a, MatrixXXd& b, double tspan,
+                                             const RateFunction& rate, unsigned int ncores) {
+    omp_set_num_threads(ncores);
+
+    const unsigned int s = this->tableau.nstages;
+    const double exponent = -1.0 / (double)this->tableau.order;
+
+    StepStatistics stats;
+    stats.dt_min = std::numeric_limits<double>::max();
+
+    double t = 0.0;
+    while(t < tspan * (1.0 - 1e-12)) {
+        // do not step beyond the end of the span
+        const bool clipped = (t + this->h >= tspan);
+        const double step = clipped ? tspan - t : this->h;
+
+        if(!this->k0_valid) {
+            rate(a, b, this->ka[0], this->kb[0]);
+            this->k0_valid = true;
+        }
+
+        for(unsigned int i=1; i<s; i++) {
+            this->combine(a, b, &this->tableau.a[i * s], i, step, this->ya, this->yb);
+            rate(this->ya, this->yb, this->ka[i], this->kb[i]);
+        }
+        this->combine(a, b, this->tableau.b.data(), s, step, this->ya_new, this->yb_new);
+
+        // a non-finite error, e.g. from a rate evaluated outside its domain, rejects the step
+        const double err = this->error_norm(a, b, step);
+        double factor = this->facmax;
+        if(!std::isfinite(err)) {
+            factor = this->facmin;
+        } else if(err > 0.0) {
+            factor = this->safety * std::pow(err, exponent);
+        }
+
+        if(std::isfinite(err) && err <= 1.0) {
+            t += step;
+            a.swap(this->ya_new);
+            b.swap(this->yb_new);
+
+            stats.accepted++;
+            stats.dt_min = std::min(stats.dt_min, step);
+            stats.dt_max = std::max(stats.dt_max, step);
+
+            // the last stage holds the derivatives of the new state
+            if(this->tableau.fsal) {
+                this->ka[0].swap(this->ka[s-1]);
+                this->kb[0].swap(this->kb[s-1]);
+            } else {
+                this->k0_valid = false;
+            }
+
+            // a step that was shortened to reach the end of the span says little about the next one
+            if(!clipped || factor < 1.0) {
+                this->h = step * std::min(this->facmax, std::max(this->facmin, factor));
+            }
+        } else {
+            stats.rejected++;
+            this->h = step * std::min(1.0, std::max(this->facmin, factor));
+            if(this->h < this->hmin * tspan) {
+                throw std::runtime_error("Adaptive time step fell below its minimum; the rates are not finite or the system is too stiff.");
+            }
+        }
+    }
+
+    if(stats.accepted == 0) {
+        stats.dt_min = 0.0;
+    }
+
+    return stats;
+}
+
+/**
+ * @brief      Advance the concentrations by a number of fixed time steps
+ *
+ * @param      a       Concentration of A
+ * @param      b       Concentration of B
+ * @param[in]  nsteps  Number of time steps
+ * @param[in]  dt      time step
+ * @param[in]  rate    Function that evaluates the time derivatives
+ * @param[in]  ncores  Number of threads
+ */
+void RungeKuttaIntegrator::advance_fixed(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps, double dt,
+                                         const RateFunction& rate, unsigned int ncores) {
+    omp_set_num_threads(ncores);
+
+    const unsigned int s = this->tableau.nstages;
+
+    for(unsigned int n=0; n<nsteps; n++) {
+        if(!this->k0_valid) {
+            rate(a, b, this->ka[0], this->kb[0]);
+        }
+
+        for(unsigned int i=1; i<s; i++) {
+            this->combine(a, b, &this->tableau.a[i * s], i, dt, this->ya, this->yb);
+            rate(this->ya, this->yb, this->ka[i], this->kb[i]);
+        }
+        this->combine(a, b, this->tableau.b.data(), s, dt, this->ya_new, this->yb_new);
+
+        a.swap(this->ya_new);
+        b.swap(this->yb_new);
+
+        if(this->tableau.fsal) {
+            this->ka[0].swap(this->ka[s-1]);
+            this->kb[0].swap(this->kb[s-1]);
+            this->k0_valid = true;
+        } else {
+            this->k0_valid = false;
+        }
+    }
+}
+
+/**
+ * @brief      Calculate u + h * sum_j c_j k_j for both species
+ *
+ * @param[in]  a       Current concentration of A
+ * @param[in]  b       Current concentration of B
+ * @param[in]  c       Coefficients of the stage derivatives
+ * @param[in]  nterms  Number of stage derivatives
+ * @param[in]  step    time step
+ * @param      out_a   Result for A
+ * @param      out_b   Result for B
+ */
+void RungeKuttaIntegrator::combine(const MatrixXXd& a, const MatrixXXd& b, const double* c, unsigned int nterms,
+                                   double step, MatrixXXd& out_a, MatrixXXd& out_b) {
+    const int ncells = a.size();
+
+    #pragma omp parallel for schedule(static)
+    for(int n=0; n<ncells; n++) {
+        double sa = 0.0;
+        double sb = 0.0;
+        for(unsigned int j=0; j<nterms; j++) {
+            sa += c[j] * this->ka[j].data()[n];
+            sb += c[j] * this->kb[j].data()[n];
+        }
+        out_a.data()[n] = a.data()[n] + step * sa;
+        out_b.data()[n] = b.data()[n] + step * sb;
+    }
+}
+
+/**
+ * @brief      Calculate the scaled root-mean-square norm of the error estimate
+ *
+ * @param[in]  a     Current concentration of A
+ * @param[in]  b     Current concentration of B
+ * @param[in]  step  time step
+ *
+ * @return     The error norm; the step is acceptable when it does not exceed one
+ */
+double RungeKuttaIntegrator::error_norm(const MatrixXXd& a, const MatrixXXd& b, double step) const {
+    const unsigned int s = this->tableau.nstages;
+    const int ncells = a.size();
+    const double* e = this->e.data();
+
+    double sum = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:sum)
+    for(int n=0; n<ncells; n++) {
+        double ea = 0.0;
+        double eb = 0.0;
+        for(unsigned int j=0; j<s; j++) {
+            ea += e[j] * this->ka[j].data()[n];
+            eb += e[j] * this->kb[j].data()[n];
+        }
+
+        const double sa = this->atol + this->rtol * std::max(std::abs(a.data()[n]), std::abs(this->ya_new.data()[n]));
+        const double sb = this->atol + this->rtol * std::max(std::abs(b.data()[n]), std::abs(this->yb_new.data()[n]));
+        const double ra = step * ea / sa;
+        const double rb = step * eb / sb;
+        sum += ra * ra + rb * rb;
+    }
+
+    return std::sqrt(sum / (2.0 * ncells));
+}
@@ -0,0 +1,210 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include <functional>
+
+#include "matrices.h"
+
+/**
+ * @brief      Function that evaluates the time derivatives of A and B
+ *
+ * The arguments are the concentrations of A and B and the matrices
+ * receiving their time derivatives.
+ */
+typedef std::function<void(const MatrixXXd& a, const MatrixXXd& b, MatrixXXd& da, MatrixXXd& db)> RateFunction;
+
+/**
+ * @brief      Butcher tableau of an explicit Runge-Kutta method with an embedded error estimate
+ */
+struct ButcherTableau {
+    unsigned int nstages;           //!< number of stages
+    std::vector<double> a;          //!< stage coefficients, row-major nstages x nstages (lower triangle)
+    std::vector<double> b;          //!< weights of the solution
+    std::vector<double> bhat;       //!< weights of the embedded solution; equal to b if there is none
+    unsigned int order;             //!< order of the error estimate plus one, used by the step size controller
+    bool fsal;                      //!< whether the last stage is evaluated at the new solution (first same as last)
+};
+
+/**
+ * @brief      Get Heun's second-order method
+ *
+ * @return     The tableau; without an embedded solution
+ */
+const ButcherTableau& get_tableau_heun();
+
+/**
+ * @brief      Get the classical fourth-order Runge-Kutta method
+ *
+ * @return     The tableau; without an embedded solution
+ */
+const ButcherTableau& get_tableau_rk4();
+
+/**
+ * @brief      Get the Heun-Euler 2(1) pair
+ *
+ * @return     The tableau
+ */
+const ButcherTableau& get_tableau_heun_euler();
+
+/**
+ * @brief      Get the Bogacki-Shampine 3(2) pair
+ *
+ * @return     The tableau
+ */
+const ButcherTableau& get_tableau_bogacki_shampine();
+
+/**
+ * @brief      Statistics of the adaptive time steps taken for a single frame
+ */
+struct StepStatistics {
+    unsigned int accepted = 0;  //!< number of accepted steps
+    unsigned int rejected = 0;  //!< number of rejected steps
+    double dt_min = 0.0;        //!< smallest accepted time step
+    double dt_max = 0.0;        //!< largest accepted time step
+};
+
+/**
+ * @brief      Explicit Runge-Kutta integrator with error-controlled time steps
+ *
+ * The local error is estimated from the difference between the solution and
+ * its embedded counterpart and measured in the root-mean-square norm,
+ * scaled by atol + rtol * |u|. The time step grows and shrinks with a
+ * standard controller. All stage buffers are allocated upon construction.
+ */
+class RungeKuttaIntegrator {
+private:
+    const ButcherTableau& tableau;  //!< coefficients of the method
+
+    double h;                       //!< proposed time step
+    double atol;                    //!< absolute tolerance
+    double rtol;                    //!< relative tolerance
+
+    std::vector<MatrixXXd> ka;      //!< stage derivatives of A
+    std::vector<MatrixXXd> kb;      //!< stage derivatives of B
+    MatrixXXd ya;                   //!< stage input of A
+    MatrixXXd yb;                   //!< stage input of B
+    MatrixXXd ya_new;               //!< candidate solution of A
+    MatrixXXd yb_new;               //!< candidate solution of B
+    std::vector<double> e;          //!< weights of the error estimate
+    bool k0_valid = false;          //!< whether the first stage holds the derivatives of the current state
+
+    static constexpr double safety = 0.9;   //!< safety factor of the step size controller
+    static constexpr double facmin = 0.2;   //!< largest decrease of the time step
+    static constexpr double facmax = 5.0;   //!< largest increase of the time step
+    static constexpr double hmin = 1e-12;   //!< smallest time step relative to the time span
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _tableau  Coefficients of the method
+     * @param[in]  width     width of the system
+     * @param[in]  height    height of the system
+     * @param[in]  dt        initial time step
+     * @param[in]  _atol     absolute tolerance
+     * @param[in]  _rtol     relative tolerance
+     */
+    RungeKuttaIntegrator(const ButcherTableau& _tableau, unsigned int width, unsigned int height,
+                         double dt, double _atol, double _rtol);
+
+    /**
+     * @brief      Advance the concentrations over a time span
+     *
+     * The last step is shortened to end exactly at the end of the span; the
+     * step size proposed by the controller is retained for the next span.
+     * A step with a non-finite error estimate is rejected; a runtime_error
+     * is thrown when the step size drops below hmin times the span.
+     *
+     * @param      a       Concentration of A
+     * @param      b       Concentration of B
+     * @param[in]  tspan   time span
+     * @param[in]  rate    Function that evaluates the time derivatives
+     * @param[in]  ncores  Number of threads
+     *
+     * @return     Statistics of the steps taken
+     */
+    StepStatistics advance(MatrixXXd& a, MatrixXXd& b, double tspan,
+                           const RateFunction& rate, unsigned int ncores);
+
+    /**
+     * @brief      Advance the concentrations by a number of fixed time steps
+     *
+     * The error estimate is not evaluated and the tolerances are ignored,
+     * such that methods without an embedded solution can be used.
+     *
+     * @param      a       Concentration of A
+     * @param      b       Concentration of B
+     * @param[in]  nsteps  Number of time steps
+     * @param[in]  dt      time step
+     * @param[in]  rate    Function that evaluates the time derivatives
+     * @param[in]  ncores  Number of threads
+     */
+    void advance_fixed(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps, double dt,
+                       const RateFunction& rate, unsigned int ncores);
+
+    /**
+     * @brief      Get the currently proposed time step
+     *
+     * @return     The time step
+     */
+    inline double get_dt() const {
+        return this->h;
+    }
+
+    /**
+     * @brief      Set the proposed time step, e.g. when resuming a run
+     *
+     * @param[in]  _h    The time step
+     */
+    inline void set_dt(double _h) {
+        this->h = _h;
+    }
+
+private:
+    /**
+     * @brief      Calculate u + h * sum_j c_j k_j for both species
+     *
+     * @param[in]  a       Current concentration of A
+     * @param[in]  b       Current concentration of B
+     * @param[in]  c       Coefficients of the stage derivatives
+     * @param[in]  nterms  Number of stage derivatives
+     * @param[in]  step    time step
+     * @param      out_a   Result for A
+     * @param      out_b   Result for B
+     */
+    void combine(const MatrixXXd& a, const MatrixXXd& b, const double* c, unsigned int nterms,
+                 double step, MatrixXXd& out_a, MatrixXXd& out_b);
+
+    /**
+     * @brief      Calculate the scaled root-mean-square norm of the error estimate
+     *
+     * @param[in]  a     Current concentration of A
+     * @param[in]  b     Current concentration of B
+     * @param[in]  step  time step
+     *
+     * @return     The error norm; the step is acceptable when it does not exceed one
+     */
+    double error_norm(const MatrixXXd& a, const MatrixXXd& b, double step) const;
+};
@@ -0,0 +1,508 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+// M_PI on MSVC
+#define _USE_MATH_DEFINES
+
+#include "spectral.h"
+
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <omp.h>
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _width   width of the system
+ * @param[in]  _height  height of the system
+ * @param[in]  dx       size of the space interval
+ * @param[in]  dt       size of the time interval
+ * @param[in]  Da       Diffusion coefficient of compound A
+ * @param[in]  Db       Diffusion coefficient of compound B
+ * @param[in]  _pbc     Whether to employ periodic boundary conditions
+ * @param[in]  _scheme  Exponential time differencing scheme
+ * @param[in]  _stencil Finite-difference stencil of the Laplacian
+ */
+SpectralIntegrator::SpectralIntegrator(unsigned int _width, unsigned int _height,
+                                       double dx, double dt, double Da, double Db,
+                                       bool _pbc, TIME_INTEGRATOR _scheme, STENCIL _stencil) :
+    width(_width),
+    height(_height),
+    scheme(_scheme),
+    pbc(_pbc),
+    stencil(_stencil) {
+
+    if(this->scheme == TIME_INTEGRATOR::EULER) {
+        throw std::logic_error("Explicit Euler is not a spectral integrator.");
+    }
+
+    this->ncells = (size_t)this->width * this->height;
+    if(this->pbc) {
+        // real-to-complex transforms only store half of the modes along the rows
+        this->nmodes = (size_t)this->height * (this->width / 2 + 1);
+        this->stride = 2;
+        this->norm = (double)this->ncells;
+    } else {
+        this->nmodes = this->ncells;
+        this->stride = 1;
+        this->norm = 4.0 * (double)this->ncells;
+    }
+
+    const size_t nspec = this->nmodes * this->stride;
+    for(unsigned int s=0; s<2; s++) {
+        this->u[s] = fftw_alloc_real(this->ncells);
+        this->stage[s] = fftw_alloc_real(this->ncells);
+        this->react[s] = fftw_alloc_real(this->ncells);
+        this->uh[s] = fftw_alloc_real(nspec);
+        this->ah[s] = fftw_alloc_real(nspec);
+        this->sh[s] = fftw_alloc_real(nspec);
+        this->nu[s] = fftw_alloc_real(nspec);
+        this->nx[s] = fftw_alloc_real(nspec);
+        this->acc[s] = fftw_alloc_real(nspec);
+    }
+    this->scratch = fftw_alloc_real(nspec);
+
+    // all buffers are allocated by FFTW and share their alignment, such that
+    // the plans can be executed on any of them
+    if(this->pbc) {
+        this->plan_forward = fftw_plan_dft_r2c_2d(this->height, this->width, this->u[0],
+                                                  (fftw_complex*)this->uh[0], FFTW_MEASURE);
+        this->plan_inverse = fftw_plan_dft_c2r_2d(this->height, this->width, (fftw_complex*)this->scratch,
+                                                  this->u[0], FFTW_MEASURE);
+    } else {
+        this->plan_forward = fftw_plan_r2r_2d(this->height, this->width, this->u[0], this->uh[0],
+                                              FFTW_REDFT10, FFTW_REDFT10, FFTW_MEASURE);
+        this->plan_inverse = fftw_plan_r2r_2d(this->height, this->width, this->scratch, this->u[0],
+                                              FFTW_REDFT01, FFTW_REDFT01, FFTW_MEASURE);
+    }
+
+    if(this->plan_forward == nullptr || this->plan_inverse == nullptr) {
+        throw std::runtime_error("Could not create the FFTW plans of the spectral integrator.");
+    }
+
+    this->build_coefficients(dx, dt, Da, Db);
+}
+
+/**
+ * @brief      Destroys the object.
+ */
+SpectralIntegrator::~SpectralIntegrator() {
+    if(this->plan_forward != nullptr) {
+        fftw_destroy_plan(this->plan_forward);
+    }
+    if(this->plan_inverse != nullptr) {
+        fftw_destroy_plan(this->plan_inverse);
+    }
+
+    for(unsigned int s=0; s<2; s++) {
+        fftw_free(this->u[s]);
+        fftw_free(this->stage[s]);
+        fftw_free(this->react[s]);
+        fftw_free(this->uh[s]);
+        fftw_free(this->ah[s]);
+        fftw_free(this->sh[s]);
+        fftw_free(this->nu[s]);
+        fftw_free(this->nx[s]);
+        fftw_free(this->acc[s]);
+    }
+    fftw_free(this->scratch);
+}
+
+/**
+ * @brief      Advance the concentrations by a number of time steps
+ *
+ * @param      a         Concentration of A
+ * @param      b         Concentration of B
+ * @param[in]  nsteps    Number of time steps
+ * @param[in]  reaction  Function that evaluates the reaction terms
+ * @param[in]  ncores    Number of threads
+ */
+void SpectralIntegrator::advance(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps,
+                                 const ReactionTerms& reaction, unsigned int ncores) {
+    omp_set_num_threads(ncores);
+
+    // the state is kept both in real space and in the spectral domain
+    std::copy(a.data(), a.data() + this->ncells, this->u[0]);
+    std::copy(b.data(), b.data() + this->ncells, this->u[1]);
+    for(unsigned int s=0; s<2; s++) {
+        this->forward(this->u[s], this->uh[s]);
+    }
+
+    for(unsigned int j=0; j<nsteps; j++) {
+        switch(this->scheme) {
+            case TIME_INTEGRATOR::ETD1:
+                this->step_etd1(reaction);
+            break;
+            case TIME_INTEGRATOR::ETDRK2:
+                this->step_etdrk2(reaction);
+            break;
+            case TIME_INTEGRATOR::ETDRK4:
+                this->step_etdrk4(reaction);
+            break;
+            default:
+                throw std::logic_error("Invalid spectral integrator encountered.");
+            break;
+        }
+    }
+
+    std::copy(this->u[0], this->u[0] + this->ncells, a.data());
+    std::copy(this->u[1], this->u[1] + this->ncells, b.data());
+}
+
+/**
+ * @brief      Calculate the per-mode coefficients of the scheme
+ *
+ * With z = dt * D * lambda, the coefficients are (all multiplied by dt
+ * except the exponentials):
+ *
+ *   ETD1:   exp(z), phi1(z)
+ *   ETDRK2: exp(z), phi1(z), phi2(z)
+ *   ETDRK4: exp(z), exp(z/2), Q(z), f1(z), f2(z), f3(z)
+ *
+ * @param[in]  dx    size of the space interval
+ * @param[in]  dt    size of the time interval
+ * @param[in]  Da    Diffusion coefficient of compound A
+ * @param[in]  Db    Diffusion coefficient of compound B
+ */
+void SpectralIntegrator::build_coefficients(double dx, double dt, double Da, double Db) {
+    typedef std::complex<double> cplx;
+
+    // mean over points on a unit circle around z; this avoids the
+    // cancellation of the closed-form expressions for small z
+    static const unsigned int npoints = 32;
+    const auto contour_mean = [](double z, const std::function<cplx(cplx)>& f) {
+        cplx sum = 0.0;
+        for(unsigned int k=0; k<npoints; k++) {
+            const cplx w = z + std::exp(cplx(0.0, 2.0 * M_PI * (k + 0.5) / npoints));
+            sum += f(w);
+        }
+        return sum.real() / (double)npoints;
+    };
+
+    const unsigned int ncoeff = (this->scheme == TIME_INTEGRATOR::ETDRK4) ? 6 :
+                                (this->scheme == TIME_INTEGRATOR::ETDRK2) ? 3 : 2;
+    const double D[2] = {Da, Db};
+
+    for(unsigned int s=0; s<2; s++) {
+        MatrixXXd& c = this->coefficients[s];
+        c = MatrixXXd::Zero(this->nmodes, ncoeff);
+
+        for(size_t m=0; m<this->nmodes; m++) {
+            const double z = dt * D[s] * this->laplacian_eigenvalue(m, dx);
+
+            c(m,0) = std::exp(z);
+            if(this->scheme == TIME_INTEGRATOR::ETDRK4) {
+                c(m,1) = std::exp(0.5 * z);
+                c(m,2) = dt * contour_mean(z, [](cplx w) {
+                    return (std::exp(0.5 * w) - 1.0) / w;
+                });
+                c(m,3) = dt * contour_mean(z, [](cplx w) {
+                    return (-4.0 - w + std::exp(w) * (4.0 - 3.0 * w + w * w)) / (w * w * w);
+                });
+                c(m,4) = dt * contour_mean(z, [](cplx w) {
+                    return (2.0 + w + std::exp(w) * (-2.0 + w)) / (w * w * w);
+                });
+                c(m,5) = dt * contour_mean(z, [](cplx w) {
+                    return (-4.0 - 3.0 * w - w * w + std::exp(w) * (4.0 - w)) / (w * w * w);
+                });
+            } else {
+                c(m,1) = dt * contour_mean(z, [](cplx w) {
+                    return (std::exp(w) - 1.0) / w;
+                });
+                if(this->scheme == TIME_INTEGRATOR::ETDRK2) {
+                    c(m,2) = dt * contour_mean(z, [](cplx w) {
+                        return (std::exp(w) - 1.0 - w) / (w * w);
+                    });
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Get the eigenvalue of the discrete Laplacian of a spectral mode
+ *
+ * With s = sin(theta / 2) for the wave number theta along an axis, the
+ * second-order difference has the eigenvalue -4 s^2 / dx^2 and the
+ * fourth-order difference -(4 s^2 + 4/3 s^4) / dx^2. The nine-point
+ * stencil adds the product of the second-order differences along both
+ * axes times dx^2 / 6.
+ *
+ * @param[in]  m     Mode index
+ * @param[in]  dx    size of the space interval
+ *
+ * @return     The eigenvalue
+ */
+double SpectralIntegrator::laplacian_eigenvalue(size_t m, double dx) const {
+    double sy = 0.0;
+    double sx = 0.0;
+    if(this->pbc) {
+        const size_t ncols = this->width / 2 + 1;
+        sy = std::sin(M_PI * (double)(m / ncols) / (double)this->height);
+        sx = std::sin(M_PI * (double)(m % ncols) / (double)this->width);
+    } else {
+        sy = std::sin(0.5 * M_PI * (double)(m / this->width) / (double)this->height);
+        sx = std::sin(0.5 * M_PI * (double)(m % this->width) / (double)this->width);
+    }
+
+    const double idx2 = 1.0 / (dx * dx);
+    const double ly = -4.0 * sy * sy * idx2;
+    const double lx = -4.0 * sx * sx * idx2;
+    switch(this->stencil) {
+        case STENCIL::NINE_POINT:
+            return ly + lx + ly * lx * dx * dx / 6.0;
+        case STENCIL::FOURTH_ORDER:
+            return ly + lx - 4.0 / 3.0 * (sy * sy * sy * sy + sx * sx * sx * sx) * idx2;
+        default:
+            return ly + lx;
+    }
+}
+
+/**
+ * @brief      Transform a real-space array to the spectral domain
+ *
+ * @param[in]  in    Real-space array
+ * @param      out   Spectral array
+ */
+void SpectralIntegrator::forward(double* in, double* out) {
+    if(this->pbc) {
+        fftw_execute_dft_r2c(this->plan_forward, in, (fftw_complex*)out);
+    } else {
+        fftw_execute_r2r(this->plan_forward, in, out);
+    }
+}
+
+/**
+ * @brief      Transform a spectral array to real space, including normalization
+ *
+ * @param[in]  in    Spectral array
+ * @param      out   Real-space array
+ */
+void SpectralIntegrator::inverse(const double* in, double* out) {
+    // the complex-to-real transform destroys its input
+    const double scale = 1.0 / this->norm;
+    const int nspec = this->nmodes * this->stride;
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<nspec; i++) {
+        this->scratch[i] = in[i] * scale;
+    }
+
+    if(this->pbc) {
+        fftw_execute_dft_c2r(this->plan_inverse, (fftw_complex*)this->scratch, out);
+    } else {
+        fftw_execute_r2r(this->plan_inverse, this->scratch, out);
+    }
+}
+
+/**
+ * @brief      Evaluate the reaction terms and transform them to the spectral domain
+ *
+ * @param      in        Real-space concentrations of A and B
+ * @param      out       Spectral reaction terms of A and B
+ * @param[in]  reaction  Function that evaluates the reaction terms
+ */
+void SpectralIntegrator::evaluate(double* const in[2], double* const out[2], const ReactionTerms& reaction) {
+    reaction(in[0], in[1], this->react[0], this->react[1]);
+    for(unsigned int s=0; s<2; s++) {
+        this->forward(this->react[s], out[s]);
+    }
+}
+
+/**
+ * @brief      Perform a first-order exponential time differencing step
+ *
+ *   u(n+1) = exp(z) u(n) + dt phi1(z) N(u(n))
+ *
+ * @param[in]  reaction  Function that evaluates the reaction terms
+ */
+void SpectralIntegrator::step_etd1(const ReactionTerms& reaction) {
+    this->evaluate(this->u, this->nu, reaction);
+
+    const int nmodes = this->nmodes;
+    const unsigned int stride = this->stride;
+    for(unsigned int s=0; s<2; s++) {
+        const MatrixXXd& c = this->coefficients[s];
+        double* uh = this->uh[s];
+        const double* nu = this->nu[s];
+
+        #pragma omp parallel for schedule(static)
+        for(int m=0; m<nmodes; m++) {
+            for(unsigned int r=0; r<stride; r++) {
+                const size_t i = m * stride + r;
+                uh[i] = c(m,0) * uh[i] + c(m,1) * nu[i];
+            }
+        }
+
+        this->inverse(uh, this->u[s]);
+    }
+}
+
+/**
+ * @brief      Perform a second-order exponential Runge-Kutta step (Cox & Matthews)
+ *
+ *   a      = exp(z) u(n) + dt phi1(z) N(u(n))
+ *   u(n+1) = a + dt phi2(z) (N(a) - N(u(n)))
+ *
+ * @param[in]  reaction  Function that evaluates the reaction terms
+ */
+void SpectralIntegrator::step_etdrk2(const ReactionTerms& reaction) {
+    const int nmodes = this->nmodes;
+    const unsigned int stride = this->stride;
+
+    this->evaluate(this->u, this->nu, reaction);
+    for(unsigned int s=0; s<2; s++) {
+        const MatrixXXd& c = this->coefficients[s];
+        const double* uh = this->uh[s];
+        const double* nu = this->nu[s];
+        double* ah = this->ah[s];
+
+        #pragma omp parallel for schedule(static)
+        for(int m=0; m<nmodes; m++) {
+            for(unsigned int r=0; r<stride; r++) {
+                const size_t i = m * stride + r;
+                ah[i] = c(m,0) * uh[i] + c(m,1) * nu[i];
+            }
+        }
+
+        this->inverse(ah, this->stage[s]);
+    }
+
+    this->evaluate(this->stage, this->nx, reaction);
+    for(unsigned int s=0; s<2; s++) {
+        const MatrixXXd& c = this->coefficients[s];
+        double* uh = this->uh[s];
+        const double* ah = this->ah[s];
+        const double* nu = this->nu[s];
+        const double* na = this->nx[s];
+
+        #pragma omp parallel for schedule(static)
+        for(int m=0; m<nmodes; m++) {
+            for(unsigned int r=0; r<stride; r++) {
+                const size_t i = m * stride + r;
+                uh[i] = ah[i] + c(m,2) * (na[i] - nu[i]);
+            }
+        }
+
+        this->inverse(uh, this->u[s]);
+    }
+}
+
+/**
+ * @brief      Perform a fourth-order exponential Runge-Kutta step (Cox & Matthews)
+ *
+ *   a      = exp(z/2) u(n) + Q N(u(n))
+ *   b      = exp(z/2) u(n) + Q N(a)
+ *   c      = exp(z/2) a + Q (2 N(b) - N(u(n)))
+ *   u(n+1) = exp(z) u(n) + f1 N(u(n)) + 2 f2 (N(a) + N(b)) + f3 N(c)
+ *
+ * The final update is accumulated while the stages are evaluated.
+ *
+ * @param[in]  reaction  Function that evaluates the reaction terms
+ */
+void SpectralIntegrator::step_etdrk4(const ReactionTerms& reaction) {
+    const int nmodes = this->nmodes;
+    const unsigned int stride = this->stride;
+
+    // first stage
+    this->evaluate(this->u, this->nu, reaction);
+    for(unsigned int s=0; s<2; s++) {
+        const MatrixXXd& c = this->coefficients[s];
+        const double* uh = this->uh[s];
+        const double* nu = this->nu[s];
+        double* ah = this->ah[s];
+        double* acc = this->acc[s];
+
+        #pragma omp parallel for schedule(static)
+        for(int m=0; m<nmodes; m++) {
+            for(unsigned int r=0; r<stride; r++) {
+                const size_t i = m * stride + r;
+                ah[i] = c(m,1) * uh[i] + c(m,2) * nu[i];
+                acc[i] = c(m,0) * uh[i] + c(m,3) * nu[i];
+            }
+        }
+
+        this->inverse(ah, this->stage[s]);
+    }
+
+    // second stage
+    this->evaluate(this->stage, this->nx, reaction);
+    for(unsigned int s=0; s<2; s++) {
+        const MatrixXXd& c = this->coefficients[s];
+        const double* uh = this->uh[s];
+        const double* na = this->nx[s];
+        double* bh = this->sh[s];
+        double* acc = this->acc[s];
+
+        #pragma omp parallel for schedule(static)
+        for(int m=0; m<nmodes; m++) {
+            for(unsigned int r=0; r<stride; r++) {
+                const size_t i = m * stride + r;
+                bh[i] = c(m,1) * uh[i] + c(m,2) * na[i];
+                acc[i] += 2.0 * c(m,4) * na[i];
+            }
+        }
+
+        this->inverse(bh, this->stage[s]);
+    }
+
+    // third stage
+    this->evaluate(this->stage, this->nx, reaction);
+    for(unsigned int s=0; s<2; s++) {
+        const MatrixXXd& c = this->coefficients[s];
+        const double* ah = this->ah[s];
+        const double* nu = this->nu[s];
+        const double* nb = this->nx[s];
+        double* ch = this->sh[s];
+        double* acc = this->acc[s];
+
+        #pragma omp parallel for schedule(static)
+        for(int m=0; m<nmodes; m++) {
+            for(unsigned int r=0; r<stride; r++) {
+                const size_t i = m * stride + r;
+                ch[i] = c(m,1) * ah[i] + c(m,2) * (2.0 * nb[i] - nu[i]);
+                acc[i] += 2.0 * c(m,4) * nb[i];
+            }
+        }
+
+        this->inverse(ch, this->stage[s]);
+    }
+
+    // final update
+    this->evaluate(this->stage, this->nx, reaction);
+    for(unsigned int s=0; s<2; s++) {
+        const MatrixXXd& c = this->coefficients[s];
+        const double* nc = this->nx[s];
+        const double* acc = this->acc[s];
+        double* uh = this->uh[s];
+
+        #pragma omp parallel for schedule(static)
+        for(int m=0; m<nmodes; m++) {
+            for(unsigned int r=0; r<stride; r++) {
+                const size_t i = m * stride + r;
+                uh[i] = acc[i] + c(m,5) * nc[i];
+            }
+        }
+
+        this->inverse(uh, this->u[s]);
+    }
+}
@@ -0,0 +1,190 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <fftw3.h>
+
+#include "config.h"
+#include "matrices.h"
+#include "stencil_kernels.h"
+
+/**
+ * @brief      Function that evaluates the reaction terms of all cells
+ *
+ * The arguments are the concentrations of A and B and the reaction terms
+ * of A and B, all stored as row-major arrays covering the whole grid.
+ */
+typedef std::function<void(const double* a, const double* b, double* ra, double* rb)> ReactionTerms;
+
+/**
+ * @brief      Exponential time differencing integrator in the spectral domain
+ *
+ * The diffusion terms are diagonal in the eigenbasis of the discrete
+ * Laplacian and are integrated exactly, such that the time step is
+ * no longer bound by the diffusive stability limit of explicit Euler. The
+ * reaction terms are evaluated in real space. Periodic boundary conditions
+ * use real-to-complex Fourier transforms and zero-flux boundary conditions
+ * use the discrete cosine transform (DCT-II forward, DCT-III backward),
+ * which diagonalizes the cell-centered zero-flux stencils: their mirrored
+ * edges are the even extension of the cosine modes. The coefficients
+ * of the ETD schemes are evaluated by contour integrals (Kassam & Trefethen)
+ * to avoid cancellation for slowly decaying modes.
+ */
+class SpectralIntegrator {
+private:
+    unsigned int width;         //!< width of the system
+    unsigned int height;        //!< height of the system
+    TIME_INTEGRATOR scheme;     //!< exponential time differencing scheme
+    bool pbc;                   //!< whether to employ periodic boundary conditions
+    STENCIL stencil;            //!< finite-difference stencil of the Laplacian
+
+    size_t ncells;              //!< number of grid cells
+    size_t nmodes;              //!< number of spectral modes
+    unsigned int stride;        //!< number of doubles per spectral mode (two for complex modes)
+    double norm;                //!< normalization of a forward and backward transform
+
+    fftw_plan plan_forward = nullptr;   //!< transform to the spectral domain
+    fftw_plan plan_inverse = nullptr;   //!< transform to real space
+
+    double* u[2];           //!< state of A and B in real space
+    double* stage[2];       //!< intermediate stage of A and B in real space
+    double* react[2];       //!< reaction terms of A and B in real space
+
+    double* uh[2];          //!< state of A and B in the spectral domain
+    double* ah[2];          //!< first stage of A and B in the spectral domain
+    double* sh[2];          //!< later stages of A and B in the spectral domain
+    double* nu[2];          //!< reaction terms at the start of the step in the spectral domain
+    double* nx[2];          //!< reaction terms at the current stage in the spectral domain
+    double* acc[2];         //!< accumulated update of A and B in the spectral domain
+    double* scratch;        //!< input of the backward transform, which may be destroyed
+
+    MatrixXXd coefficients[2];  //!< per-mode coefficients of the scheme for A and B
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _width   width of the system
+     * @param[in]  _height  height of the system
+     * @param[in]  dx       size of the space interval
+     * @param[in]  dt       size of the time interval
+     * @param[in]  Da       Diffusion coefficient of compound A
+     * @param[in]  Db       Diffusion coefficient of compound B
+     * @param[in]  _pbc     Whether to employ periodic boundary conditions
+     * @param[in]  _scheme  Exponential time differencing scheme
+     * @param[in]  _stencil Finite-difference stencil of the Laplacian
+     */
+    SpectralIntegrator(unsigned int _width, unsigned int _height,
+                       double dx, double dt, double Da, double Db,
+                       bool _pbc, TIME_INTEGRATOR _scheme,
+                       STENCIL _stencil = STENCIL::FIVE_POINT);
+
+    /**
+     * @brief      Destroys the object.
+     */
+    ~SpectralIntegrator();
+
+    SpectralIntegrator(const SpectralIntegrator&) = delete;
+    SpectralIntegrator& operator=(const SpectralIntegrator&) = delete;
+
+    /**
+     * @brief      Advance the concentrations by a number of time steps
+     *
+     * @param      a         Concentration of A
+     * @param      b         Concentration of B
+     * @param[in]  nsteps    Number of time steps
+     * @param[in]  reaction  Function that evaluates the reaction terms
+     * @param[in]  ncores    Number of threads
+     */
+    void advance(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps,
+                 const ReactionTerms& reaction, unsigned int ncores);
+
+private:
+    /**
+     * @brief      Calculate the per-mode coefficients of the scheme
+     *
+     * @param[in]  dx    size of the space interval
+     * @param[in]  dt    size of the time interval
+     * @param[in]  Da    Diffusion coefficient of compound A
+     * @param[in]  Db    Diffusion coefficient of compound B
+     */
+    void build_coefficients(double dx, double dt, double Da, double Db);
+
+    /**
+     * @brief      Get the eigenvalue of the discrete Laplacian of a spectral mode
+     *
+     * @param[in]  m     Mode index
+     * @param[in]  dx    size of the space interval
+     *
+     * @return     The eigenvalue
+     */
+    double laplacian_eigenvalue(size_t m, double dx) const;
+
+    /**
+     * @brief      Transform a real-space array to the spectral domain
+     *
+     * @param[in]  in    Real-space array
+     * @param      out   Spectral array
+     */
+    void forward(double* in, double* out);
+
+    /**
+     * @brief      Transform a spectral array to real space, including normalization
+     *
+     * @param[in]  in    Spectral array
+     * @param      out   Real-space array
+     */
+    void inverse(const double* in, double* out);
+
+    /**
+     * @brief      Evaluate the reaction terms and transform them to the spectral domain
+     *
+     * @param      in        Real-space concentrations of A and B
+     * @param      out       Spectral reaction terms of A and B
+     * @param[in]  reaction  Function that evaluates the reaction terms
+     */
+    void evaluate(double* const in[2], double* const out[2], const ReactionTerms& reaction);
+
+    /**
+     * @brief      Perform a first-order exponential time differencing step
+     *
+     * @param[in]  reaction  Function that evaluates the reaction terms
+     */
+    void step_etd1(const ReactionTerms& reaction);
+
+    /**
+     * @brief      Perform a second-order exponential Runge-Kutta step (Cox & Matthews)
+     *
+     * @param[in]  reaction  Function that evaluates the reaction terms
+     */
+    void step_etdrk2(const ReactionTerms& reaction);
+
+    /**
+     * @brief      Perform a fourth-order exponential Runge-Kutta step (Cox & Matthews)
+     *
+     * @param[in]  reaction  Function that evaluates the reaction terms
+     */
+    void step_etdrk4(const ReactionTerms& reaction);
+};
@@ -0,0 +1,739 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#include "stencil_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LAFLUXXY_X86
+#include <immintrin.h>
+#endif
+
+// The project is compiled for the baseline instruction set such that a
+// single binary runs on every machine; the kernels below are compiled for
+// their own instruction set and only called when the CPU supports it.
+#if defined(_MSC_VER)
+#define LAFLUXXY_TARGET(isa)
+#else
+#define LAFLUXXY_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/**
+ * @brief      Laplacian on the interior of a row, portable version
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+static void laplacian_interior_generic(T* lap, const T* prev, const T* cur,
+                                       const T* next, unsigned int ncols, T idx2) {
+    for(unsigned int j=1; j<ncols-1; j++) {
+        lap[j] = ((T)-4.0 * cur[j] + prev[j] + next[j] + cur[j-1] + cur[j+1]) * idx2;
+    }
+}
+
+/**
+ * @brief      Nine-point Laplacian on the interior of a row, portable version
+ *
+ * The loop is written such that the compiler vectorizes it for the
+ * baseline instruction set.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+static inline void nine_point_interior_generic(T* lap, const T* prev, const T* cur,
+                                               const T* next, unsigned int ncols, T idx2) {
+    const T w = idx2 / (T)6.0;
+
+    #pragma omp simd
+    for(unsigned int j=1; j<ncols-1; j++) {
+        lap[j] = ((T)4.0 * (prev[j] + next[j] + cur[j-1] + cur[j+1]) +
+                  (prev[j-1] + prev[j+1] + next[j-1] + next[j+1]) -
+                  (T)20.0 * cur[j]) * w;
+    }
+}
+
+/**
+ * @brief      Fourth-order Laplacian on the interior of a row, portable version
+ *
+ * The loop is written such that the compiler vectorizes it for the
+ * baseline instruction set.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+static inline void fourth_order_interior_generic(T* lap, const T* prev2, const T* prev, const T* cur,
+                                                 const T* next, const T* next2, unsigned int ncols, T idx2) {
+    const T w = idx2 / (T)12.0;
+
+    #pragma omp simd
+    for(unsigned int j=2; j<ncols-2; j++) {
+        lap[j] = ((T)16.0 * (prev[j] + next[j] + cur[j-1] + cur[j+1]) -
+                  (prev2[j] + next2[j] + cur[j-2] + cur[j+2]) -
+                  (T)60.0 * cur[j]) * w;
+    }
+}
+
+#ifdef LAFLUXXY_X86
+/**
+ * @brief      Laplacian on the interior of a row using SSE4.2
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("sse4.2")
+static void laplacian_interior_sse42(double* lap, const double* prev, const double* cur,
+                                     const double* next, unsigned int ncols, double idx2) {
+    const __m128d vidx2 = _mm_set1_pd(idx2);
+    const __m128d vfour = _mm_set1_pd(4.0);
+
+    unsigned int j = 1;
+    for(; j + 2 <= ncols - 1; j += 2) {
+        const __m128d c = _mm_loadu_pd(cur + j);
+        __m128d s = _mm_add_pd(_mm_loadu_pd(prev + j), _mm_loadu_pd(next + j));
+        s = _mm_add_pd(s, _mm_add_pd(_mm_loadu_pd(cur + j - 1), _mm_loadu_pd(cur + j + 1)));
+        s = _mm_sub_pd(s, _mm_mul_pd(vfour, c));
+        _mm_storeu_pd(lap + j, _mm_mul_pd(s, vidx2));
+    }
+
+    for(; j<ncols-1; j++) {
+        lap[j] = (-4.0 * cur[j] + prev[j] + next[j] + cur[j-1] + cur[j+1]) * idx2;
+    }
+}
+
+/**
+ * @brief      Laplacian on the interior of a row using AVX2 and FMA
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx2,fma")
+static void laplacian_interior_avx2(double* lap, const double* prev, const double* cur,
+                                    const double* next, unsigned int ncols, double idx2) {
+    const __m256d vidx2 = _mm256_set1_pd(idx2);
+    const __m256d vmfour = _mm256_set1_pd(-4.0);
+
+    unsigned int j = 1;
+    for(; j + 4 <= ncols - 1; j += 4) {
+        const __m256d c = _mm256_loadu_pd(cur + j);
+        __m256d s = _mm256_add_pd(_mm256_loadu_pd(prev + j), _mm256_loadu_pd(next + j));
+        s = _mm256_add_pd(s, _mm256_add_pd(_mm256_loadu_pd(cur + j - 1), _mm256_loadu_pd(cur + j + 1)));
+        s = _mm256_fmadd_pd(vmfour, c, s);
+        _mm256_storeu_pd(lap + j, _mm256_mul_pd(s, vidx2));
+    }
+
+    for(; j<ncols-1; j++) {
+        lap[j] = (-4.0 * cur[j] + prev[j] + next[j] + cur[j-1] + cur[j+1]) * idx2;
+    }
+}
+
+/**
+ * @brief      Laplacian on the interior of a row using AVX-512
+ *
+ * The remainder of the row is handled with a masked load and store.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx512f")
+static void laplacian_interior_avx512(double* lap, const double* prev, const double* cur,
+                                      const double* next, unsigned int ncols, double idx2) {
+    const __m512d vidx2 = _mm512_set1_pd(idx2);
+    const __m512d vmfour = _mm512_set1_pd(-4.0);
+
+    unsigned int j = 1;
+    for(; j + 8 <= ncols - 1; j += 8) {
+        const __m512d c = _mm512_loadu_pd(cur + j);
+        __m512d s = _mm512_add_pd(_mm512_loadu_pd(prev + j), _mm512_loadu_pd(next + j));
+        s = _mm512_add_pd(s, _mm512_add_pd(_mm512_loadu_pd(cur + j - 1), _mm512_loadu_pd(cur + j + 1)));
+        s = _mm512_fmadd_pd(vmfour, c, s);
+        _mm512_storeu_pd(lap + j, _mm512_mul_pd(s, vidx2));
+    }
+
+    if(j < ncols - 1) {
+        const __mmask8 m = (__mmask8)((1u << (ncols - 1 - j)) - 1);
+        const __m512d c = _mm512_maskz_loadu_pd(m, cur + j);
+        __m512d s = _mm512_add_pd(_mm512_maskz_loadu_pd(m, prev + j), _mm512_maskz_loadu_pd(m, next + j));
+        s = _mm512_add_pd(s, _mm512_add_pd(_mm512_maskz_loadu_pd(m, cur + j - 1), _mm512_maskz_loadu_pd(m, cur + j + 1)));
+        s = _mm512_fmadd_pd(vmfour, c, s);
+        _mm512_mask_storeu_pd(lap + j, m, _mm512_mul_pd(s, vidx2));
+    }
+}
+
+/**
+ * @brief      Laplacian on the interior of a row using SSE4.2, single precision
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("sse4.2")
+static void laplacian_interior_sse42_float(float* lap, const float* prev, const float* cur,
+                                           const float* next, unsigned int ncols, float idx2) {
+    const __m128 vidx2 = _mm_set1_ps(idx2);
+    const __m128 vfour = _mm_set1_ps(4.0f);
+
+    unsigned int j = 1;
+    for(; j + 4 <= ncols - 1; j += 4) {
+        const __m128 c = _mm_loadu_ps(cur + j);
+        __m128 s = _mm_add_ps(_mm_loadu_ps(prev + j), _mm_loadu_ps(next + j));
+        s = _mm_add_ps(s, _mm_add_ps(_mm_loadu_ps(cur + j - 1), _mm_loadu_ps(cur + j + 1)));
+        s = _mm_sub_ps(s, _mm_mul_ps(vfour, c));
+        _mm_storeu_ps(lap + j, _mm_mul_ps(s, vidx2));
+    }
+
+    for(; j<ncols-1; j++) {
+        lap[j] = (-4.0f * cur[j] + prev[j] + next[j] + cur[j-1] + cur[j+1]) * idx2;
+    }
+}
+
+/**
+ * @brief      Laplacian on the interior of a row using AVX2 and FMA, single precision
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx2,fma")
+static void laplacian_interior_avx2_float(float* lap, const float* prev, const float* cur,
+                                          const float* next, unsigned int ncols, float idx2) {
+    const __m256 vidx2 = _mm256_set1_ps(idx2);
+    const __m256 vmfour = _mm256_set1_ps(-4.0f);
+
+    unsigned int j = 1;
+    for(; j + 8 <= ncols - 1; j += 8) {
+        const __m256 c = _mm256_loadu_ps(cur + j);
+        __m256 s = _mm256_add_ps(_mm256_loadu_ps(prev + j), _mm256_loadu_ps(next + j));
+        s = _mm256_add_ps(s, _mm256_add_ps(_mm256_loadu_ps(cur + j - 1), _mm256_loadu_ps(cur + j + 1)));
+        s = _mm256_fmadd_ps(vmfour, c, s);
+        _mm256_storeu_ps(lap + j, _mm256_mul_ps(s, vidx2));
+    }
+
+    for(; j<ncols-1; j++) {
+        lap[j] = (-4.0f * cur[j] + prev[j] + next[j] + cur[j-1] + cur[j+1]) * idx2;
+    }
+}
+
+/**
+ * @brief      Laplacian on the interior of a row using AVX-512, single precision
+ *
+ * The remainder of the row is handled with a masked load and store.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx512f")
+static void laplacian_interior_avx512_float(float* lap, const float* prev, const float* cur,
+                                            const float* next, unsigned int ncols, float idx2) {
+    const __m512 vidx2 = _mm512_set1_ps(idx2);
+    const __m512 vmfour = _mm512_set1_ps(-4.0f);
+
+    unsigned int j = 1;
+    for(; j + 16 <= ncols - 1; j += 16) {
+        const __m512 c = _mm512_loadu_ps(cur + j);
+        __m512 s = _mm512_add_ps(_mm512_loadu_ps(prev + j), _mm512_loadu_ps(next + j));
+        s = _mm512_add_ps(s, _mm512_add_ps(_mm512_loadu_ps(cur + j - 1), _mm512_loadu_ps(cur + j + 1)));
+        s = _mm512_fmadd_ps(vmfour, c, s);
+        _mm512_storeu_ps(lap + j, _mm512_mul_ps(s, vidx2));
+    }
+
+    if(j < ncols - 1) {
+        const __mmask16 m = (__mmask16)((1u << (ncols - 1 - j)) - 1);
+        const __m512 c = _mm512_maskz_loadu_ps(m, cur + j);
+        __m512 s = _mm512_add_ps(_mm512_maskz_loadu_ps(m, prev + j), _mm512_maskz_loadu_ps(m, next + j));
+        s = _mm512_add_ps(s, _mm512_add_ps(_mm512_maskz_loadu_ps(m, cur + j - 1), _mm512_maskz_loadu_ps(m, cur + j + 1)));
+        s = _mm512_fmadd_ps(vmfour, c, s);
+        _mm512_mask_storeu_ps(lap + j, m, _mm512_mul_ps(s, vidx2));
+    }
+}
+
+/**
+ * @brief      Nine-point Laplacian on the interior of a row using AVX2 and FMA
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx2,fma")
+static void nine_point_interior_avx2(double* lap, const double* prev, const double* cur,
+                                     const double* next, unsigned int ncols, double idx2) {
+    const double w = idx2 / (double)6.0;
+    const __m256d vw = _mm256_set1_pd(w);
+    const __m256d vfour = _mm256_set1_pd(4.0);
+    const __m256d vmtwenty = _mm256_set1_pd(-20.0);
+
+    unsigned int j = 1;
+    for(; j + 4 <= ncols - 1; j += 4) {
+        const __m256d c = _mm256_loadu_pd(cur + j);
+        __m256d s = _mm256_add_pd(_mm256_loadu_pd(prev + j), _mm256_loadu_pd(next + j));
+        s = _mm256_add_pd(s, _mm256_add_pd(_mm256_loadu_pd(cur + j - 1), _mm256_loadu_pd(cur + j + 1)));
+        __m256d d = _mm256_add_pd(_mm256_loadu_pd(prev + j - 1), _mm256_loadu_pd(prev + j + 1));
+        d = _mm256_add_pd(d, _mm256_add_pd(_mm256_loadu_pd(next + j - 1), _mm256_loadu_pd(next + j + 1)));
+        s = _mm256_fmadd_pd(vfour, s, d);
+        s = _mm256_fmadd_pd(vmtwenty, c, s);
+        _mm256_storeu_pd(lap + j, _mm256_mul_pd(s, vw));
+    }
+
+    for(; j<ncols-1; j++) {
+        lap[j] = (4.0 * (prev[j] + next[j] + cur[j-1] + cur[j+1]) +
+                  (prev[j-1] + prev[j+1] + next[j-1] + next[j+1]) -
+                  20.0 * cur[j]) * w;
+    }
+}
+
+/**
+ * @brief      Fourth-order Laplacian on the interior of a row using AVX2 and FMA
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx2,fma")
+static void fourth_order_interior_avx2(double* lap, const double* prev2, const double* prev, const double* cur,
+                                       const double* next, const double* next2, unsigned int ncols, double idx2) {
+    const double w = idx2 / (double)12.0;
+    const __m256d vw = _mm256_set1_pd(w);
+    const __m256d vsixteen = _mm256_set1_pd(16.0);
+    const __m256d vmsixty = _mm256_set1_pd(-60.0);
+
+    unsigned int j = 2;
+    for(; j + 4 <= ncols - 2; j += 4) {
+        const __m256d c = _mm256_loadu_pd(cur + j);
+        __m256d s = _mm256_add_pd(_mm256_loadu_pd(prev + j), _mm256_loadu_pd(next + j));
+        s = _mm256_add_pd(s, _mm256_add_pd(_mm256_loadu_pd(cur + j - 1), _mm256_loadu_pd(cur + j + 1)));
+        __m256d f = _mm256_add_pd(_mm256_loadu_pd(prev2 + j), _mm256_loadu_pd(next2 + j));
+        f = _mm256_add_pd(f, _mm256_add_pd(_mm256_loadu_pd(cur + j - 2), _mm256_loadu_pd(cur + j + 2)));
+        s = _mm256_fmsub_pd(vsixteen, s, f);
+        s = _mm256_fmadd_pd(vmsixty, c, s);
+        _mm256_storeu_pd(lap + j, _mm256_mul_pd(s, vw));
+    }
+
+    for(; j<ncols-2; j++) {
+        lap[j] = (16.0 * (prev[j] + next[j] + cur[j-1] + cur[j+1]) -
+                  (prev2[j] + next2[j] + cur[j-2] + cur[j+2]) -
+                  60.0 * cur[j]) * w;
+    }
+}
+
+/**
+ * @brief      Nine-point Laplacian on the interior of a row using AVX2 and FMA, single precision
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx2,fma")
+static void nine_point_interior_avx2_float(float* lap, const float* prev, const float* cur,
+                                           const float* next, unsigned int ncols, float idx2) {
+    const float w = idx2 / (float)6.0;
+    const __m256 vw = _mm256_set1_ps(w);
+    const __m256 vfour = _mm256_set1_ps(4.0f);
+    const __m256 vmtwenty = _mm256_set1_ps(-20.0f);
+
+    unsigned int j = 1;
+    for(; j + 8 <= ncols - 1; j += 8) {
+        const __m256 c = _mm256_loadu_ps(cur + j);
+        __m256 s = _mm256_add_ps(_mm256_loadu_ps(prev + j), _mm256_loadu_ps(next + j));
+        s = _mm256_add_ps(s, _mm256_add_ps(_mm256_loadu_ps(cur + j - 1), _mm256_loadu_ps(cur + j + 1)));
+        __m256 d = _mm256_add_ps(_mm256_loadu_ps(prev + j - 1), _mm256_loadu_ps(prev + j + 1));
+        d = _mm256_add_ps(d, _mm256_add_ps(_mm256_loadu_ps(next + j - 1), _mm256_loadu_ps(next + j + 1)));
+        s = _mm256_fmadd_ps(vfour, s, d);
+        s = _mm256_fmadd_ps(vmtwenty, c, s);
+        _mm256_storeu_ps(lap + j, _mm256_mul_ps(s, vw));
+    }
+
+    for(; j<ncols-1; j++) {
+        lap[j] = (4.0f * (prev[j] + next[j] + cur[j-1] + cur[j+1]) +
+                  (prev[j-1] + prev[j+1] + next[j-1] + next[j+1]) -
+                  20.0f * cur[j]) * w;
+    }
+}
+
+/**
+ * @brief      Fourth-order Laplacian on the interior of a row using AVX2 and FMA, single precision
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx2,fma")
+static void fourth_order_interior_avx2_float(float* lap, const float* prev2, const float* prev, const float* cur,
+                                             const float* next, const float* next2, unsigned int ncols, float idx2) {
+    const float w = idx2 / (float)12.0;
+    const __m256 vw = _mm256_set1_ps(w);
+    const __m256 vsixteen = _mm256_set1_ps(16.0f);
+    const __m256 vmsixty = _mm256_set1_ps(-60.0f);
+
+    unsigned int j = 2;
+    for(; j + 8 <= ncols - 2; j += 8) {
+        const __m256 c = _mm256_loadu_ps(cur + j);
+        __m256 s = _mm256_add_ps(_mm256_loadu_ps(prev + j), _mm256_loadu_ps(next + j));
+        s = _mm256_add_ps(s, _mm256_add_ps(_mm256_loadu_ps(cur + j - 1), _mm256_loadu_ps(cur + j + 1)));
+        __m256 f = _mm256_add_ps(_mm256_loadu_ps(prev2 + j), _mm256_loadu_ps(next2 + j));
+        f = _mm256_add_ps(f, _mm256_add_ps(_mm256_loadu_ps(cur + j - 2), _mm256_loadu_ps(cur + j + 2)));
+        s = _mm256_fmsub_ps(vsixteen, s, f);
+        s = _mm256_fmadd_ps(vmsixty, c, s);
+        _mm256_storeu_ps(lap + j, _mm256_mul_ps(s, vw));
+    }
+
+    for(; j<ncols-2; j++) {
+        lap[j] = (16.0f * (prev[j] + next[j] + cur[j-1] + cur[j+1]) -
+                  (prev2[j] + next2[j] + cur[j-2] + cur[j+2]) -
+                  60.0f * cur[j]) * w;
+    }
+}
+
+/**
+ * @brief      Nine-point Laplacian on the interior of a row using AVX-512
+ *
+ * The remainder of the row is handled with a masked load and store.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx512f")
+static void nine_point_interior_avx512(double* lap, const double* prev, const double* cur,
+                                       const double* next, unsigned int ncols, double idx2) {
+    const double w = idx2 / (double)6.0;
+    const __m512d vw = _mm512_set1_pd(w);
+    const __m512d vfour = _mm512_set1_pd(4.0);
+    const __m512d vmtwenty = _mm512_set1_pd(-20.0);
+
+    unsigned int j = 1;
+    for(; j + 8 <= ncols - 1; j += 8) {
+        const __m512d c = _mm512_loadu_pd(cur + j);
+        __m512d s = _mm512_add_pd(_mm512_loadu_pd(prev + j), _mm512_loadu_pd(next + j));
+        s = _mm512_add_pd(s, _mm512_add_pd(_mm512_loadu_pd(cur + j - 1), _mm512_loadu_pd(cur + j + 1)));
+        __m512d d = _mm512_add_pd(_mm512_loadu_pd(prev + j - 1), _mm512_loadu_pd(prev + j + 1));
+        d = _mm512_add_pd(d, _mm512_add_pd(_mm512_loadu_pd(next + j - 1), _mm512_loadu_pd(next + j + 1)));
+        s = _mm512_fmadd_pd(vfour, s, d);
+        s = _mm512_fmadd_pd(vmtwenty, c, s);
+        _mm512_storeu_pd(lap + j, _mm512_mul_pd(s, vw));
+    }
+
+    if(j < ncols - 1) {
+        const __mmask8 m = (__mmask8)((1u << (ncols - 1 - j)) - 1);
+        const __m512d c = _mm512_maskz_loadu_pd(m, cur + j);
+        __m512d s = _mm512_add_pd(_mm512_maskz_loadu_pd(m, prev + j), _mm512_maskz_loadu_pd(m, next + j));
+        s = _mm512_add_pd(s, _mm512_add_pd(_mm512_maskz_loadu_pd(m, cur + j - 1), _mm512_maskz_loadu_pd(m, cur + j + 1)));
+        __m512d d = _mm512_add_pd(_mm512_maskz_loadu_pd(m, prev + j - 1), _mm512_maskz_loadu_pd(m, prev + j + 1));
+        d = _mm512_add_pd(d, _mm512_add_pd(_mm512_maskz_loadu_pd(m, next + j - 1), _mm512_maskz_loadu_pd(m, next + j + 1)));
+        s = _mm512_fmadd_pd(vfour, s, d);
+        s = _mm512_fmadd_pd(vmtwenty, c, s);
+        _mm512_mask_storeu_pd(lap + j, m, _mm512_mul_pd(s, vw));
+    }
+}
+
+/**
+ * @brief      Fourth-order Laplacian on the interior of a row using AVX-512
+ *
+ * The remainder of the row is handled with a masked load and store.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx512f")
+static void fourth_order_interior_avx512(double* lap, const double* prev2, const double* prev, const double* cur,
+                                         const double* next, const double* next2, unsigned int ncols, double idx2) {
+    const double w = idx2 / (double)12.0;
+    const __m512d vw = _mm512_set1_pd(w);
+    const __m512d vsixteen = _mm512_set1_pd(16.0);
+    const __m512d vmsixty = _mm512_set1_pd(-60.0);
+
+    unsigned int j = 2;
+    for(; j + 8 <= ncols - 2; j += 8) {
+        const __m512d c = _mm512_loadu_pd(cur + j);
+        __m512d s = _mm512_add_pd(_mm512_loadu_pd(prev + j), _mm512_loadu_pd(next + j));
+        s = _mm512_add_pd(s, _mm512_add_pd(_mm512_loadu_pd(cur + j - 1), _mm512_loadu_pd(cur + j + 1)));
+        __m512d f = _mm512_add_pd(_mm512_loadu_pd(prev2 + j), _mm512_loadu_pd(next2 + j));
+        f = _mm512_add_pd(f, _mm512_add_pd(_mm512_loadu_pd(cur + j - 2), _mm512_loadu_pd(cur + j + 2)));
+        s = _mm512_fmsub_pd(vsixteen, s, f);
+        s = _mm512_fmadd_pd(vmsixty, c, s);
+        _mm512_storeu_pd(lap + j, _mm512_mul_pd(s, vw));
+    }
+
+    if(j < ncols - 2) {
+        const __mmask8 m = (__mmask8)((1u << (ncols - 2 - j)) - 1);
+        const __m512d c = _mm512_maskz_loadu_pd(m, cur + j);
+        __m512d s = _mm512_add_pd(_mm512_maskz_loadu_pd(m, prev + j), _mm512_maskz_loadu_pd(m, next + j));
+        s = _mm512_add_pd(s, _mm512_add_pd(_mm512_maskz_loadu_pd(m, cur + j - 1), _mm512_maskz_loadu_pd(m, cur + j + 1)));
+        __m512d f = _mm512_add_pd(_mm512_maskz_loadu_pd(m, prev2 + j), _mm512_maskz_loadu_pd(m, next2 + j));
+        f = _mm512_add_pd(f, _mm512_add_pd(_mm512_maskz_loadu_pd(m, cur + j - 2), _mm512_maskz_loadu_pd(m, cur + j + 2)));
+        s = _mm512_fmsub_pd(vsixteen, s, f);
+        s = _mm512_fmadd_pd(vmsixty, c, s);
+        _mm512_mask_storeu_pd(lap + j, m, _mm512_mul_pd(s, vw));
+    }
+}
+
+/**
+ * @brief      Nine-point Laplacian on the interior of a row using AVX-512, single precision
+ *
+ * The remainder of the row is handled with a masked load and store.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx512f")
+static void nine_point_interior_avx512_float(float* lap, const float* prev, const float* cur,
+                                             const float* next, unsigned int ncols, float idx2) {
+    const float w = idx2 / (float)6.0;
+    const __m512 vw = _mm512_set1_ps(w);
+    const __m512 vfour = _mm512_set1_ps(4.0f);
+    const __m512 vmtwenty = _mm512_set1_ps(-20.0f);
+
+    unsigned int j = 1;
+    for(; j + 16 <= ncols - 1; j += 16) {
+        const __m512 c = _mm512_loadu_ps(cur + j);
+        __m512 s = _mm512_add_ps(_mm512_loadu_ps(prev + j), _mm512_loadu_ps(next + j));
+        s = _mm512_add_ps(s, _mm512_add_ps(_mm512_loadu_ps(cur + j - 1), _mm512_loadu_ps(cur + j + 1)));
+        __m512 d = _mm512_add_ps(_mm512_loadu_ps(prev + j - 1), _mm512_loadu_ps(prev + j + 1));
+        d = _mm512_add_ps(d, _mm512_add_ps(_mm512_loadu_ps(next + j - 1), _mm512_loadu_ps(next + j + 1)));
+        s = _mm512_fmadd_ps(vfour, s, d);
+        s = _mm512_fmadd_ps(vmtwenty, c, s);
+        _mm512_storeu_ps(lap + j, _mm512_mul_ps(s, vw));
+    }
+
+    if(j < ncols - 1) {
+        const __mmask16 m = (__mmask16)((1u << (ncols - 1 - j)) - 1);
+        const __m512 c = _mm512_maskz_loadu_ps(m, cur + j);
+        __m512 s = _mm512_add_ps(_mm512_maskz_loadu_ps(m, prev + j), _mm512_maskz_loadu_ps(m, next + j));
+        s = _mm512_add_ps(s, _mm512_add_ps(_mm512_maskz_loadu_ps(m, cur + j - 1), _mm512_maskz_loadu_ps(m, cur + j + 1)));
+        __m512 d = _mm512_add_ps(_mm512_maskz_loadu_ps(m, prev + j - 1), _mm512_maskz_loadu_ps(m, prev + j + 1));
+        d = _mm512_add_ps(d, _mm512_add_ps(_mm512_maskz_loadu_ps(m, next + j - 1), _mm512_maskz_loadu_ps(m, next + j + 1)));
+        s = _mm512_fmadd_ps(vfour, s, d);
+        s = _mm512_fmadd_ps(vmtwenty, c, s);
+        _mm512_mask_storeu_ps(lap + j, m, _mm512_mul_ps(s, vw));
+    }
+}
+
+/**
+ * @brief      Fourth-order Laplacian on the interior of a row using AVX-512, single precision
+ *
+ * The remainder of the row is handled with a masked load and store.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ */
+LAFLUXXY_TARGET("avx512f")
+static void fourth_order_interior_avx512_float(float* lap, const float* prev2, const float* prev, const float* cur,
+                                               const float* next, const float* next2, unsigned int ncols, float idx2) {
+    const float w = idx2 / (float)12.0;
+    const __m512 vw = _mm512_set1_ps(w);
+    const __m512 vsixteen = _mm512_set1_ps(16.0f);
+    const __m512 vmsixty = _mm512_set1_ps(-60.0f);
+
+    unsigned int j = 2;
+    for(; j + 16 <= ncols - 2; j += 16) {
+        const __m512 c = _mm512_loadu_ps(cur + j);
+        __m512 s = _mm512_add_ps(_mm512_loadu_ps(prev + j), _mm512_loadu_ps(next + j));
+        s = _mm512_add_ps(s, _mm512_add_ps(_mm512_loadu_ps(cur + j - 1), _mm512_loadu_ps(cur + j + 1)));
+        __m512 f = _mm512_add_ps(_mm512_loadu_ps(prev2 + j), _mm512_loadu_ps(next2 + j));
+        f = _mm512_add_ps(f, _mm512_add_ps(_mm512_loadu_ps(cur + j - 2), _mm512_loadu_ps(cur + j + 2)));
+        s = _mm512_fmsub_ps(vsixteen, s, f);
+        s = _mm512_fmadd_ps(vmsixty, c, s);
+        _mm512_storeu_ps(lap + j, _mm512_mul_ps(s, vw));
+    }
+
+    if(j < ncols - 2) {
+        const __mmask16 m = (__mmask16)((1u << (ncols - 2 - j)) - 1);
+        const __m512 c = _mm512_maskz_loadu_ps(m, cur + j);
+        __m512 s = _mm512_add_ps(_mm512_maskz_loadu_ps(m, prev + j), _mm512_maskz_loadu_ps(m, next + j));
+        s = _mm512_add_ps(s, _mm512_add_ps(_mm512_maskz_loadu_ps(m, cur + j - 1), _mm512_maskz_loadu_ps(m, cur + j + 1)));
+        __m512 f = _mm512_add_ps(_mm512_maskz_loadu_ps(m, prev2 + j), _mm512_maskz_loadu_ps(m, next2 + j));
+        f = _mm512_add_ps(f, _mm512_add_ps(_mm512_maskz_loadu_ps(m, cur + j - 2), _mm512_maskz_loadu_ps(m, cur + j + 2)));
+        s = _mm512_fmsub_ps(vsixteen, s, f);
+        s = _mm512_fmadd_ps(vmsixty, c, s);
+        _mm512_mask_storeu_ps(lap + j, m, _mm512_mul_ps(s, vw));
+    }
+}
+#endif
+
+/**
+ * @brief      Get the stencil kernels for the best instruction set of this CPU
+ *
+ * @return     The stencil kernels
+ */
+const StencilKernels& get_stencil_kernels() {
+    static const StencilKernels kernels = []() {
+        StencilKernels sk = {SIMD_LEVEL::GENERIC,
+                             &laplacian_interior_generic<double>,
+                             &laplacian_interior_generic<float>,
+                             &nine_point_interior_generic<double>,
+                             &nine_point_interior_generic<float>,
+                             &fourth_order_interior_generic<double>,
+                             &fourth_order_interior_generic<float>};
+
+#ifdef LAFLUXXY_X86
+        sk.level = detect_simd_level();
+        switch(sk.level) {
+            case SIMD_LEVEL::SSE42:
+                sk.interior_d = &laplacian_interior_sse42;
+                sk.interior_f = &laplacian_interior_sse42_float;
+            break;
+            case SIMD_LEVEL::AVX2:
+                sk.interior_d = &laplacian_interior_avx2;
+                sk.interior_f = &laplacian_interior_avx2_float;
+                sk.nine_point_d = &nine_point_interior_avx2;
+                sk.nine_point_f = &nine_point_interior_avx2_float;
+                sk.fourth_order_d = &fourth_order_interior_avx2;
+                sk.fourth_order_f = &fourth_order_interior_avx2_float;
+            break;
+            case SIMD_LEVEL::AVX512:
+                sk.interior_d = &laplacian_interior_avx512;
+                sk.interior_f = &laplacian_interior_avx512_float;
+                sk.nine_point_d = &nine_point_interior_avx512;
+                sk.nine_point_f = &nine_point_interior_avx512_float;
+                sk.fourth_order_d = &fourth_order_interior_avx512;
+                sk.fourth_order_f = &fourth_order_interior_avx512_float;
+            break;
+            default:
+                // keep the portable kernel
+            break;
+        }
+#endif
+
+        return sk;
+    }();
+
+    return kernels;
+}
+
+/**
+ * @brief      Get a printable name of a stencil
+ *
+ * @param[in]  stencil  The stencil
+ *
+ * @return     The name
+ */
+const char* get_stencil_name(STENCIL stencil) {
+    switch(stencil) {
+        case STENCIL::NINE_POINT:
+            return "9-point isotropic";
+        case STENCIL::FOURTH_ORDER:
+            return "4th order";
+        default:
+            return "5-point";
+    }
+}
+
+/**
+ * @brief      Get the largest magnitude of the eigenvalues of a stencil
+ *
+ * The largest magnitude belongs to the checkerboard mode. Along a single
+ * axis this is 4 / dx^2 for the second-order and 16 / (3 dx^2) for the
+ * fourth-order differences; the diagonal neighbours of the nine-point
+ * stencil reduce it to 16 / (3 dx^2) for both axes together.
+ *
+ * @param[in]  stencil  The stencil
+ * @param[in]  dx       size of the space interval
+ *
+ * @return     The spectral radius
+ */
+double get_stencil_spectral_radius(STENCIL stencil, double dx) {
+    const double idx2 = 1.0 / (dx * dx);
+    switch(stencil) {
+        case STENCIL::NINE_POINT:
+            return 16.0 / 3.0 * idx2;
+        case STENCIL::FOURTH_ORDER:
+            return 32.0 / 3.0 * idx2;
+        default:
+            return 8.0 * idx2;
+    }
+}
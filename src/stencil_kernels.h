@@ -0,0 +1,384 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+#pragma once
+
+#include <initializer_list>
+
+#include "cpu_features.h"
+
+/**
+ * @brief      Finite-difference stencils of the Laplacian
+ */
+enum class STENCIL {
+    FIVE_POINT,     //!< second-order five-point stencil
+    NINE_POINT,     //!< second-order nine-point stencil with an isotropic leading error
+    FOURTH_ORDER    //!< fourth-order stencil reaching two cells along both axes
+};
+
+/**
+ * @brief      Get a printable name of a stencil
+ *
+ * @param[in]  stencil  The stencil
+ *
+ * @return     The name
+ */
+const char* get_stencil_name(STENCIL stencil);
+
+/**
+ * @brief      Get the largest magnitude of the eigenvalues of a stencil
+ *
+ * This bounds the spectrum of the discrete Laplacian for both periodic and
+ * zero-flux boundaries, and sets the stability limit of explicit schemes.
+ *
+ * @param[in]  stencil  The stencil
+ * @param[in]  dx       size of the space interval
+ *
+ * @return     The spectral radius
+ */
+double get_stencil_spectral_radius(STENCIL stencil, double dx);
+
+/**
+ * @brief      Get the row or column that a stencil reads outside of the domain
+ *
+ * With periodic boundaries the index wraps around; otherwise it is
+ * mirrored in the edge of the domain, such that the flux over the edge
+ * vanishes. Indices inside the domain are returned unchanged.
+ *
+ * @param[in]  k     Index, at most n away from the domain
+ * @param[in]  n     Number of rows or columns
+ * @param[in]  wrap  Whether the boundaries are periodic
+ *
+ * @return     The index inside the domain
+ */
+inline int stencil_index(int k, int n, bool wrap) {
+    if(k < 0) {
+        return wrap ? k + n : -1 - k;
+    }
+    if(k >= n) {
+        return wrap ? k - n : 2 * n - 1 - k;
+    }
+    return k;
+}
+
+/**
+ * @brief      Function that evaluates the 5-point Laplacian on the interior of a row
+ *
+ * Only the columns 1 ... ncols-2 are written; the two edge columns depend
+ * on the boundary conditions and are handled by the caller.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+using laplacian_row_fn = void (*)(T* lap, const T* prev, const T* cur,
+                                  const T* next, unsigned int ncols, T idx2);
+
+/**
+ * @brief      Function that evaluates a wide Laplacian stencil on the interior of a row
+ *
+ * Only the columns 2 ... ncols-3 are written; the four edge columns depend
+ * on the boundary conditions and are handled by the caller.
+ *
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+using laplacian_row5_fn = void (*)(T* lap, const T* prev2, const T* prev, const T* cur,
+                                   const T* next, const T* next2, unsigned int ncols, T idx2);
+
+/**
+ * @brief      Set of stencil kernels for a single instruction set
+ */
+struct StencilKernels {
+    SIMD_LEVEL level;                       //!< instruction set the kernels are compiled for
+    laplacian_row_fn<double> interior_d;    //!< Laplacian on the interior of a row, double precision
+    laplacian_row_fn<float> interior_f;     //!< Laplacian on the interior of a row, single precision
+    laplacian_row_fn<double> nine_point_d;      //!< nine-point Laplacian on the interior of a row, double precision
+    laplacian_row_fn<float> nine_point_f;       //!< nine-point Laplacian on the interior of a row, single precision
+    laplacian_row5_fn<double> fourth_order_d;   //!< fourth-order Laplacian on the interior of a row, double precision
+    laplacian_row5_fn<float> fourth_order_f;    //!< fourth-order Laplacian on the interior of a row, single precision
+
+    inline void interior(double* lap, const double* prev, const double* cur,
+                         const double* next, unsigned int ncols, double idx2) const {
+        this->interior_d(lap, prev, cur, next, ncols, idx2);
+    }
+
+    inline void interior(float* lap, const float* prev, const float* cur,
+                         const float* next, unsigned int ncols, float idx2) const {
+        this->interior_f(lap, prev, cur, next, ncols, idx2);
+    }
+
+    inline void nine_point(double* lap, const double* prev, const double* cur,
+                           const double* next, unsigned int ncols, double idx2) const {
+        this->nine_point_d(lap, prev, cur, next, ncols, idx2);
+    }
+
+    inline void nine_point(float* lap, const float* prev, const float* cur,
+                           const float* next, unsigned int ncols, float idx2) const {
+        this->nine_point_f(lap, prev, cur, next, ncols, idx2);
+    }
+
+    inline void fourth_order(double* lap, const double* prev2, const double* prev, const double* cur,
+                             const double* next, const double* next2, unsigned int ncols, double idx2) const {
+        this->fourth_order_d(lap, prev2, prev, cur, next, next2, ncols, idx2);
+    }
+
+    inline void fourth_order(float* lap, const float* prev2, const float* prev, const float* cur,
+                             const float* next, const float* next2, unsigned int ncols, float idx2) const {
+        this->fourth_order_f(lap, prev2, prev, cur, next, next2, ncols, idx2);
+    }
+};
+
+/**
+ * @brief      Get the stencil kernels for the best instruction set of this CPU
+ *
+ * The instruction set is detected only once, upon the first call.
+ *
+ * @return     The stencil kernels
+ */
+const StencilKernels& get_stencil_kernels();
+
+/**
+ * @brief      Calculate the Laplacian of a row with periodic boundary conditions
+ *
+ * @param[in]  sk     Stencil kernels
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+inline void laplacian_row_pbc(const StencilKernels& sk, T* lap, const T* prev, const T* cur,
+                              const T* next, unsigned int ncols, T idx2) {
+    sk.interior(lap, prev, cur, next, ncols, idx2);
+
+    // the edges wrap around
+    lap[0] = ((T)-4.0 * cur[0] + prev[0] + next[0] + cur[ncols-1] + cur[1]) * idx2;
+    lap[ncols-1] = ((T)-4.0 * cur[ncols-1] + prev[ncols-1] + next[ncols-1] + cur[ncols-2] + cur[0]) * idx2;
+}
+
+/**
+ * @brief      Calculate the Laplacian of a row with zero-flux boundary conditions
+ *
+ * The rows at the top and bottom boundaries are obtained by passing the
+ * current row as the missing neighbour.
+ *
+ * @param[in]  sk     Stencil kernels
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+inline void laplacian_row_zeroflux(const StencilKernels& sk, T* lap, const T* prev, const T* cur,
+                                   const T* next, unsigned int ncols, T idx2) {
+    sk.interior(lap, prev, cur, next, ncols, idx2);
+
+    // the edges reflect onto themselves
+    lap[0] = ((T)-3.0 * cur[0] + prev[0] + next[0] + cur[1]) * idx2;
+    lap[ncols-1] = ((T)-3.0 * cur[ncols-1] + prev[ncols-1] + next[ncols-1] + cur[ncols-2]) * idx2;
+}
+
+/**
+ * @brief      Evaluate the nine-point Laplacian of a single cell
+ *
+ * The diagonal neighbours carry a quarter of the weight of the direct
+ * neighbours, which makes the leading error term isotropic.
+ *
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  jw     Column to the left
+ * @param[in]  j      Column
+ * @param[in]  je     Column to the right
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ *
+ * @return     The Laplacian
+ */
+template<typename T>
+inline T nine_point_cell(const T* prev, const T* cur, const T* next,
+                         unsigned int jw, unsigned int j, unsigned int je, T idx2) {
+    return ((T)4.0 * (prev[j] + next[j] + cur[jw] + cur[je]) +
+            (prev[jw] + prev[je] + next[jw] + next[je]) -
+            (T)20.0 * cur[j]) * (idx2 / (T)6.0);
+}
+
+/**
+ * @brief      Calculate the nine-point Laplacian of a row with periodic boundary conditions
+ *
+ * @param[in]  sk     Stencil kernels
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+inline void laplacian_row_nine_point_pbc(const StencilKernels& sk, T* lap, const T* prev, const T* cur,
+                                         const T* next, unsigned int ncols, T idx2) {
+    sk.nine_point(lap, prev, cur, next, ncols, idx2);
+
+    // the edges wrap around
+    lap[0] = nine_point_cell(prev, cur, next, ncols-1, 0, 1, idx2);
+    lap[ncols-1] = nine_point_cell(prev, cur, next, ncols-2, ncols-1, 0, idx2);
+}
+
+/**
+ * @brief      Calculate the nine-point Laplacian of a row with zero-flux boundary conditions
+ *
+ * The rows at the top and bottom boundaries are obtained by passing the
+ * current row as the missing neighbour.
+ *
+ * @param[in]  sk     Stencil kernels
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  ncols  Number of columns
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+inline void laplacian_row_nine_point_zeroflux(const StencilKernels& sk, T* lap, const T* prev, const T* cur,
+                                              const T* next, unsigned int ncols, T idx2) {
+    sk.nine_point(lap, prev, cur, next, ncols, idx2);
+
+    // the edges reflect onto themselves
+    lap[0] = nine_point_cell(prev, cur, next, 0, 0, 1, idx2);
+    lap[ncols-1] = nine_point_cell(prev, cur, next, ncols-2, ncols-1, ncols-1, idx2);
+}
+
+/**
+ * @brief      Evaluate the fourth-order Laplacian of a single cell
+ *
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  j      Column
+ * @param[in]  ncols  Number of columns
+ * @param[in]  wrap   Whether the columns wrap around or reflect at the edges
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ *
+ * @return     The Laplacian
+ */
+template<typename T>
+inline T fourth_order_cell(const T* prev2, const T* prev, const T* cur, const T* next, const T* next2,
+                           unsigned int j, unsigned int ncols, bool wrap, T idx2) {
+    const int n = ncols;
+    const int jww = stencil_index((int)j - 2, n, wrap);
+    const int jw = stencil_index((int)j - 1, n, wrap);
+    const int je = stencil_index((int)j + 1, n, wrap);
+    const int jee = stencil_index((int)j + 2, n, wrap);
+
+    return ((T)16.0 * (prev[j] + next[j] + cur[jw] + cur[je]) -
+            (prev2[j] + next2[j] + cur[jww] + cur[jee]) -
+            (T)60.0 * cur[j]) * (idx2 / (T)12.0);
+}
+
+/**
+ * @brief      Calculate the fourth-order Laplacian of a row with periodic boundary conditions
+ *
+ * @param[in]  sk     Stencil kernels
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  ncols  Number of columns, at least four
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+inline void laplacian_row_fourth_order_pbc(const StencilKernels& sk, T* lap, const T* prev2, const T* prev,
+                                           const T* cur, const T* next, const T* next2,
+                                           unsigned int ncols, T idx2) {
+    sk.fourth_order(lap, prev2, prev, cur, next, next2, ncols, idx2);
+
+    // the edges wrap around
+    for(unsigned int j : {0u, 1u, ncols-2, ncols-1}) {
+        lap[j] = fourth_order_cell(prev2, prev, cur, next, next2, j, ncols, true, idx2);
+    }
+}
+
+/**
+ * @brief      Calculate the fourth-order Laplacian of a row with zero-flux boundary conditions
+ *
+ * The two rows beyond the top and bottom boundaries are obtained by
+ * passing the mirrored rows, see stencil_index().
+ *
+ * @param[in]  sk     Stencil kernels
+ * @param      lap    Output row of the Laplacian
+ * @param[in]  prev2  Row i-2
+ * @param[in]  prev   Row i-1
+ * @param[in]  cur    Row i
+ * @param[in]  next   Row i+1
+ * @param[in]  next2  Row i+2
+ * @param[in]  ncols  Number of columns, at least four
+ * @param[in]  idx2   Inverse of the squared grid spacing
+ *
+ * @tparam     T      Floating point type
+ */
+template<typename T>
+inline void laplacian_row_fourth_order_zeroflux(const StencilKernels& sk, T* lap, const T* prev2, const T* prev,
+                                                const T* cur, const T* next, const T* next2,
+                                                unsigned int ncols, T idx2) {
+    sk.fourth_order(lap, prev2, prev, cur, next, next2, ncols, idx2);
+
+    // the edges are mirrored
+    for(unsigned int j : {0u, 1u, ncols-2, ncols-1}) {
+        lap[j] = fourth_order_cell(prev2, prev, cur, next, next2, j, ncols, false, idx2);
+    }
+}
@@ -0,0 +1,139 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "super_time_stepping.h"
+
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+
+/**
+ * @brief      Constructs the object.
+ *
+ * The number of stages is the smallest s for which (s^2 + s - 2) / 4 times
+ * the stability limit of explicit Euler, 2 / (Dmax rho) with rho the
+ * spectral radius of the stencil, covers the time step with some margin
+ * for the reaction terms.
+ *
+ * @param[in]  width   width of the system
+ * @param[in]  height  height of the system
+ * @param[in]  dx      size of the space interval
+ * @param[in]  _dt     size of the time interval
+ * @param[in]  Dmax    largest diffusion coefficient
+ * @param[in]  stencil finite-difference stencil of the Laplacian
+ */
+SuperTimeStepping::SuperTimeStepping(unsigned int width, unsigned int height, double dx, double _dt, double Dmax,
+                                     STENCIL stencil) :
+    dt(_dt) {
+
+    const double dt_euler = 2.0 / (Dmax * get_stencil_spectral_radius(stencil, dx));
+    const double ratio = this->dt / dt_euler;
+    this->nstages = std::max(2.0, std::ceil((-1.0 + std::sqrt(9.0 + 16.0 * ratio / safety)) / 2.0));
+    this->speedup = ratio / this->nstages;
+
+    // coefficients of the recursion; entries 0 and 1 of mu, nu and gamt are unused
+    const unsigned int s = this->nstages;
+    std::vector<double> bj(s + 1);
+    for(unsigned int j=0; j<=s; j++) {
+        const double jj = std::max(j, 2u);
+        bj[j] = (jj * jj + jj - 2.0) / (2.0 * jj * (jj + 1.0));
+    }
+    const double w1 = 4.0 / ((double)s * s + s - 2.0);
+
+    this->mu.assign(s + 1, 0.0);
+    this->nu.assign(s + 1, 0.0);
+    this->mut.assign(s + 1, 0.0);
+    this->gamt.assign(s + 1, 0.0);
+    this->mut[1] = bj[1] * w1;
+    for(unsigned int j=2; j<=s; j++) {
+        this->mu[j] = (2.0 * j - 1.0) / j * bj[j] / bj[j-1];
+        this->nu[j] = -(j - 1.0) / j * bj[j] / bj[j-2];
+        this->mut[j] = this->mu[j] * w1;
+        this->gamt[j] = -(1.0 - bj[j-1]) * this->mut[j];
+    }
+
+    this->a0 = MatrixXXd::Zero(height, width);
+    this->b0 = MatrixXXd::Zero(height, width);
+    this->da0 = MatrixXXd::Zero(height, width);
+    this->db0 = MatrixXXd::Zero(height, width);
+    this->a1 = MatrixXXd::Zero(height, width);
+    this->b1 = MatrixXXd::Zero(height, width);
+    this->da = MatrixXXd::Zero(height, width);
+    this->db = MatrixXXd::Zero(height, width);
+}
+
+/**
+ * @brief      Advance the concentrations by a number of time steps
+ *
+ * The concentrations hold the previous stage; every new stage overwrites
+ * the stage before it, after which the two are swapped.
+ *
+ * @param      a       Concentration of A
+ * @param      b       Concentration of B
+ * @param[in]  nsteps  Number of time steps
+ * @param[in]  rate    Function that evaluates the time derivatives
+ * @param[in]  ncores  Number of threads
+ */
+void SuperTimeStepping::advance(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps,
+                                const RateFunction& rate, unsigned int ncores) {
+    omp_set_num_threads(ncores);
+
+    const int ncells = a.size();
+    const double h = this->dt;
+
+    for(unsigned int n=0; n<nsteps; n++) {
+        this->a0 = a;
+        this->b0 = b;
+        rate(this->a0, this->b0, this->da0, this->db0);
+
+        // first stage
+        const double m1 = this->mut[1] * h;
+        #pragma omp parallel for schedule(static)
+        for(int k=0; k<ncells; k++) {
+            a.data()[k] = this->a0.data()[k] + m1 * this->da0.data()[k];
+            b.data()[k] = this->b0.data()[k] + m1 * this->db0.data()[k];
+            this->a1.data()[k] = this->a0.data()[k];
+            this->b1.data()[k] = this->b0.data()[k];
+        }
+
+        for(unsigned int j=2; j<=this->nstages; j++) {
+            rate(a, b, this->da, this->db);
+
+            const double cm = this->mu[j];
+            const double cn = this->nu[j];
+            const double c0 = 1.0 - cm - cn;
+            const double cl = this->mut[j] * h;
+            const double cg = this->gamt[j] * h;
+
+            #pragma omp parallel for schedule(static)
+            for(int k=0; k<ncells; k++) {
+                this->a1.data()[k] = cm * a.data()[k] + cn * this->a1.data()[k] + c0 * this->a0.data()[k] +
+                                     cl * this->da.data()[k] + cg * this->da0.data()[k];
+                this->b1.data()[k] = cm * b.data()[k] + cn * this->b1.data()[k] + c0 * this->b0.data()[k] +
+                                     cl * this->db.data()[k] + cg * this->db0.data()[k];
+            }
+
+            a.swap(this->a1);
+            b.swap(this->b1);
+        }
+    }
+}
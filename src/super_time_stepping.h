@@ -0,0 +1,109 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+
+#include "matrices.h"
+#include "runge_kutta.h"
+#include "stencil_kernels.h"
+
+/**
+ * @brief      Second-order Runge-Kutta-Legendre (RKL2) super-time-stepping integrator
+ *
+ * A single time step consists of s explicit stages, combined by the
+ * three-term recursion of the Legendre polynomials (Meyer, Balsara and
+ * Aslam, 2014). The stability interval along the negative real axis grows
+ * with s^2, such that a step of (s^2 + s - 2) / 4 times the stability
+ * limit of explicit Euler costs only s evaluations of the time
+ * derivatives. The number of stages follows from the largest eigenvalue
+ * of the diffusion operator, 8 D / dx^2 for the five-point stencil, which
+ * bounds the spectrum with and without a mask. Only the time derivatives are needed,
+ * such that masked domains cost no more than open ones.
+ */
+class SuperTimeStepping {
+private:
+    double dt;                      //!< size of the time interval
+    unsigned int nstages;           //!< number of stages per time step
+    double speedup;                 //!< number of explicit Euler steps saved per evaluation of the time derivatives
+
+    std::vector<double> mu;         //!< weights of the previous stage
+    std::vector<double> nu;         //!< weights of the stage before the previous one
+    std::vector<double> mut;        //!< weights of the derivatives of the previous stage
+    std::vector<double> gamt;       //!< weights of the derivatives at the start of the step
+
+    MatrixXXd a0;                   //!< concentration of A at the start of the step
+    MatrixXXd b0;                   //!< concentration of B at the start of the step
+    MatrixXXd da0;                  //!< time derivative of A at the start of the step
+    MatrixXXd db0;                  //!< time derivative of B at the start of the step
+    MatrixXXd a1;                   //!< stage before the previous one for A
+    MatrixXXd b1;                   //!< stage before the previous one for B
+    MatrixXXd da;                   //!< time derivative of A of the previous stage
+    MatrixXXd db;                   //!< time derivative of B of the previous stage
+
+    static constexpr double safety = 0.9;   //!< fraction of the stability interval that is used
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  width   width of the system
+     * @param[in]  height  height of the system
+     * @param[in]  dx      size of the space interval
+     * @param[in]  _dt     size of the time interval
+     * @param[in]  Dmax    largest diffusion coefficient
+     * @param[in]  stencil finite-difference stencil of the Laplacian
+     */
+    SuperTimeStepping(unsigned int width, unsigned int height, double dx, double _dt, double Dmax,
+                      STENCIL stencil = STENCIL::FIVE_POINT);
+
+    /**
+     * @brief      Advance the concentrations by a number of time steps
+     *
+     * @param      a       Concentration of A
+     * @param      b       Concentration of B
+     * @param[in]  nsteps  Number of time steps
+     * @param[in]  rate    Function that evaluates the time derivatives
+     * @param[in]  ncores  Number of threads
+     */
+    void advance(MatrixXXd& a, MatrixXXd& b, unsigned int nsteps,
+                 const RateFunction& rate, unsigned int ncores);
+
+    /**
+     * @brief      Get the number of stages per time step
+     *
+     * @return     The number of stages
+     */
+    inline unsigned int get_stages() const {
+        return this->nstages;
+    }
+
+    /**
+     * @brief      Get the speedup over explicit Euler at its stability limit
+     *
+     * @return     The ratio of the number of evaluations of the time derivatives
+     */
+    inline double get_speedup() const {
+        return this->speedup;
+    }
+};
@@ -0,0 +1,282 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#include "three_dim_rd.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <omp.h>
+
+/**
+ * @brief      Constructs the object.
+ *
+ * @param[in]  _Da      Diffusion coefficient of compound A
+ * @param[in]  _Db      Diffusion coefficient of compound B
+ * @param[in]  _width   width of the system
+ * @param[in]  _height  height of the system
+ * @param[in]  _depth   depth of the system
+ * @param[in]  _dx      size of the space interval
+ * @param[in]  _dt      size of the time interval
+ * @param[in]  _steps   number of frames
+ * @param[in]  _tsteps  number of time steps when to write a frame
+ */
+ThreeDimRD::ThreeDimRD(double _Da, double _Db,
+                       unsigned int _width, unsigned int _height, unsigned int _depth,
+                       double _dx, double _dt, unsigned int _steps, unsigned int _tsteps) :
+    Da(_Da),
+    Db(_Db),
+    width(_width),
+    height(_height),
+    depth(_depth),
+    dx(_dx),
+    dt(_dt),
+    steps(_steps),
+    tsteps(_tsteps),
+    slice(_depth / 2),
+    stencil(&get_stencil_kernels()) {
+
+}
+
+/**
+ * @brief      Sets the reaction.
+ *
+ * Also selects the time step that is specialized for the kinetic system
+ *
+ * @param      _reaction_system  The reaction system
+ */
+void ThreeDimRD::set_reaction(ReactionSystem* _reaction_system) {
+    this->reaction_system = std::unique_ptr<ReactionSystem>(_reaction_system);
+
+    switch(this->reaction_system->get_reacttype()) {
+        case KINETICS::LOTKA_VOLTERRA:
+            this->select_step_function<KineticsLotkaVolterra>();
+        break;
+        case KINETICS::GRAY_SCOTT:
+            this->select_step_function<KineticsGrayScott>();
+        break;
+        case KINETICS::FITZHUGH_NAGUMO:
+            this->select_step_function<KineticsFitzhughNagumo>();
+        break;
+        case KINETICS::BRUSSELATOR:
+            this->select_step_function<KineticsBrusselator>();
+        break;
+        case KINETICS::BARKLEY:
+            this->select_step_function<KineticsBarkley>();
+        break;
+        default:
+            throw std::logic_error("Invalid reaction system encountered.");
+        break;
+    }
+}
+
+/**
+ * @brief      Sets the parameters and the initial state.
+ *
+ * Every slice is initialized as a two-dimensional system, such that the
+ * initial pattern extends along the depth.
+ *
+ * @param[in]  params  The parameters
+ */
+void ThreeDimRD::set_parameters(const std::string& params) {
+    this->reaction_system->set_parameters(params);
+    this->reaction_system->set_seed(params);
+
+    const unsigned int nrows = this->depth * this->height;
+    this->a = MatrixXXd::Zero(nrows, this->width);
+    this->b = MatrixXXd::Zero(nrows, this->width);
+    this->a_next = MatrixXXd::Zero(nrows, this->width);
+    this->b_next = MatrixXXd::Zero(nrows, this->width);
+
+    MatrixXXd as = MatrixXXd::Zero(this->height, this->width);
+    MatrixXXd bs = MatrixXXd::Zero(this->height, this->width);
+    for(unsigned int k=0; k<this->depth; k++) {
+        this->reaction_system->init(as, bs);
+        this->a.middleRows(k * this->height, this->height) = as;
+        this->b.middleRows(k * this->height, this->height) = bs;
+    }
+
+    this->t = 0.0;
+    this->ta.clear();
+    this->tb.clear();
+    this->ta.push_back(this->a.middleRows(this->slice * this->height, this->height));
+    this->tb.push_back(this->b.middleRows(this->slice * this->height, this->height));
+}
+
+/**
+ * @brief      Perform time integration
+ */
+void ThreeDimRD::time_integrate() {
+    for(unsigned int i=0; i<this->steps; i++) {
+        this->update();
+    }
+}
+
+/**
+ * @brief      Perform the time steps of a single frame
+ *
+ * The threads are forked once per frame. The generations are swapped at
+ * the end if the number of time steps is odd, such that the state always
+ * resides in the same matrices between frames.
+ */
+void ThreeDimRD::update() {
+    if(this->linebuf.rows() != 2 * this->ncores || this->linebuf.cols() != this->width) {
+        this->linebuf = MatrixXXd::Zero(2 * this->ncores, this->width);
+    }
+
+    omp_set_num_threads(this->ncores);
+    #pragma omp parallel
+    {
+        for(unsigned int j=0; j<this->tsteps; j++) {
+            (this->*step_function)(j & 1);
+        }
+
+        if(this->tsteps & 1) {
+            #pragma omp single
+            {
+                this->a.swap(this->a_next);
+                this->b.swap(this->b_next);
+            }
+        }
+    }
+
+    this->t += this->tsteps * this->dt;
+
+    this->ta.push_back(this->a.middleRows(this->slice * this->height, this->height));
+    this->tb.push_back(this->b.middleRows(this->slice * this->height, this->height));
+}
+
+/**
+ * @brief      Select the time step that is specialized for the kinetic system
+ *
+ * @tparam     Kinetics  Kinetic system
+ */
+template<class Kinetics>
+void ThreeDimRD::select_step_function() {
+    this->step_function = &ThreeDimRD::update_fused<Kinetics>;
+}
+
+/**
+ * @brief      Perform a single explicit time step
+ *
+ * The rows of every slice are divided in tiles that are small enough for
+ * the rows of three consecutive slices to stay in the cache. A thread
+ * sweeps a tile through a range of slices, such that every row it reads is
+ * loaded once and reused for the three slices that need it. The work
+ * consists of all combinations of a tile and a range of slices, with as
+ * many ranges as there are threads.
+ *
+ * The current generation is only read and the new state is written to the
+ * other, such that no synchronization is needed within the step. At the
+ * edges of the domain the neighbours either wrap around or reflect onto
+ * the cell itself.
+ *
+ * @param[in]  parity  Which generation holds the current state
+ *
+ * @tparam     Kinetics  Kinetic system
+ */
+template<class Kinetics>
+void ThreeDimRD::update_fused(unsigned int parity) {
+    const MatrixXXd& a = parity ? this->a_next : this->a;
+    const MatrixXXd& b = parity ? this->b_next : this->b;
+    MatrixXXd& a_out = parity ? this->a : this->a_next;
+    MatrixXXd& b_out = parity ? this->b : this->b_next;
+
+    const int w = this->width;
+    const int h = this->height;
+    const int d = this->depth;
+    const double idx2 = 1.0 / (this->dx * this->dx);
+    const double Da = this->Da;
+    const double Db = this->Db;
+    const double dt = this->dt;
+    const auto kp = make_kinetic_parameters<double>(this->reaction_system->get_kinetic_parameters());
+
+    const int tid = omp_get_thread_num();
+    double* lap_a = this->linebuf.row(2 * tid).data();
+    double* lap_b = this->linebuf.row(2 * tid + 1).data();
+
+    const int tile_rows = this->get_tile_rows();
+    const int ntiles = (h + tile_rows - 1) / tile_rows;
+    const int nranges = std::min(d, omp_get_num_threads());
+
+    #pragma omp for schedule(static)
+    for(int task=0; task<ntiles*nranges; task++) {
+        const int range = task / ntiles;
+        const int i0 = (task % ntiles) * tile_rows;
+        const int i1 = std::min(h, i0 + tile_rows);
+        const int k0 = (int)((long)range * d / nranges);
+        const int k1 = (int)((long)(range + 1) * d / nranges);
+
+        for(int k=k0; k<k1; k++) {
+            const int kprev = (k > 0) ? k - 1 : (this->pbc ? d - 1 : k);
+            const int knext = (k + 1 < d) ? k + 1 : (this->pbc ? 0 : k);
+
+            for(int i=i0; i<i1; i++) {
+                const int iprev = (i > 0) ? i - 1 : (this->pbc ? h - 1 : i);
+                const int inext = (i + 1 < h) ? i + 1 : (this->pbc ? 0 : i);
+
+                const int r = k * h + i;
+                if(this->pbc) {
+                    laplacian_row_pbc(*this->stencil, lap_a, a.row(k * h + iprev).data(), a.row(r).data(), a.row(k * h + inext).data(), w, idx2);
+                    laplacian_row_pbc(*this->stencil, lap_b, b.row(k * h + iprev).data(), b.row(r).data(), b.row(k * h + inext).data(), w, idx2);
+                } else {
+                    laplacian_row_zeroflux(*this->stencil, lap_a, a.row(k * h + iprev).data(), a.row(r).data(), a.row(k * h + inext).data(), w, idx2);
+                    laplacian_row_zeroflux(*this->stencil, lap_b, b.row(k * h + iprev).data(), b.row(r).data(), b.row(k * h + inext).data(), w, idx2);
+                }
+
+                const double* a_cur = a.row(r).data();
+                const double* b_cur = b.row(r).data();
+                const double* a_up = a.row(kprev * h + i).data();
+                const double* b_up = b.row(kprev * h + i).data();
+                const double* a_down = a.row(knext * h + i).data();
+                const double* b_down = b.row(knext * h + i).data();
+                double* a_new = a_out.row(r).data();
+                double* b_new = b_out.row(r).data();
+
+                #pragma omp simd
+                for(int j=0; j<w; j++) {
+                    double ra = 0;
+                    double rb = 0;
+                    Kinetics::reaction(a_cur[j], b_cur[j], kp, &ra, &rb);
+
+                    const double la = lap_a[j] + (a_up[j] + a_down[j] - 2.0 * a_cur[j]) * idx2;
+                    const double lb = lap_b[j] + (b_up[j] + b_down[j] - 2.0 * b_cur[j]) * idx2;
+
+                    a_new[j] = a_cur[j] + (la * Da + ra) * dt;
+                    b_new[j] = b_cur[j] + (lb * Db + rb) * dt;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Get the number of rows of a slice that are swept together
+ *
+ * A tile of n rows needs n + 2 rows of three slices of both A and B.
+ *
+ * @return     The number of rows
+ */
+unsigned int ThreeDimRD::get_tile_rows() const {
+    const size_t rowbytes = 6 * sizeof(double) * this->width;
+    const size_t fit = this->tile_bytes / rowbytes;
+    return std::max(1u, std::min(this->height, fit > 2 ? (unsigned int)(fit - 2) : 1u));
+}
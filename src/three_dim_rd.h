@@ -0,0 +1,217 @@
+ /**************************************************************************
+ *   This file is part of LaFluxxy                                        *
+ *   https://github.com/imc-codeteam/lafluxxy                             *
+ *                                                                        *
+ *   Author: Ivo Filot <i.a.w.filot@tue.nl>                               *
+ *                                                                        *
+ *   LaFluxxy is free software: you can redistribute it and/or modify     *
+ *   it under the terms of the GNU General Public License as published    *
+ *   by the Free Software Foundation, either version 3 of the License,    *
+ *   or (at your option) any later version.                               *
+ *                                                                        *
+ *   LaFluxxy is distributed in the hope that it will be useful,          *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty          *
+ *   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *   See the GNU General Public License for more details.                 *
+ *                                                                        *
+ *   You should have received a copy of the GNU General Public License    *
+ *   along with this program.  If not, see http://www.gnu.org/licenses/.  *
+ *                                                                        *
+ **************************************************************************/
+
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "matrices.h"
+#include "reaction_system.h"
+#include "kinetics.h"
+#include "stencil_kernels.h"
+
+/**
+ * @brief      Three-dimensional reaction-diffusion system integrated with explicit Euler
+ *
+ * The volume of depth x height x width cells is stored as a matrix of
+ * depth * height rows, such that slice k occupies rows k * height to
+ * (k + 1) * height - 1. The Laplacian is the 7-point stencil: the 5-point
+ * stencil within the slice, evaluated by the stencil kernels, plus the
+ * neighbours in the slices above and below.
+ *
+ * Only a single slice of every frame is stored, as complete volumes of
+ * 256^3 cells would take hundreds of megabytes per frame. The complete
+ * current state remains available.
+ */
+class ThreeDimRD {
+private:
+    double Da;              //!< diffusion coefficient of A
+    double Db;              //!< diffusion coefficient of B
+    unsigned int width;     //!< width of the system
+    unsigned int height;    //!< height of the system
+    unsigned int depth;     //!< depth of the system
+    double dx;              //!< size of the space interval
+    double dt;              //!< size of the time interval
+    unsigned int steps;     //!< number of frames
+    unsigned int tsteps;    //!< number of time steps when to write a frame
+    double t = 0.0;         //!< current time
+
+    unsigned int ncores = 1;        //!< number of threads
+    bool pbc = false;               //!< periodic boundary conditions
+    unsigned int slice;             //!< slice that is stored in the frames
+    size_t tile_bytes = 1 << 18;    //!< cache budget for the rows a single thread sweeps over
+
+    MatrixXXd a;            //!< concentration of A, one row per row of every slice
+    MatrixXXd b;            //!< concentration of B, one row per row of every slice
+    MatrixXXd a_next;       //!< second generation of A receiving the result of a time step
+    MatrixXXd b_next;       //!< second generation of B receiving the result of a time step
+    MatrixXXd linebuf;      //!< per-thread Laplacian rows
+
+    std::vector<MatrixXXd> ta;  //!< stored slice of A per frame
+    std::vector<MatrixXXd> tb;  //!< stored slice of B per frame
+
+    std::unique_ptr<ReactionSystem> reaction_system;    //!< reaction system
+    const StencilKernels* stencil;                      //!< stencil kernels for the instruction set of this CPU
+
+    void (ThreeDimRD::*step_function)(unsigned int) = nullptr;  //!< time step specialized for the kinetic system
+
+public:
+    /**
+     * @brief      Constructs the object.
+     *
+     * @param[in]  _Da      Diffusion coefficient of compound A
+     * @param[in]  _Db      Diffusion coefficient of compound B
+     * @param[in]  _width   width of the system
+     * @param[in]  _height  height of the system
+     * @param[in]  _depth   depth of the system
+     * @param[in]  _dx      size of the space interval
+     * @param[in]  _dt      size of the time interval
+     * @param[in]  _steps   number of frames
+     * @param[in]  _tsteps  number of time steps when to write a frame
+     */
+    ThreeDimRD(double _Da, double _Db,
+               unsigned int _width, unsigned int _height, unsigned int _depth,
+               double _dx, double _dt, unsigned int _steps, unsigned int _tsteps);
+
+    /**
+     * @brief      Sets the reaction.
+     *
+     * Also selects the time step that is specialized for the kinetic system
+     *
+     * @param      _reaction_system  The reaction system
+     */
+    void set_reaction(ReactionSystem* _reaction_system);
+
+    /**
+     * @brief      Set whether system has periodic boundary conditions
+     *
+     * @param[in]  _pbc  Periodic boundary conditions
+     */
+    inline void set_pbc(bool _pbc) {
+        this->pbc = _pbc;
+    }
+
+    /**
+     * @brief      Set the number of threads
+     *
+     * @param[in]  _ncores  Number of cores
+     */
+    inline void set_cores(unsigned int _ncores) {
+        this->ncores = std::max(1u, _ncores);
+    }
+
+    /**
+     * @brief      Set the slice that is stored in the frames
+     *
+     * @param[in]  _slice  Index of the slice along the depth; the middle one by default
+     */
+    inline void set_slice(unsigned int _slice) {
+        this->slice = std::min(_slice, this->depth - 1);
+    }
+
+    /**
+     * @brief      Set the cache budget of a single thread
+     *
+     * @param[in]  _tile_bytes  Number of bytes
+     */
+    inline void set_tile_bytes(size_t _tile_bytes) {
+        this->tile_bytes = _tile_bytes;
+    }
+
+    /**
+     * @brief      Sets the parameters and the initial state.
+     *
+     * @param[in]  params  The parameters
+     */
+    void set_parameters(const std::string& params);
+
+    /**
+     * @brief      Perform time integration
+     */
+    void time_integrate();
+
+    /**
+     * @brief      Perform the time steps of a single frame
+     */
+    void update();
+
+    inline size_t get_num_img() const {
+        return this->ta.size();
+    }
+
+    inline unsigned int get_num_steps() const {
+        return this->steps;
+    }
+
+    /**
+     * @brief      Gets the stored slices.
+     *
+     * @param[in]  first  Whether to return concentrations of X
+     *
+     * @return     The slices, one per frame.
+     */
+    inline const auto& get_concentrations(bool first) const {
+        return first ? this->ta : this->tb;
+    }
+
+    /**
+     * @brief      Get the complete current state
+     *
+     * @param[in]  first  Whether to return concentrations of X
+     *
+     * @return     The state, with slice k in rows k * height to (k + 1) * height - 1
+     */
+    inline const MatrixXXd& get_state(bool first) const {
+        return first ? this->a : this->b;
+    }
+
+private:
+    /**
+     * @brief      Select the time step that is specialized for the kinetic system
+     *
+     * @tparam     Kinetics  Kinetic system
+     */
+    template<class Kinetics>
+    void select_step_function();
+
+    /**
+     * @brief      Perform a single explicit time step
+     *
+     * Must be called by all threads of the parallel region.
+     *
+     * @param[in]  parity  Which generation holds the current state
+     *
+     * @tparam     Kinetics  Kinetic system
+     */
+    template<class Kinetics>
+    void update_fused(unsigned int parity);
+
+    /**
+     * @brief      Get the number of rows of a slice that are swept together
+     *
+     * @return     The number of rows
+     */
+    unsigned int get_tile_rows() const;
+};
@@ -20,6 +20,40 @@
  **************************************************************************/
 
 #include "two_dim_rd.h"
+#include "reaction_lotka_volterra.h"
+#include "reaction_fitzhugh_nagumo.h"
+#include "reaction_brusselator.h"
+#include "reaction_barkley.h"
+#include "file_replace.h"
+
+#include <cstdio>
+
+/**
+ * @brief      Checksum of the fixed fields of a checkpoint
+ *
+ * @param[in]  fields  The fields
+ *
+ * @return     The 64-bit FNV-1a hash of the fields and of which of them are set
+ */
+static uint64_t checksum_fields(const CheckpointFields& fields) {
+    uint64_t hash = 0xcbf29ce484222325;
+    const auto add = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*) data;
+        for(size_t i=0; i<size; i++) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3;
+        }
+    };
+
+    const unsigned int present[] = {fields.mask.size() > 0 ? 1u : 0u,
+                                    fields.Da_field.size() > 0 ? 1u : 0u,
+                                    fields.Db_field.size() > 0 ? 1u : 0u};
+    add(present, sizeof(present));
+    add(fields.mask.data(), fields.mask.size() * sizeof(int));
+    add(fields.Da_field.data(), fields.Da_field.size() * sizeof(double));
+    add(fields.Db_field.data(), fields.Db_field.size() * sizeof(double));
+
+    return hash;
+}
 
 /**
  * @brief      Constructs the object.
@@ -45,22 +79,735 @@ TwoDimRD::TwoDimRD(double _Da, double _Db,
     dx(_dx),
     dt(_dt),
     steps(_steps),
-    tsteps(_tsteps) {
+    tsteps(_tsteps),
+    stencil(&get_stencil_kernels()) {
+
+}
+
+/**
+ * @brief      Destroys the object.
+ *
+ * Waits for a checkpoint that is still being written.
+ */
+TwoDimRD::~TwoDimRD() {
+    if(this->checkpoint_writer.joinable()) {
+        this->checkpoint_writer.join();
+    }
+}
+
+/**
+ * @brief      Create a system from a checkpoint
+ *
+ * @param[in]  filename  The filename
+ *
+ * @return     The system
+ */
+std::unique_ptr<TwoDimRD> TwoDimRD::from_checkpoint(const std::string& filename) {
+    auto ckpt = std::make_unique<Checkpoint>(read_checkpoint_file(filename));
+
+    auto system = std::make_unique<TwoDimRD>(ckpt->Da, ckpt->Db, ckpt->width, ckpt->height,
+                                             ckpt->dx, ckpt->dt, ckpt->steps - ckpt->frame, ckpt->tsteps);
+
+    switch(ckpt->reacttype) {
+        case KINETICS::LOTKA_VOLTERRA:
+            system->set_reaction(new ReactionLotkaVolterra());
+        break;
+        case KINETICS::GRAY_SCOTT:
+            system->set_reaction(new ReactionGrayScott());
+        break;
+        case KINETICS::FITZHUGH_NAGUMO:
+            system->set_reaction(new ReactionFitzhughNagumo());
+        break;
+        case KINETICS::BRUSSELATOR:
+            system->set_reaction(new ReactionBrusselator());
+        break;
+        case KINETICS::BARKLEY:
+            system->set_reaction(new ReactionBarkley());
+        break;
+        default:
+            throw std::runtime_error("Invalid reaction system in checkpoint " + filename);
+        break;
+    }
+
+    system->set_pbc(ckpt->pbc);
+    if(ckpt->fields->mask.size() > 0) {
+        system->set_mask(ckpt->fields->mask);
+    }
+    system->set_diffusivity_fields(ckpt->fields->Da_field, ckpt->fields->Db_field);
+    system->set_anisotropy(ckpt->anisotropy);
+
+    // the checkpoints of the resumed run share the fields that were read
+    system->checkpoint_fields = ckpt->fields;
+
+    system->parameters = ckpt->params;
+    system->resume_state = std::move(ckpt);
 
+    return system;
 }
 
+/**
+ * @brief      Initialize a system created by from_checkpoint() from its checkpoint
+ */
+void TwoDimRD::resume() {
+    if(!this->resume_state) {
+        throw std::logic_error("The system has not been created from a checkpoint.");
+    }
+
+    this->set_parameters(this->parameters);
+}
+
+/**
+ * @brief      Write a checkpoint of the last frame
+ *
+ * @param[in]  filename  The filename
+ */
+void TwoDimRD::write_checkpoint(const std::string& filename) {
+    if(this->checkpoint_writer.joinable()) {
+        this->checkpoint_writer.join();
+    }
+
+    write_checkpoint_file(filename, this->make_checkpoint());
+}
+
+/**
+ * @brief      Write a checkpoint in the background when the interval has passed
+ */
+void TwoDimRD::store_checkpoint() {
+    const unsigned int frame = this->frame_offset + this->ta.size() - 1;
+    if(this->checkpoint_interval == 0 || this->checkpoint_filename.empty() ||
+       frame % this->checkpoint_interval != 0) {
+        return;
+    }
+
+    // the previous checkpoint needs to be complete before it is replaced
+    if(this->checkpoint_writer.joinable()) {
+        this->checkpoint_writer.join();
+    }
+
+    // the integration only waits for a copy of the last frame
+    // the writers run one at a time, so the error needs no further guard
+    this->checkpoint_writer = std::thread([this, filename = this->checkpoint_filename, ckpt = this->make_checkpoint()]() {
+        try {
+            write_checkpoint_file(filename, ckpt);
+        } catch(const std::exception& e) {
+            this->checkpoint_error = e.what();
+        }
+    });
+    this->checkpoint_frame = frame;
+}
+
+/**
+ * @brief      Copy the state at the last frame into a checkpoint
+ *
+ * @return     The checkpoint
+ */
+Checkpoint TwoDimRD::make_checkpoint() {
+    Checkpoint ckpt;
+    ckpt.width = this->width;
+    ckpt.height = this->height;
+    ckpt.steps = this->frame_offset + this->steps;
+    ckpt.tsteps = this->tsteps;
+    ckpt.frame = this->frame_offset + this->ta.size() - 1;
+    ckpt.Da = this->Da;
+    ckpt.Db = this->Db;
+    ckpt.dx = this->dx;
+    ckpt.dt = this->dt;
+    ckpt.t = this->t;
+    ckpt.reacttype = this->reaction_system->get_reacttype();
+    ckpt.params = this->parameters;
+    ckpt.pbc = this->pbc;
+    ckpt.random_state = this->reaction_system->get_random_state();
+
+    // the mask and diffusivity fields are copied once and then shared
+    if(!this->checkpoint_fields) {
+        auto fields = std::make_shared<CheckpointFields>();
+        if(this->mask) {
+            fields->mask = this->matmask;
+        }
+        fields->Da_field = this->Da_field;
+        fields->Db_field = this->Db_field;
+        fields->checksum = checksum_fields(*fields);
+        this->checkpoint_fields = fields;
+    }
+    ckpt.fields = this->checkpoint_fields;
+    ckpt.anisotropy = this->anisotropy;
+    ckpt.steady_count = this->steady_count;
+
+    // the fixed-step integrators leave their proposed time step untouched
+    const bool adaptive_rk = this->integrator == TIME_INTEGRATOR::ADAPTIVE_HEUN_EULER ||
+                             this->integrator == TIME_INTEGRATOR::ADAPTIVE_BOGACKI_SHAMPINE;
+    ckpt.rk_step = (this->rk_integrator && adaptive_rk) ? this->rk_integrator->get_dt() : 0.0;
+
+    if(this->amr_integrator) {
+        ckpt.amr_block_size = this->amr_integrator->get_block_size();
+        ckpt.amr_step = this->amr_integrator->get_step();
+        ckpt.amr_layout = this->amr_integrator->get_layout();
+    } else {
+        ckpt.amr_block_size = 0;
+        ckpt.amr_step = 0;
+    }
+
+    // the frames hold the state in double precision for every integrator
+    ckpt.a = this->ta.back();
+    ckpt.b = this->tb.back();
+
+    return ckpt;
+}
+
+/**
+ * @brief      Write a checkpoint to a file
+ *
+ * The checkpoint is written to a temporary file that is flushed to disk and
+ * renamed when complete, such that an interrupted write never replaces a
+ * checkpoint. The mask and diffusivity fields go to a file of their own,
+ * which is only written when it holds other fields, and which the
+ * checkpoint refers to by their checksum.
+ *
+ * @param[in]  filename  The filename
+ * @param[in]  ckpt      The checkpoint
+ */
+void TwoDimRD::write_checkpoint_file(const std::string& filename, const Checkpoint& ckpt) {
+    const unsigned int has_fields = ckpt.fields->empty() ? 0 : 1;
+    if(has_fields) {
+        write_checkpoint_fields(filename + ".fields", ckpt.width, ckpt.height, *ckpt.fields);
+    }
+
+    const std::string tmpname = filename + ".tmp";
+    std::ofstream out(tmpname, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    const auto write_string = [&out](const std::string& str) {
+        const unsigned int length = str.size();
+        out.write((char*) &length, sizeof(unsigned int));
+        out.write(str.data(), length);
+    };
+
+    const uint32_t magic = CHECKPOINT_MAGIC;
+    const uint32_t version = CHECKPOINT_VERSION;
+    const int reacttype = (int)ckpt.reacttype;
+    const unsigned int pbc = ckpt.pbc ? 1 : 0;
+    const unsigned int amr_blocks = ckpt.amr_layout.size();
+
+    out.write((char*) &magic, sizeof(uint32_t));
+    out.write((char*) &version, sizeof(uint32_t));
+    out.write((char*) &ckpt.width, sizeof(unsigned int));
+    out.write((char*) &ckpt.height, sizeof(unsigned int));
+    out.write((char*) &ckpt.steps, sizeof(unsigned int));
+    out.write((char*) &ckpt.tsteps, sizeof(unsigned int));
+    out.write((char*) &ckpt.frame, sizeof(unsigned int));
+    out.write((char*) &ckpt.Da, sizeof(double));
+    out.write((char*) &ckpt.Db, sizeof(double));
+    out.write((char*) &ckpt.dx, sizeof(double));
+    out.write((char*) &ckpt.dt, sizeof(double));
+    out.write((char*) &ckpt.t, sizeof(double));
+    out.write((char*) &reacttype, sizeof(int));
+    write_string(ckpt.params);
+    out.write((char*) &pbc, sizeof(unsigned int));
+    write_string(ckpt.random_state);
+    out.write((char*) &has_fields, sizeof(unsigned int));
+    out.write((char*) &ckpt.fields->checksum, sizeof(uint64_t));
+    out.write((char*) &ckpt.anisotropy, sizeof(double));
+    out.write((char*) &ckpt.steady_count, sizeof(unsigned int));
+    out.write((char*) &ckpt.rk_step, sizeof(double));
+    out.write((char*) &ckpt.amr_block_size, sizeof(unsigned int));
+    out.write((char*) &ckpt.amr_step, sizeof(uint64_t));
+    out.write((char*) &amr_blocks, sizeof(unsigned int));
+
+    out.write((char*) ckpt.a.data(), ckpt.a.size() * sizeof(double));
+    out.write((char*) ckpt.b.data(), ckpt.b.size() * sizeof(double));
+    out.write(ckpt.amr_layout.data(), amr_blocks);
+
+    out.close();
+    if(!out.good() || !replace_file(tmpname, filename)) {
+        std::remove(tmpname.c_str());
+        throw std::runtime_error("Cannot write checkpoint " + filename);
+    }
+}
+
+/**
+ * @brief      Read a checkpoint from a file
+ *
+ * @param[in]  filename  The filename
+ *
+ * @return     The checkpoint
+ */
+Checkpoint TwoDimRD::read_checkpoint_file(const std::string& filename) {
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if(!in.good()) {
+        throw std::runtime_error("Cannot open checkpoint " + filename);
+    }
+
+    const auto read_string = [&in](std::string& str) {
+        unsigned int length = 0;
+        in.read((char*) &length, sizeof(unsigned int));
+        if(!in.good() || length > (1u << 20)) {
+            return;
+        }
+        str.resize(length);
+        in.read(&str[0], length);
+    };
+
+    Checkpoint ckpt;
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    int reacttype = 0;
+    unsigned int pbc = 0;
+    unsigned int has_fields = 0;
+    uint64_t fields_checksum = 0;
+    unsigned int amr_blocks = 0;
+
+    in.read((char*) &magic, sizeof(uint32_t));
+    in.read((char*) &version, sizeof(uint32_t));
+    if(magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION) {
+        throw std::runtime_error("Not a checkpoint of this version: " + filename);
+    }
+
+    in.read((char*) &ckpt.width, sizeof(unsigned int));
+    in.read((char*) &ckpt.height, sizeof(unsigned int));
+    in.read((char*) &ckpt.steps, sizeof(unsigned int));
+    in.read((char*) &ckpt.tsteps, sizeof(unsigned int));
+    in.read((char*) &ckpt.frame, sizeof(unsigned int));
+    in.read((char*) &ckpt.Da, sizeof(double));
+    in.read((char*) &ckpt.Db, sizeof(double));
+    in.read((char*) &ckpt.dx, sizeof(double));
+    in.read((char*) &ckpt.dt, sizeof(double));
+    in.read((char*) &ckpt.t, sizeof(double));
+    in.read((char*) &reacttype, sizeof(int));
+    read_string(ckpt.params);
+    in.read((char*) &pbc, sizeof(unsigned int));
+    read_string(ckpt.random_state);
+    in.read((char*) &has_fields, sizeof(unsigned int));
+    in.read((char*) &fields_checksum, sizeof(uint64_t));
+    in.read((char*) &ckpt.anisotropy, sizeof(double));
+    in.read((char*) &ckpt.steady_count, sizeof(unsigned int));
+    in.read((char*) &ckpt.rk_step, sizeof(double));
+    in.read((char*) &ckpt.amr_block_size, sizeof(unsigned int));
+    in.read((char*) &ckpt.amr_step, sizeof(uint64_t));
+    in.read((char*) &amr_blocks, sizeof(unsigned int));
+
+    if(!in.good() || ckpt.frame > ckpt.steps || ckpt.width == 0 || ckpt.height == 0 ||
+       (uint64_t)amr_blocks > (uint64_t)ckpt.width * ckpt.height) {
+        throw std::runtime_error("Corrupt checkpoint " + filename);
+    }
+    ckpt.reacttype = (KINETICS)reacttype;
+    ckpt.pbc = pbc != 0;
+
+    ckpt.a.resize(ckpt.height, ckpt.width);
+    ckpt.b.resize(ckpt.height, ckpt.width);
+    in.read((char*) ckpt.a.data(), ckpt.a.size() * sizeof(double));
+    in.read((char*) ckpt.b.data(), ckpt.b.size() * sizeof(double));
+    ckpt.amr_layout.resize(amr_blocks);
+    in.read(ckpt.amr_layout.data(), amr_blocks);
+
+    if(!in.good()) {
+        throw std::runtime_error("Incomplete checkpoint " + filename);
+    }
+
+    if(has_fields) {
+        ckpt.fields = read_checkpoint_fields(filename + ".fields", ckpt.width, ckpt.height, fields_checksum);
+    } else {
+        ckpt.fields = std::make_shared<CheckpointFields>();
+    }
+
+    return ckpt;
+}
+
+/**
+ * @brief      Write the fixed fields of a checkpoint, unless the file already holds them
+ *
+ * The header of an existing file is compared to the fields, such that the
+ * fields are written once per run rather than with every checkpoint.
+ *
+ * @param[in]  filename  The filename
+ * @param[in]  width     The width of the system
+ * @param[in]  height    The height of the system
+ * @param[in]  fields    The fields
+ */
+void TwoDimRD::write_checkpoint_fields(const std::string& filename, unsigned int width,
+                                       unsigned int height, const CheckpointFields& fields) {
+    const uint32_t magic = CHECKPOINT_FIELDS_MAGIC;
+    const uint32_t version = CHECKPOINT_VERSION;
+
+    {
+        std::ifstream in(filename, std::ios::in | std::ios::binary);
+        uint32_t old_magic = 0;
+        uint32_t old_version = 0;
+        unsigned int old_width = 0;
+        unsigned int old_height = 0;
+        uint64_t old_checksum = 0;
+        in.read((char*) &old_magic, sizeof(uint32_t));
+        in.read((char*) &old_version, sizeof(uint32_t));
+        in.read((char*) &old_width, sizeof(unsigned int));
+        in.read((char*) &old_height, sizeof(unsigned int));
+        in.read((char*) &old_checksum, sizeof(uint64_t));
+        if(in.good() && old_magic == magic && old_version == version && old_width == width &&
+           old_height == height && old_checksum == fields.checksum) {
+            return;
+        }
+    }
+
+    const std::string tmpname = filename + ".tmp";
+    std::ofstream out(tmpname, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    const unsigned int has_mask = fields.mask.size() > 0 ? 1 : 0;
+    const unsigned int has_Da_field = fields.Da_field.size() > 0 ? 1 : 0;
+    const unsigned int has_Db_field = fields.Db_field.size() > 0 ? 1 : 0;
+
+    out.write((char*) &magic, sizeof(uint32_t));
+    out.write((char*) &version, sizeof(uint32_t));
+    out.write((char*) &width, sizeof(unsigned int));
+    out.write((char*) &height, sizeof(unsigned int));
+    out.write((char*) &fields.checksum, sizeof(uint64_t));
+    out.write((char*) &has_mask, sizeof(unsigned int));
+    out.write((char*) &has_Da_field, sizeof(unsigned int));
+    out.write((char*) &has_Db_field, sizeof(unsigned int));
+    out.write((char*) fields.mask.data(), fields.mask.size() * sizeof(int));
+    out.write((char*) fields.Da_field.data(), fields.Da_field.size() * sizeof(double));
+    out.write((char*) fields.Db_field.data(), fields.Db_field.size() * sizeof(double));
+
+    out.close();
+    if(!out.good() || !replace_file(tmpname, filename)) {
+        std::remove(tmpname.c_str());
+        throw std::runtime_error("Cannot write checkpoint fields " + filename);
+    }
+}
+
+/**
+ * @brief      Read the fixed fields of a checkpoint
+ *
+ * @param[in]  filename  The filename
+ * @param[in]  width     The width of the system
+ * @param[in]  height    The height of the system
+ * @param[in]  checksum  The checksum of the fields stored in the checkpoint
+ *
+ * @return     The fields
+ */
+std::shared_ptr<const CheckpointFields> TwoDimRD::read_checkpoint_fields(const std::string& filename, unsigned int width,
+                                                                         unsigned int height, uint64_t checksum) {
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if(!in.good()) {
+        throw std::runtime_error("Cannot open checkpoint fields " + filename);
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    unsigned int file_width = 0;
+    unsigned int file_height = 0;
+    uint64_t file_checksum = 0;
+    unsigned int has_mask = 0;
+    unsigned int has_Da_field = 0;
+    unsigned int has_Db_field = 0;
+
+    in.read((char*) &magic, sizeof(uint32_t));
+    in.read((char*) &version, sizeof(uint32_t));
+    in.read((char*) &file_width, sizeof(unsigned int));
+    in.read((char*) &file_height, sizeof(unsigned int));
+    in.read((char*) &file_checksum, sizeof(uint64_t));
+    in.read((char*) &has_mask, sizeof(unsigned int));
+    in.read((char*) &has_Da_field, sizeof(unsigned int));
+    in.read((char*) &has_Db_field, sizeof(unsigned int));
+
+    if(!in.good() || magic != CHECKPOINT_FIELDS_MAGIC || version != CHECKPOINT_VERSION ||
+       file_width != width || file_height != height || file_checksum != checksum) {
+        throw std::runtime_error("Checkpoint fields do not belong to the checkpoint: " + filename);
+    }
+
+    auto fields = std::make_shared<CheckpointFields>();
+    if(has_mask) {
+        fields->mask.resize(height, width);
+        in.read((char*) fields->mask.data(), fields->mask.size() * sizeof(int));
+    }
+    if(has_Da_field) {
+        fields->Da_field.resize(height, width);
+        in.read((char*) fields->Da_field.data(), fields->Da_field.size() * sizeof(double));
+    }
+    if(has_Db_field) {
+        fields->Db_field.resize(height, width);
+        in.read((char*) fields->Db_field.data(), fields->Db_field.size() * sizeof(double));
+    }
+    fields->checksum = checksum_fields(*fields);
+
+    if(!in.good() || fields->checksum != checksum) {
+        throw std::runtime_error("Corrupt checkpoint fields " + filename);
+    }
+
+    return fields;
+}
+
+/**
+ * @brief      Get the double-precision concentration matrix
+ *
+ * @param[in]  first  Whether to return the concentrations of A
+ *
+ * @return     The concentration matrix
+ */
+template<>
+MatrixXXd& TwoDimRD::get_state<double>(bool first) {
+    return first ? this->a : this->b;
+}
+
+/**
+ * @brief      Get the single-precision concentration matrix
+ *
+ * @param[in]  first  Whether to return the concentrations of A
+ *
+ * @return     The concentration matrix
+ */
+template<>
+MatrixXXf& TwoDimRD::get_state<float>(bool first) {
+    return first ? this->af : this->bf;
+}
+
+/**
+ * @brief      Get the double-precision Laplacian rows
+ *
+ * @return     The Laplacian rows
+ */
+template<>
+MatrixXXd& TwoDimRD::get_linebuf<double>() {
+    return this->linebuf;
+}
+
+/**
+ * @brief      Get the single-precision Laplacian rows
+ *
+ * @return     The Laplacian rows
+ */
+template<>
+MatrixXXf& TwoDimRD::get_linebuf<float>() {
+    return this->linebuf_f;
+}
+
+/**
+ * @brief      Get the second generation of the double-precision state
+ *
+ * @param[in]  first  Whether to return the concentrations of A
+ *
+ * @return     The concentration matrix
+ */
+template<>
+MatrixXXd& TwoDimRD::get_next_state<double>(bool first) {
+    return first ? this->a_next : this->b_next;
+}
+
+/**
+ * @brief      Get the second generation of the single-precision state
+ *
+ * @param[in]  first  Whether to return the concentrations of A
+ *
+ * @return     The concentration matrix
+ */
+template<>
+MatrixXXf& TwoDimRD::get_next_state<float>(bool first) {
+    return first ? this->af_next : this->bf_next;
+}
+
+/**
+ * @brief      Get the double-precision per-thread ring buffers
+ *
+ * @return     The ring buffers
+ */
+template<>
+std::vector<MatrixXXd>& TwoDimRD::get_tilebuf<double>() {
+    return this->tilebuf;
+}
+
+/**
+ * @brief      Get the single-precision per-thread ring buffers
+ *
+ * @return     The ring buffers
+ */
+template<>
+std::vector<MatrixXXf>& TwoDimRD::get_tilebuf<float>() {
+    return this->tilebuf_f;
+}
+
+/**
+ * @brief      Get the double-precision diffusion coefficients of the faces
+ *
+ * @return     The east and south faces of A, followed by those of B
+ */
+template<>
+const std::array<MatrixXXd, 4>& TwoDimRD::get_faces<double>() const {
+    return this->faces;
+}
+
+/**
+ * @brief      Get the single-precision diffusion coefficients of the faces
+ *
+ * @return     The east and south faces of A, followed by those of B
+ */
+template<>
+const std::array<MatrixXXf, 4>& TwoDimRD::get_faces<float>() const {
+    return this->faces_f;
+}
+
+/**
+ * @brief      Sets the reaction.
+ *
+ * Also selects the time step that is specialized for the kinetic system
+ *
+ * @param      _reaction_system  The reaction system
+ */
 void TwoDimRD::set_reaction(ReactionSystem* _reaction_system) {
     this->reaction_system = std::unique_ptr<ReactionSystem>(_reaction_system);
+    this->select_step_functions();
+}
+
+/**
+ * @brief      Select the time steps that are specialized for the kinetic system
+ */
+void TwoDimRD::select_step_functions() {
+    switch(this->reaction_system->get_reacttype()) {
+        case KINETICS::LOTKA_VOLTERRA:
+            this->select_step_functions<KineticsLotkaVolterra>();
+        break;
+        case KINETICS::GRAY_SCOTT:
+            this->select_step_functions<KineticsGrayScott>();
+        break;
+        case KINETICS::FITZHUGH_NAGUMO:
+            this->select_step_functions<KineticsFitzhughNagumo>();
+        break;
+        case KINETICS::BRUSSELATOR:
+            this->select_step_functions<KineticsBrusselator>();
+        break;
+        case KINETICS::BARKLEY:
+            this->select_step_functions<KineticsBarkley>();
+        break;
+        default:
+            throw std::logic_error("Invalid reaction system encountered.");
+        break;
+    }
+}
+
+/**
+ * @brief      Select the time steps that are specialized for the kinetic system
+ *
+ * @tparam     Kinetics  Kinetic system
+ */
+template<class Kinetics>
+void TwoDimRD::select_step_functions() {
+    if(this->has_diffusion_faces()) {
+        this->step_function = &TwoDimRD::update_fused<double, Kinetics, true>;
+        this->step_function_f = &TwoDimRD::update_fused<float, Kinetics, true>;
+        this->block_function = &TwoDimRD::update_blocked<double, Kinetics, true>;
+        this->block_function_f = &TwoDimRD::update_blocked<float, Kinetics, true>;
+    } else {
+        this->step_function = &TwoDimRD::update_fused<double, Kinetics, false>;
+        this->step_function_f = &TwoDimRD::update_fused<float, Kinetics, false>;
+        this->block_function = &TwoDimRD::update_blocked<double, Kinetics, false>;
+        this->block_function_f = &TwoDimRD::update_blocked<float, Kinetics, false>;
+    }
+    this->reaction_function = &TwoDimRD::evaluate_reaction<Kinetics>;
+    this->rate_function = &TwoDimRD::evaluate_rates<Kinetics>;
+    this->row_function = &TwoDimRD::fused_row_update<double, Kinetics>;
+}
+
+/**
+ * @brief      Evaluate the reaction terms of all cells
+ *
+ * @param[in]  a     Concentrations of A
+ * @param[in]  b     Concentrations of B
+ * @param      ra    Reaction terms of A
+ * @param      rb    Reaction terms of B
+ *
+ * @tparam     Kinetics  Kinetic system
+ */
+template<class Kinetics>
+void TwoDimRD::evaluate_reaction(const double* a, const double* b, double* ra, double* rb) const {
+    const auto kp = make_kinetic_parameters<double>(this->reaction_system->get_kinetic_parameters());
+    const int ncells = this->width * this->height;
+
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<ncells; i++) {
+        Kinetics::reaction(a[i], b[i], kp, &ra[i], &rb[i]);
+    }
+}
+
+/**
+ * @brief      Evaluate the time derivatives of all cells
+ *
+ * @param[in]  a     Concentrations of A
+ * @param[in]  b     Concentrations of B
+ * @param      da    Time derivatives of A
+ * @param      db    Time derivatives of B
+ *
+ * @tparam     Kinetics  Kinetic system
+ */
+template<class Kinetics>
+void TwoDimRD::evaluate_rates(const MatrixXXd& a, const MatrixXXd& b, MatrixXXd& da, MatrixXXd& db) const {
+    const auto kp = make_kinetic_parameters<double>(this->reaction_system->get_kinetic_parameters());
+    const int nrows = a.rows();
+    const int ncols = a.cols();
+    const bool wrap = this->pbc && !this->mask;
+    const double idx2 = 1.0 / (this->dx * this->dx);
+    const double Da = this->Da;
+    const double Db = this->Db;
+
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<nrows; i++) {
+        // rows at zero-flux edges reflect onto themselves
+        const int iprev = (i > 0) ? i - 1 : (wrap ? nrows - 1 : i);
+        const int inext = (i + 1 < nrows) ? i + 1 : (wrap ? 0 : i);
+        const double* a_prev = a.row(iprev).data();
+        const double* a_cur = a.row(i).data();
+        const double* a_next = a.row(inext).data();
+        const double* b_prev = b.row(iprev).data();
+        const double* b_cur = b.row(i).data();
+        const double* b_next = b.row(inext).data();
+        double* fa = da.row(i).data();
+        double* fb = db.row(i).data();
+
+        if(this->mask) {
+            std::fill(fa, fa + ncols, 0.0);
+            std::fill(fb, fb + ncols, 0.0);
+
+            const uint32_t* cells = this->fluid_index.data() + this->fluid_row_start[i];
+            const int ncells = this->fluid_row_start[i+1] - this->fluid_row_start[i];
+            for(int k=0; k<ncells; k++) {
+                const uint32_t cell = cells[k];
+                const unsigned int j = cell >> FLUID_CODE_BITS;
+
+                // closed neighbours point to the cell itself and therefore do not contribute
+                const unsigned int jw = j - ((cell & FLUID_OPEN_WEST) ? 1 : 0);
+                const unsigned int je = j + ((cell & FLUID_OPEN_EAST) ? 1 : 0);
+                const double* ap = (cell & FLUID_OPEN_PREV) ? a_prev : a_cur;
+                const double* an = (cell & FLUID_OPEN_NEXT) ? a_next : a_cur;
+                const double* bp = (cell & FLUID_OPEN_PREV) ? b_prev : b_cur;
+                const double* bn = (cell & FLUID_OPEN_NEXT) ? b_next : b_cur;
+
+                double ra = 0;
+                double rb = 0;
+                Kinetics::reaction(a_cur[j], b_cur[j], kp, &ra, &rb);
+
+                fa[j] = Da * (ap[j] + an[j] + a_cur[jw] + a_cur[je] - 4.0 * a_cur[j]) * idx2 + ra;
+                fb[j] = Db * (bp[j] + bn[j] + b_cur[jw] + b_cur[je] - 4.0 * b_cur[j]) * idx2 + rb;
+            }
+        } else {
+            this->laplacian_row(a, i, fa, wrap);
+            this->laplacian_row(b, i, fb, wrap);
+
+            #pragma omp simd
+            for(int j=0; j<ncols; j++) {
+                double ra = 0;
+                double rb = 0;
+                Kinetics::reaction(a_cur[j], b_cur[j], kp, &ra, &rb);
+                fa[j] = Da * fa[j] + ra;
+                fb[j] = Db * fb[j] + rb;
+            }
+        }
+    }
 }
 
 /**
  * @brief      Perform time integration
  */
 void TwoDimRD::time_integrate() {
-    this->t = 0;
-
     for(unsigned int i=0; i<this->steps; i++) {
         this->update();
+
+        if(this->is_steady()) {
+            break;
+        }
     }
 
     // give newline after tqdm progress bar
@@ -128,6 +875,20 @@ const MatrixXXd& TwoDimRD::get_concentration_matrix(unsigned int frame, bool fir
  * @brief      Clean-up any variables that need to be explicitly removed from memory
  */
 void TwoDimRD::clean() {
+    // a cancelled or finished run can be resumed from its last frame
+    const unsigned int frame = this->frame_offset + this->ta.size() - 1;
+    if(this->checkpoint_interval > 0 && !this->checkpoint_filename.empty() &&
+       !this->ta.empty() && frame != this->checkpoint_frame) {
+        try {
+            this->write_checkpoint(this->checkpoint_filename);
+            this->checkpoint_frame = frame;
+        } catch(const std::exception& e) {
+            this->checkpoint_error = e.what();
+        }
+    } else if(this->checkpoint_writer.joinable()) {
+        this->checkpoint_writer.join();
+    }
+
     if(this->do_cuda) {
         // clear GPU memory and release cuda integrator object
         this->cuda_integrator->cleanup_variables();
@@ -135,16 +896,149 @@ void TwoDimRD::clean() {
     }
 }
 
+/**
+ * @brief      Allocate a matrix and zero it from the threads that will work on it
+ *
+ * The rows are divided over the threads in the same static bands as in the
+ * integration, and the threads are pinned in the same way, such that the
+ * operating system places every page on the NUMA node of the thread that
+ * touches it first. A matrix of the right size keeps its pages and is
+ * only zeroed.
+ *
+ * @param      m     The matrix
+ * @param[in]  rows  Number of rows
+ * @param[in]  cols  Number of columns
+ *
+ * @tparam     T     Floating point type
+ */
+template<typename T>
+void TwoDimRD::first_touch(MatrixXX<T>& m, unsigned int rows, unsigned int cols) const {
+    if((unsigned int)m.rows() == rows && (unsigned int)m.cols() == cols) {
+        m.setZero();
+        return;
+    }
+
+    // resizing allocates without touching the memory
+    m.resize(rows, cols);
+
+    ThreadAffinityGuard affinity(this->pinning != THREAD_PINNING::NONE);
+    omp_set_num_threads(this->get_num_threads());
+    #pragma omp parallel
+    {
+        const int tid = omp_get_thread_num();
+        const int nthreads = omp_get_num_threads();
+        pin_current_thread(this->pinning, tid, nthreads);
+
+        const size_t r0 = (size_t)tid * rows / nthreads;
+        const size_t r1 = (size_t)(tid + 1) * rows / nthreads;
+        std::fill(m.data() + r0 * cols, m.data() + r1 * cols, T(0));
+    }
+}
+
+/**
+ * @brief      Sets the parameters.
+ *
+ * @param[in]  params  The parameters
+ */
+void TwoDimRD::set_parameters(const std::string& params) {
+    this->reaction_system->set_parameters(params);
+    this->reaction_system->set_seed(params);
+    this->parameters = params;
+
+    // optional selection of a fixed-step scheme by its order
+    const auto map = this->reaction_system->parse_parameters(params);
+    const auto got = map.find("scheme");
+    if(got != map.end()) {
+        switch((int)got->second) {
+            case 1:
+                this->integrator = TIME_INTEGRATOR::EULER;
+            break;
+            case 2:
+                this->integrator = TIME_INTEGRATOR::HEUN;
+            break;
+            case 4:
+                this->integrator = TIME_INTEGRATOR::RK4;
+            break;
+            default:
+                throw std::runtime_error("Invalid scheme encountered; use 1 (Euler), 2 (Heun) or 4 (RK4).");
+            break;
+        }
+    }
+
+    this->init();
+}
+
 /**
  * @brief      Initialize the system
  */
 void TwoDimRD::init() {
-    // initialize matrices with random values
-    this->a = MatrixXXd::Zero(this->width, this->height);
-    this->b = MatrixXXd::Zero(this->width, this->height);
+    // the row updates, among which those over the diffusion faces, read a west and an east neighbour of every cell
+    if(this->width < 2) {
+        throw std::runtime_error("The system needs to be at least two cells wide.");
+    }
+
+    // all combinations are checked before any state changes, such that a
+    // rejected combination leaves neither a frame nor a consumed checkpoint
+    if(this->has_diffusion_faces() && (this->do_cuda || this->integrator != TIME_INTEGRATOR::EULER)) {
+        throw std::runtime_error("Spatially varying and anisotropic diffusion require explicit Euler on the CPU.");
+    }
+
+    if(this->laplacian_stencil != STENCIL::FIVE_POINT) {
+        if(this->do_cuda || this->mask || this->has_diffusion_faces() ||
+           this->integrator == TIME_INTEGRATOR::ADI ||
+           this->integrator == TIME_INTEGRATOR::MULTIGRID_BACKWARD_EULER ||
+           this->integrator == TIME_INTEGRATOR::MULTIGRID_CRANK_NICOLSON) {
+            throw std::runtime_error("The higher-order stencils require an explicit or spectral integrator on the CPU, without a mask or varying diffusion.");
+        }
+
+        if(this->width < 4 || this->height < 4) {
+            throw std::runtime_error("The higher-order stencils require at least four rows and columns.");
+        }
+    }
+
+    if(this->adaptive_mesh &&
+       (this->do_cuda || this->integrator != TIME_INTEGRATOR::EULER || this->mask ||
+        this->has_diffusion_faces() || this->laplacian_stencil != STENCIL::FIVE_POINT ||
+        this->precision != PRECISION::DOUBLE)) {
+        throw std::runtime_error("The adaptive mesh requires explicit Euler in double precision on the CPU with the five-point stencil, without a mask or varying diffusion.");
+    }
+
+    const bool spectral = this->integrator == TIME_INTEGRATOR::ETD1 ||
+                          this->integrator == TIME_INTEGRATOR::ETDRK2 ||
+                          this->integrator == TIME_INTEGRATOR::ETDRK4;
+    if(!this->do_cuda && spectral && this->mask) {
+        throw std::runtime_error("The spectral integrators do not support a mask.");
+    }
 
-    this->reaction_system->init(this->a, this->b);
+    const unsigned int block_size = !this->adaptive_mesh ? 0 :
+                                    this->amr_block_size > 0 ? this->amr_block_size :
+                                    AdaptiveMesh::choose_block_size(this->width, this->height);
+    if(this->adaptive_mesh && block_size == 0) {
+        throw std::runtime_error("The adaptive mesh needs the width and height to be multiples of an even block size of at least 4.");
+    }
 
+    // initialize matrices with random values; the pages are placed beforehand
+    // by the threads that integrate the respective bands
+    this->first_touch(this->a, this->height, this->width);
+    this->first_touch(this->b, this->height, this->width);
+
+    const std::unique_ptr<Checkpoint> ckpt = std::move(this->resume_state);
+    if(ckpt) {
+        // the state is restored rather than drawn; the integrators are set up from it as usual
+        this->a = ckpt->a;
+        this->b = ckpt->b;
+        this->t = ckpt->t;
+        this->frame_offset = ckpt->frame;
+        this->checkpoint_frame = this->frame_offset;
+        this->steady_count = ckpt->steady_count;
+        this->reaction_system->set_random_state(ckpt->random_state);
+    } else {
+        this->reaction_system->init(this->a, this->b);
+        this->t = 0;
+    }
+
+    // the walls are never read by the CPU integration; they are only
+    // emptied such that they do not show up in the frames
     if(this->mask) {
         this->apply_mask();
     }
@@ -155,10 +1049,179 @@ void TwoDimRD::init() {
     if(this->do_cuda) {
         // build cuda integrator object
         this->init_cuda();
+    } else if(this->integrator == TIME_INTEGRATOR::HEUN ||
+              this->integrator == TIME_INTEGRATOR::RK4) {
+        const ButcherTableau& tableau = (this->integrator == TIME_INTEGRATOR::HEUN) ?
+                                        get_tableau_heun() : get_tableau_rk4();
+        this->rk_integrator = std::make_unique<RungeKuttaIntegrator>(tableau, this->width, this->height,
+                                                                     this->dt, this->atol, this->rtol);
+    } else if(this->integrator == TIME_INTEGRATOR::ADAPTIVE_HEUN_EULER ||
+              this->integrator == TIME_INTEGRATOR::ADAPTIVE_BOGACKI_SHAMPINE) {
+        const ButcherTableau& tableau = (this->integrator == TIME_INTEGRATOR::ADAPTIVE_HEUN_EULER) ?
+                                        get_tableau_heun_euler() : get_tableau_bogacki_shampine();
+        this->rk_integrator = std::make_unique<RungeKuttaIntegrator>(tableau, this->width, this->height,
+                                                                     this->dt, this->atol, this->rtol);
+        if(ckpt && ckpt->rk_step > 0.0) {
+            this->rk_integrator->set_dt(ckpt->rk_step);
+        }
+    } else if(this->integrator == TIME_INTEGRATOR::ADI) {
+        this->adi_integrator = std::make_unique<AdiIntegrator>(this->width, this->height,
+                                                               this->dx, this->dt,
+                                                               this->Da, this->Db, this->pbc,
+                                                               this->mask ? &this->matmask : nullptr);
+    } else if(this->integrator == TIME_INTEGRATOR::MULTIGRID_BACKWARD_EULER ||
+              this->integrator == TIME_INTEGRATOR::MULTIGRID_CRANK_NICOLSON) {
+        const double theta = (this->integrator == TIME_INTEGRATOR::MULTIGRID_BACKWARD_EULER) ? 1.0 : 0.5;
+        this->mg_integrator = std::make_unique<MultigridIntegrator>(this->width, this->height,
+                                                                    this->dx, this->dt,
+                                                                    this->Da, this->Db, this->pbc,
+                                                                    this->mask ? &this->matmask : nullptr,
+                                                                    theta);
+    } else if(this->integrator == TIME_INTEGRATOR::RKL2) {
+        this->sts_integrator = std::make_unique<SuperTimeStepping>(this->width, this->height,
+                                                                   this->dx, this->dt,
+                                                                   std::max(this->Da, this->Db),
+                                                                   this->laplacian_stencil);
+    } else if(this->integrator != TIME_INTEGRATOR::EULER) {
+        this->spectral_integrator = std::make_unique<SpectralIntegrator>(this->width, this->height,
+                                                                         this->dx, this->dt,
+                                                                         this->Da, this->Db,
+                                                                         this->pbc, this->integrator,
+                                                                         this->laplacian_stencil);
+    } else if(this->adaptive_mesh) {
+        this->select_step_functions();
+        this->amr_integrator = std::make_unique<AdaptiveMesh>(this->width, this->height,
+                                                              this->dx, this->pbc,
+                                                              block_size,
+                                                              this->amr_threshold,
+                                                              this->amr_interval);
+        if(ckpt && ckpt->amr_block_size == block_size) {
+            this->amr_integrator->set_state(this->a, this->b, ckpt->amr_layout, ckpt->amr_step);
+        } else {
+            this->amr_integrator->set_state(this->a, this->b);
+        }
+    } else {
+        // a Laplacian row for both A and B per thread
+        const unsigned int nrows = 2 * this->get_num_threads();
+
+        // the uniform path is only specialized away when the diffusion is uniform and isotropic
+        this->build_diffusion_faces();
+        this->select_step_functions();
+
+        // the time steps alternate between two generations of the state; the
+        // walls of the second generation stay empty as they are never written
+        if(this->precision == PRECISION::SINGLE) {
+            this->first_touch(this->af, this->height, this->width);
+            this->first_touch(this->bf, this->height, this->width);
+            this->af = this->a.cast<float>();
+            this->bf = this->b.cast<float>();
+            this->first_touch(this->af_next, this->height, this->width);
+            this->first_touch(this->bf_next, this->height, this->width);
+            this->first_touch(this->linebuf_f, nrows, this->width);
+        }
+
+        if(this->precision == PRECISION::DOUBLE || this->validate_precision) {
+            this->first_touch(this->a_next, this->height, this->width);
+            this->first_touch(this->b_next, this->height, this->width);
+            this->first_touch(this->linebuf, nrows, this->width);
+        }
+
+        // the ring buffers of temporal blocking only hold the direct neighbours of a row
+        if(this->laplacian_stencil == STENCIL::FOURTH_ORDER) {
+            this->temporal_blocking = false;
+        }
+
+        if(this->temporal_blocking) {
+            this->init_temporal_blocking();
+            if(this->measure_blocking && !ckpt) {
+                this->measure_temporal_blocking();
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Allocate the buffers for temporal blocking
+ */
+void TwoDimRD::init_temporal_blocking() {
+    const bool single = (this->precision == PRECISION::SINGLE);
+    const size_t scalar_size = single ? sizeof(float) : sizeof(double);
+    const unsigned int nthreads = this->get_num_threads();
+
+    // limit the depth such that the ring buffers of all time levels fit in the cache budget
+    const size_t rowbytes = scalar_size * this->width;
+    const unsigned int fit = (unsigned int)(this->tile_bytes / rowbytes);
+    this->block_depth = std::max(1u, std::min(this->block_depth, fit > 2 ? (fit - 2) / 6 : 1u));
+
+    // three rows of A and B per time level, followed by a Laplacian row for both A and B
+    const unsigned int nrows = 6 * this->block_depth + 2;
+
+    const bool do_double = !single || this->validate_precision;
+    if(single) {
+        this->tilebuf_f.clear();
+        this->tilebuf_f.resize(nthreads);
+    }
+
+    if(do_double) {
+        this->tilebuf.clear();
+        this->tilebuf.resize(nthreads);
+    }
+
+    // every thread allocates its own ring buffers
+    ThreadAffinityGuard affinity(this->pinning != THREAD_PINNING::NONE);
+    omp_set_num_threads(nthreads);
+    #pragma omp parallel
+    {
+        const int tid = omp_get_thread_num();
+        pin_current_thread(this->pinning, tid, omp_get_num_threads());
+        if(single) {
+            this->tilebuf_f[tid] = MatrixXXf::Zero(nrows, this->width);
+        }
+        if(do_double) {
+            this->tilebuf[tid] = MatrixXXd::Zero(nrows, this->width);
+        }
+    }
+}
+
+/**
+ * @brief      Time temporal blocking against the plain path and keep the faster one
+ */
+void TwoDimRD::measure_temporal_blocking() {
+    const bool single = (this->precision == PRECISION::SINGLE);
+
+    // time a few blocks with and without temporal blocking from the initial state
+    const unsigned int nsteps = 2 * this->block_depth;
+    const MatrixXXd a0 = this->a;
+    const MatrixXXd b0 = this->b;
+    const MatrixXXf af0 = this->af;
+    const MatrixXXf bf0 = this->bf;
+
+    // the plain path needs the Laplacian rows, which are also allocated when not blocking
+    auto start = std::chrono::steady_clock::now();
+    this->temporal_blocking = false;
+    if(single) {
+        this->advance<float>(nsteps, this->step_function_f, this->block_function_f);
+    } else {
+        this->advance<double>(nsteps, this->step_function, this->block_function);
+    }
+    auto mid = std::chrono::steady_clock::now();
+    this->temporal_blocking = true;
+    if(single) {
+        this->advance<float>(nsteps, this->step_function_f, this->block_function_f);
     } else {
-        this->delta_a = MatrixXXd::Zero(this->width, this->height);
-        this->delta_b = MatrixXXd::Zero(this->width, this->height);
+        this->advance<double>(nsteps, this->step_function, this->block_function);
     }
+    auto end = std::chrono::steady_clock::now();
+
+    const double tplain = std::chrono::duration<double>(mid - start).count();
+    const double tblocked = std::chrono::duration<double>(end - mid).count();
+    this->blocking_speedup = tblocked > 0.0 ? tplain / tblocked : 1.0;
+    this->temporal_blocking = this->blocking_speedup > 1.0;
+
+    this->a = a0;
+    this->b = b0;
+    this->af = af0;
+    this->bf = bf0;
 }
 
 /**
@@ -168,415 +1231,781 @@ void TwoDimRD::update() {
     if(do_cuda) {
         this->update_cuda();
         this->t += this->tsteps * this->dt;
+    } else if(this->rk_integrator && (this->integrator == TIME_INTEGRATOR::HEUN ||
+                                      this->integrator == TIME_INTEGRATOR::RK4)) {
+        const auto rate = [this](const MatrixXXd& a, const MatrixXXd& b, MatrixXXd& da, MatrixXXd& db) {
+            (this->*rate_function)(a, b, da, db);
+        };
+        this->rk_integrator->advance_fixed(this->a, this->b, this->tsteps, this->dt, rate, this->ncores);
+        this->t += this->tsteps * this->dt;
+    } else if(this->rk_integrator) {
+        const auto rate = [this](const MatrixXXd& a, const MatrixXXd& b, MatrixXXd& da, MatrixXXd& db) {
+            (this->*rate_function)(a, b, da, db);
+        };
+
+        // frames are written at the same physical times as with a fixed time step
+        const double tspan = this->tsteps * this->dt;
+        this->step_statistics.push_back(this->rk_integrator->advance(this->a, this->b, tspan, rate, this->ncores));
+        this->t += tspan;
+    } else if(this->adi_integrator) {
+        const auto reaction = [this](const double* a, const double* b, double* ra, double* rb) {
+            (this->*reaction_function)(a, b, ra, rb);
+        };
+        this->adi_integrator->advance(this->a, this->b, this->tsteps, reaction, this->ncores);
+        this->t += this->tsteps * this->dt;
+    } else if(this->mg_integrator) {
+        const auto reaction = [this](const double* a, const double* b, double* ra, double* rb) {
+            (this->*reaction_function)(a, b, ra, rb);
+        };
+        this->mg_integrator->advance(this->a, this->b, this->tsteps, reaction, this->ncores);
+        this->t += this->tsteps * this->dt;
+    } else if(this->sts_integrator) {
+        const auto rate = [this](const MatrixXXd& a, const MatrixXXd& b, MatrixXXd& da, MatrixXXd& db) {
+            (this->*rate_function)(a, b, da, db);
+        };
+        this->sts_integrator->advance(this->a, this->b, this->tsteps, rate, this->ncores);
+        this->t += this->tsteps * this->dt;
+    } else if(this->amr_integrator) {
+        const auto kp = make_kinetic_parameters<double>(this->reaction_system->get_kinetic_parameters());
+        const auto update = [this, &kp](double* a_out, double* b_out, const double* a, const double* b,
+                                        const double* lap_a, const double* lap_b, unsigned int n) {
+            (this->*row_function)(a_out, b_out, a, b, lap_a, lap_b, n, kp);
+        };
+        this->amr_integrator->advance(this->tsteps, update, this->ncores);
+
+        // the frames are stored on the uniform grid
+        this->amr_integrator->get_state(this->a, this->b);
+        this->t += this->tsteps * this->dt;
+    } else if(this->spectral_integrator) {
+        const auto reaction = [this](const double* a, const double* b, double* ra, double* rb) {
+            (this->*reaction_function)(a, b, ra, rb);
+        };
+        this->spectral_integrator->advance(this->a, this->b, this->tsteps, reaction, this->ncores);
+        this->t += this->tsteps * this->dt;
     } else {
-        // loop over number of time steps
-        for(unsigned int j=0; j<this->tsteps; j++) {
-
-            // calculate laplacian
-            if(this->mask) {
-                this->laplacian_2d_mask_cached(this->delta_a, this->a);
-                this->laplacian_2d_mask_cached(this->delta_b, this->b);
-            } else if(this->pbc) {
-                this->laplacian_2d_pbc_cached(this->delta_a, this->a);
-                this->laplacian_2d_pbc_cached(this->delta_b, this->b);
-            } else {
-                this->laplacian_2d_zeroflux_cached(this->delta_a, this->a);
-                this->laplacian_2d_zeroflux_cached(this->delta_b, this->b);
-            }
-
-            // multiply with diffusion coefficient
-            this->delta_a *= this->Da;
-            this->delta_b *= this->Db;
+        const bool single = (this->precision == PRECISION::SINGLE);
 
-            // add reaction term
-            this->add_reaction();
+        // calculate laplacian, reaction term and update the concentrations in one sweep per time step
+        if(single) {
+            this->advance<float>(this->tsteps, this->step_function_f, this->block_function_f);
+        }
 
-            // multiply with time step
-            this->delta_a *= this->dt;
-            this->delta_b *= this->dt;
+        if(!single || this->validate_precision) {
+            this->advance<double>(this->tsteps, this->step_function, this->block_function);
+        }
 
-            // add delta term to concentrations
-            this->a += this->delta_a;
-            this->b += this->delta_b;
+        // update time step
+        this->t += this->tsteps * this->dt;
 
-            // apply mask
-            if(this->mask) {
-                this->apply_mask();
+        if(single) {
+            if(this->validate_precision) {
+                this->store_precision_deviation();
             }
 
-            // update time step
-            this->t += this->dt;
+            // frames are always stored in double precision
+            this->ta.push_back(this->af.cast<double>());
+            this->tb.push_back(this->bf.cast<double>());
+            this->store_update_norm();
+            this->store_checkpoint();
+            return;
         }
     }
 
     this->ta.push_back(this->a);
     this->tb.push_back(this->b);
+    this->store_update_norm();
+    this->store_checkpoint();
 }
 
 /**
- * @brief      Calculate Laplacian using central finite difference with periodic boundary conditions
- *
- * @param      delta_c  Concentration update matrix
- * @param      c        Current concentration matrix
- *
- * Note that this overwrites the current delta matrices!
+ * @brief      Store the rate of change over the last frame and update the steady-state count
  */
-void TwoDimRD::laplacian_2d_pbc(MatrixXXd& delta_c, const MatrixXXd& c) {
-    const double idx2 = 1.0 / (this->dx * this->dx);
+void TwoDimRD::store_update_norm() {
+    if(this->steady_tolerance <= 0.0 || this->ta.size() < 2) {
+        return;
+    }
 
-    omp_set_num_threads(this->ncores);
-    #pragma omp parallel for schedule(static)
-    for(int i=0; i<(int)this->height; i++) {
-        // indices
-        unsigned i1 = 0;
-        unsigned i2 = 0;
-
-        if(i == 0) {
-            i1 = this->height-1;
-            i2 = i+1;
-        } else if(i == ((int)this->height-1)) {
-            i1 = i-1;
-            i2 = 0;
-        } else {
-            i1 = i-1;
-            i2 = i+1;
-        }
+    const size_t n = this->ta.size();
+    const double tspan = this->tsteps * this->dt;
+    const auto da = (this->ta[n-1] - this->ta[n-2]).array();
+    const auto db = (this->tb[n-1] - this->tb[n-2]).array();
 
-        // loop over x axis
-        for(unsigned int j=0; j<this->width; j++) {
-            // indices
-            unsigned j1 = 0;
-            unsigned j2 = 0;
-
-            if(j == 0) {
-                j1 = this->width-1;
-                j2 = j+1;
-            } else if(j == (this->width-1)) {
-                j1 = j-1;
-                j2 = 0;
-            } else {
-                j1 = j-1;
-                j2 = j+1;
-            }
+    UpdateNorm norm;
+    norm.max_abs = std::max(da.abs().maxCoeff(), db.abs().maxCoeff()) / tspan;
+    norm.rms = std::sqrt((da.square().sum() + db.square().sum()) / (2.0 * da.size())) / tspan;
+    this->update_norms.push_back(norm);
 
-            // calculate laplacian
-            delta_c(i,j) = (-4.0 * c(i,j)
-                                 + c(i1,j)
-                                 + c(i2,j)
-                                 + c(i,j1)
-                                 + c(i,j2) ) * idx2;
-        }
+    if(norm.max_abs < this->steady_tolerance) {
+        this->steady_count++;
+    } else {
+        this->steady_count = 0;
     }
 }
 
 /**
- * @brief      Calculate Laplacian using central finite difference with periodic boundary conditions
+ * @brief      Store the deviation of the single-precision state from the double-precision state
+ */
+void TwoDimRD::store_precision_deviation() {
+    const auto da = (this->af.cast<double>() - this->a).array();
+    const auto db = (this->bf.cast<double>() - this->b).array();
+
+    PrecisionDeviation dev;
+    dev.max_abs = std::max(da.abs().maxCoeff(), db.abs().maxCoeff());
+
+    const double norm = std::sqrt(this->a.squaredNorm() + this->b.squaredNorm());
+    const double diff = std::sqrt(da.square().sum() + db.square().sum());
+    dev.rel_l2 = norm > 0.0 ? diff / norm : diff;
+
+    this->deviations.push_back(dev);
+}
+
+/**
+ * @brief      Calculate the Laplacian of a row using the selected stencil
  *
- * This function attempt to reduce cache misses
+ * The rows beyond the edges of the domain wrap around or are mirrored,
+ * see stencil_index().
  *
- * @param      delta_c  Concentration update matrix
- * @param      c        Current concentration matrix
+ * @param[in]  c     Concentration matrix
+ * @param[in]  i     Row index
+ * @param      lap   Output row of the Laplacian
+ * @param[in]  wrap  Whether the boundaries are periodic
  *
- * Note that this overwrites the current delta matrices!
+ * @tparam     T     Floating point type
  */
-void TwoDimRD::laplacian_2d_pbc_cached(MatrixXXd& delta_c, const MatrixXXd& c) {
-    const double idx2 = 1.0 / (this->dx * this->dx);
+template<typename T>
+void TwoDimRD::laplacian_row(const MatrixXX<T>& c, int i, T* lap, bool wrap) const {
+    const int nrows = c.rows();
+    const unsigned int ncols = c.cols();
+    const T idx2 = (T)(1.0 / (this->dx * this->dx));
+    const auto row = [&](int k) {
+        return c.row(stencil_index(k, nrows, wrap)).data();
+    };
+
+    switch(this->laplacian_stencil) {
+        case STENCIL::FOURTH_ORDER:
+            if(wrap) {
+                laplacian_row_fourth_order_pbc(*this->stencil, lap, row(i-2), row(i-1), row(i), row(i+1), row(i+2), ncols, idx2);
+            } else {
+                laplacian_row_fourth_order_zeroflux(*this->stencil, lap, row(i-2), row(i-1), row(i), row(i+1), row(i+2), ncols, idx2);
+            }
+        break;
+        case STENCIL::NINE_POINT:
+            if(wrap) {
+                laplacian_row_nine_point_pbc(*this->stencil, lap, row(i-1), row(i), row(i+1), ncols, idx2);
+            } else {
+                laplacian_row_nine_point_zeroflux(*this->stencil, lap, row(i-1), row(i), row(i+1), ncols, idx2);
+            }
+        break;
+        default:
+            if(wrap) {
+                laplacian_row_pbc(*this->stencil, lap, row(i-1), row(i), row(i+1), ncols, idx2);
+            } else {
+                laplacian_row_zeroflux(*this->stencil, lap, row(i-1), row(i), row(i+1), ncols, idx2);
+            }
+        break;
+    }
+}
 
+/**
+ * @brief      Set the concentrations in the masked cells to zero
+ */
+void TwoDimRD::apply_mask() {
     omp_set_num_threads(this->ncores);
     #pragma omp parallel for schedule(static)
     for(int i=0; i<(int)this->height; i++) {
-        // indices
-        unsigned i1 = 0;
-        unsigned i2 = 0;
-
-        if(i == 0) {
-            i1 = this->height-1;
-            i2 = i+1;
-        } else if(i == ((int)this->height-1)) {
-            i1 = i-1;
-            i2 = 0;
-        } else {
-            i1 = i-1;
-            i2 = i+1;
-        }
-
-        const auto row_up = c.row(i1);
-        const auto row_cur = c.row(i);
-        const auto row_down = c.row(i2);
-
-        // loop over x axis
         for(unsigned int j=0; j<this->width; j++) {
-            // indices
-            unsigned j1 = 0;
-            unsigned j2 = 0;
-
-            if(j == 0) {
-                j1 = this->width-1;
-                j2 = j+1;
-            } else if(j == (this->width-1)) {
-                j1 = j-1;
-                j2 = 0;
-            } else {
-                j1 = j-1;
-                j2 = j+1;
+            if(this->matmask(i,j) == 1) {
+                this->a(i,j) = 0.0;
+                this->b(i,j) = 0.0;
             }
-
-            // calculate laplacian
-            delta_c(i,j) = (-4.0 * row_cur(j)
-                                 + row_down(j)
-                                 + row_up(j)
-                                 + row_cur(j1)
-                                 + row_cur(j2) ) * idx2;
         }
     }
 }
 
 /**
- * @brief      Calculate Laplacian using central finite difference with zero-flux boundaries
+ * @brief      Set the diffusivity mask
  *
- * @param      delta_c  Concentration update matrix
- * @param      c        Current concentration matrix
- *
- * Note that this overwrites the current delta matrices!
+ * @param[in]  _mask  The mask
  */
-void TwoDimRD::laplacian_2d_zeroflux(MatrixXXd& delta_c, const MatrixXXd& c) {
-    unsigned int mheight = c.rows();
-    unsigned int mwidth = c.cols();
+void TwoDimRD::set_mask(const MatrixXXi& _mask) {
+    if(_mask.rows() != this->height || _mask.cols() != this->width) {
+        throw std::runtime_error("Dimensions of the mask do not match those of the system.");
+    }
 
-    const double idx2 = 1.0 / (dx * dx);
+    this->matmask = _mask;
+    this->mask = true;
+    this->build_fluid_index();
+    this->checkpoint_fields.reset();
+}
 
-    omp_set_num_threads(this->ncores);
-    #pragma omp parallel for
-    for(int i=0; i<(int)mheight; i++) {
-        for(unsigned int j=0; j<mwidth; j++) {
+/**
+ * @brief      Set spatially varying diffusion coefficients
+ *
+ * @param[in]  _Da_field  Diffusion coefficient of A per cell; empty for the uniform Da
+ * @param[in]  _Db_field  Diffusion coefficient of B per cell; empty for the uniform Db
+ */
+void TwoDimRD::set_diffusivity_fields(const MatrixXXd& _Da_field, const MatrixXXd& _Db_field) {
+    for(const MatrixXXd* field : {&_Da_field, &_Db_field}) {
+        if(field->size() > 0 && (field->rows() != this->height || field->cols() != this->width)) {
+            throw std::runtime_error("Dimensions of the diffusivity field do not match those of the system.");
+        }
+    }
 
-            double ddx = 0;
-            double ddy = 0;
+    this->Da_field = _Da_field;
+    this->Db_field = _Db_field;
+    this->checkpoint_fields.reset();
+}
 
-            if(i == 0) {
-                ddy = c(i+1,j) - c(i, j);
-            } else if(i == ((int)mheight - 1)) {
-                ddy = c(i-1,j) - c(i, j);
-            } else {
-                ddy = (-2.0 * c(i,j) + c(i-1,j) + c(i+1,j));
-            }
+/**
+ * @brief      Build the diffusion coefficients of the faces of all cells
+ *
+ * Every cell stores the coefficient of its east and south face, divided by
+ * dx^2; the west and north faces are those of its neighbours. Faces at the
+ * edges of the domain only connect to the other side with periodic
+ * boundary conditions and without a mask. Faces next to a wall are closed.
+ */
+void TwoDimRD::build_diffusion_faces() {
+    if(!this->has_diffusion_faces()) {
+        this->faces = std::array<MatrixXXd, 4>();
+        this->faces_f = std::array<MatrixXXf, 4>();
+        return;
+    }
 
-            if(j == 0) {
-                ddx = c(i,j+1) - c(i, j);
-            } else if(j == (mwidth - 1)) {
-                ddx = c(i,j-1) - c(i, j);
-            } else {
-                ddx = (-2.0 * c(i,j) + c(i,j-1) + c(i,j+1));
+    const int nrows = this->height;
+    const int ncols = this->width;
+    const bool wrap = this->pbc && !this->mask;
+    const double idx2 = 1.0 / (this->dx * this->dx);
+
+    const auto is_open = [&](int i, int j, int in, int jn) {
+        return !this->mask || (this->matmask(i,j) != 1 && this->matmask(in,jn) != 1);
+    };
+
+    for(unsigned int s=0; s<2; s++) {
+        const MatrixXXd& field = (s == 0) ? this->Da_field : this->Db_field;
+        const double D = (s == 0) ? this->Da : this->Db;
+        const auto diffusivity = [&](int i, int j) {
+            return field.size() > 0 ? field(i,j) : D;
+        };
+
+        MatrixXXd& east = this->faces[2 * s];
+        MatrixXXd& south = this->faces[2 * s + 1];
+        east = MatrixXXd::Zero(nrows, ncols);
+        south = MatrixXXd::Zero(nrows, ncols);
+
+        for(int i=0; i<nrows; i++) {
+            for(int j=0; j<ncols; j++) {
+                const int je = (j + 1 < ncols) ? j + 1 : (wrap ? 0 : -1);
+                const int is = (i + 1 < nrows) ? i + 1 : (wrap ? 0 : -1);
+
+                if(je >= 0 && is_open(i, j, i, je)) {
+                    east(i,j) = 0.5 * (diffusivity(i,j) + diffusivity(i,je)) * idx2;
+                }
+                if(is >= 0 && is_open(i, j, is, j)) {
+                    south(i,j) = 0.5 * (diffusivity(i,j) + diffusivity(is,j)) * idx2 / this->anisotropy;
+                }
             }
+        }
+    }
 
-            // calculate laplacian
-            delta_c(i,j) = (ddx + ddy) * idx2;
+    if(this->precision == PRECISION::SINGLE) {
+        for(unsigned int k=0; k<4; k++) {
+            this->faces_f[k] = this->faces[k].cast<float>();
         }
     }
 }
 
 /**
- * @brief      Calculate Laplacian using central finite difference with zero-flux boundaries
+ * @brief      Build the index of the fluid cells from the mask
  *
- * This function attempt to reduce cache misses
- *
- * @param      delta_c  Concentration update matrix
- * @param      c        Current concentration matrix
- *
- * Note that this overwrites the current delta matrices!
+ * Every fluid cell is stored as its column together with a code of which
+ * of its four neighbours are fluid as well. Walls and the edges of the
+ * domain are both closed, such that there is no flux through them.
  */
-void TwoDimRD::laplacian_2d_zeroflux_cached(MatrixXXd& delta_c, const MatrixXXd& c) {
-    unsigned int mheight = c.rows();
-    unsigned int mwidth = c.cols();
+void TwoDimRD::build_fluid_index() {
+    const int nrows = this->matmask.rows();
+    const int ncols = this->matmask.cols();
 
-    const double idx2 = 1.0 / (dx * dx);
-
-    omp_set_num_threads(this->ncores);
-    #pragma omp parallel for
-    for(int i=0; i<(int)mheight; i++) {
+    this->fluid_index.clear();
+    this->fluid_row_start.assign(nrows + 1, 0);
 
-        const auto& row_down = c.row(i > 0 ? i-1 : i);
-        const auto& row_cur = c.row(i);
-        const auto& row_up = c.row(i < ((int)mheight-1) ? i+1 : i);
+    const auto is_fluid = [&](int i, int j) {
+        return i >= 0 && i < nrows && j >= 0 && j < ncols && this->matmask(i,j) != 1;
+    };
 
-        for(unsigned int j=0; j<mwidth; j++) {
-
-            double ddx = 0;
-            double ddy = 0;
-
-            if(i == 0) {
-                ddy = row_up(j) - row_cur(j);
-            } else if(i == ((int)mheight - 1)) {
-                ddy = row_down(j) - row_cur(j);
-            } else {
-                ddy = (-2.0 * row_cur(j) + row_down(j) + row_up(j));
+    for(int i=0; i<nrows; i++) {
+        this->fluid_row_start[i] = this->fluid_index.size();
+        for(int j=0; j<ncols; j++) {
+            if(!is_fluid(i,j)) {
+                continue;
             }
 
-            if(j == 0) {
-                ddx = c(i,j+1) - c(i, j);
-            } else if(j == (mwidth - 1)) {
-                ddx = c(i,j-1) - c(i, j);
-            } else {
-                ddx = (-2.0 * row_cur(j) + row_cur(j-1) + row_cur(j+1));
-            }
+            uint32_t code = 0;
+            code |= is_fluid(i-1, j) ? FLUID_OPEN_PREV : 0;
+            code |= is_fluid(i+1, j) ? FLUID_OPEN_NEXT : 0;
+            code |= is_fluid(i, j-1) ? FLUID_OPEN_WEST : 0;
+            code |= is_fluid(i, j+1) ? FLUID_OPEN_EAST : 0;
 
-            // calculate laplacian
-            delta_c(i,j) = (ddx + ddy) * idx2;
+            this->fluid_index.push_back(((uint32_t)j << FLUID_CODE_BITS) | code);
         }
     }
+    this->fluid_row_start[nrows] = this->fluid_index.size();
 }
 
 /**
- * @brief      Calculate Laplacian using central finite difference with zero-flux mask
+ * @brief      Advance the state by a number of time steps in a single parallel region
+ *
+ * The threads are forked once per call rather than once per time step. Each
+ * thread owns a fixed band of rows for the whole call; the plain path only
+ * synchronizes once per time step, after all bands have written the new
+ * generation. The generations are swapped at the end if the number of time
+ * steps is odd, such that the state always resides in the same matrices
+ * between calls.
  *
- * @param      delta_c  Concentration update matrix
- * @param      c        Current concentration matrix
+ * @param[in]  nsteps  Number of time steps
+ * @param[in]  step    Time step specialized for the kinetic system
+ * @param[in]  block   Temporal block specialized for the kinetic system
  *
- * Note that this overwrites the current delta matrices!
+ * @tparam     T       Floating point type
  */
-void TwoDimRD::laplacian_2d_mask(MatrixXXd& delta_c, const MatrixXXd& c) {
-    unsigned int mheight = c.rows();
-    unsigned int mwidth = c.cols();
-
-    const double idx2 = 1.0 / (dx * dx);
-
-    omp_set_num_threads(this->ncores);
-    #pragma omp parallel for
-    for(int i=0; i<(int)mheight; i++) {
-        for(unsigned int j=0; j<mwidth; j++) {
-
-            if(this->matmask(i,j) == 1) {
-                continue;
+template<typename T>
+void TwoDimRD::advance(unsigned int nsteps,
+                       void (TwoDimRD::*step)(unsigned int),
+                       void (TwoDimRD::*block)(unsigned int)) {
+    ThreadAffinityGuard affinity(this->pinning != THREAD_PINNING::NONE);
+    omp_set_num_threads(this->get_num_threads());
+    #pragma omp parallel
+    {
+        pin_current_thread(this->pinning, omp_get_thread_num(), omp_get_num_threads());
+
+        if(this->temporal_blocking) {
+            for(unsigned int j=0; j<nsteps; j+=this->block_depth) {
+                (this->*block)(std::min(this->block_depth, nsteps - j));
             }
-
-            double ddx = 0;
-            double ddy = 0;
-
-            if(this->matmask(i-1,j) == 1) {         // north boundary
-                ddy = c(i+1,j) - c(i, j);
-            } else if(this->matmask(i+1,j) == 1) {  // south boundary
-                ddy = c(i-1,j) - c(i, j);
-            } else {                                // otherwise
-                ddy = (-2.0 * c(i,j) + c(i-1,j) + c(i+1,j));
+        } else {
+            for(unsigned int j=0; j<nsteps; j++) {
+                (this->*step)(j & 1);
             }
 
-            if(this->matmask(i,j-1) == 1) {         // west boundary
-                ddx = c(i,j+1) - c(i, j);
-            } else if(this->matmask(i,j+1) == 1) {  // east boundary
-                ddx = c(i,j-1) - c(i, j);
-            } else {
-                ddx = (-2.0 * c(i,j) + c(i,j-1) + c(i,j+1));
+            if(nsteps & 1) {
+                #pragma omp single
+                {
+                    this->get_state<T>(true).swap(this->get_next_state<T>(true));
+                    this->get_state<T>(false).swap(this->get_next_state<T>(false));
+                }
             }
-
-            // calculate laplacian
-            delta_c(i,j) = (ddx + ddy) * idx2;
         }
     }
 }
 
 /**
- * @brief      Calculate Laplacian using central finite difference with zero-flux mask
+ * @brief      Perform a single explicit time step in one sweep over the band of the calling thread
  *
- * This function attempt to reduce cache misses
+ * Laplacian, reaction term and Euler update are evaluated per cell. The
+ * current generation of the state is only read and the new state is written
+ * to the other generation, such that the rows just outside the band can be
+ * read directly from the matrices of the neighbouring threads. A single
+ * barrier per step suffices: a thread can only overwrite a generation after
+ * all threads have passed the barrier following the step in which it was
+ * read.
  *
- * @param      delta_c  Concentration update matrix
- * @param      c        Current concentration matrix
+ * @param[in]  parity  Which generation holds the current state
  *
- * Note that this overwrites the current delta matrices!
+ * @tparam     T         Floating point type
+ * @tparam     Kinetics  Kinetic system
+ * @tparam     Faces     Whether to use the diffusion coefficients of the faces
  */
-void TwoDimRD::laplacian_2d_mask_cached(MatrixXXd& delta_c, const MatrixXXd& c) {
-    unsigned int mheight = c.rows();
-    unsigned int mwidth = c.cols();
+template<typename T, class Kinetics, bool Faces>
+void TwoDimRD::update_fused(unsigned int parity) {
+    const MatrixXX<T>& a = parity ? this->get_next_state<T>(true) : this->get_state<T>(true);
+    const MatrixXX<T>& b = parity ? this->get_next_state<T>(false) : this->get_state<T>(false);
+    MatrixXX<T>& a_out = parity ? this->get_state<T>(true) : this->get_next_state<T>(true);
+    MatrixXX<T>& b_out = parity ? this->get_state<T>(false) : this->get_next_state<T>(false);
+    MatrixXX<T>& linebuf = this->get_linebuf<T>();
+
+    const int nrows = a.rows();
+    const int ncols = a.cols();
+    const bool wrap = this->pbc && !this->mask;
+
+    const auto kp = make_kinetic_parameters<T>(this->reaction_system->get_kinetic_parameters());
+
+    const int tid = omp_get_thread_num();
+    const int nthreads = omp_get_num_threads();
+    const int r0 = (int)((long)tid * nrows / nthreads);
+    const int r1 = (int)((long)(tid + 1) * nrows / nthreads);
+
+    T* lap_a = linebuf.row(tid * 2 + 0).data();
+    T* lap_b = linebuf.row(tid * 2 + 1).data();
+
+    // the fourth-order stencil reaches two rows out; it excludes a mask and the faces
+    if(this->laplacian_stencil == STENCIL::FOURTH_ORDER) {
+        for(int i=r0; i<r1; i++) {
+            this->laplacian_row(a, i, lap_a, wrap);
+            this->laplacian_row(b, i, lap_b, wrap);
+            this->fused_row_update<T, Kinetics>(a_out.row(i).data(), b_out.row(i).data(),
+                                                a.row(i).data(), b.row(i).data(), lap_a, lap_b, ncols, kp);
+        }
 
-    const double idx2 = 1.0 / (dx * dx);
+        #pragma omp barrier
+        return;
+    }
 
-    omp_set_num_threads(this->ncores);
-    #pragma omp parallel for
-    for(int i=0; i<(int)mheight; i++) {
+    for(int i=r0; i<r1; i++) {
+        // at the edges of the domain the neighbouring rows either wrap around
+        // or reflect onto the row itself
+        const int iprev = (i > 0) ? i - 1 : (wrap ? nrows - 1 : i);
+        const int inext = (i + 1 < nrows) ? i + 1 : (wrap ? 0 : i);
 
-        const auto& row_down = c.row(i > 0 ? i-1 : i);
-        const auto& row_cur = c.row(i);
-        const auto& row_up = c.row(i < ((int)mheight-1) ? i+1 : i);
+        this->update_row<T, Kinetics, Faces>(i, a_out.row(i).data(), b_out.row(i).data(),
+                                      a.row(iprev).data(), a.row(i).data(), a.row(inext).data(),
+                                      b.row(iprev).data(), b.row(i).data(), b.row(inext).data(),
+                                      lap_a, lap_b, ncols, kp);
+    }
 
-        const auto& mask_down = this->matmask.row(i > 0 ? i-1 : i);
-        const auto& mask_cur = this->matmask.row(i);
-        const auto& mask_up = this->matmask.row(i < ((int)mheight-1) ? i+1 : i);
+    #pragma omp barrier
+}
 
-        for(unsigned int j=0; j<mwidth; j++) {
+/**
+ * @brief      Perform several explicit time steps using temporal blocking
+ *
+ * Every thread owns a band of rows and sweeps over it once for all time
+ * steps: time level s updates row q as soon as level s-1 has produced rows
+ * q-1, q and q+1. Only the last three rows of every intermediate level
+ * are kept in a thread-local ring buffer, which is sized to fit in the
+ * cache. To be independent of its neighbours, each band is extended by a
+ * halo of nsteps rows that is recomputed by both threads; the halo shrinks
+ * by one row per level. At zero-flux and masked domain edges there is no
+ * halo. The result is written to a second set of matrices which is swapped
+ * with the state at the end, after all threads have finished their band.
+ *
+ * @param[in]  nsteps  Number of time steps, at most the block depth
+ *
+ * @tparam     T         Floating point type
+ * @tparam     Kinetics  Kinetic system
+ * @tparam     Faces     Whether to use the diffusion coefficients of the faces
+ */
+template<typename T, class Kinetics, bool Faces>
+void TwoDimRD::update_blocked(unsigned int nsteps) {
+    MatrixXX<T>& a = this->get_state<T>(true);
+    MatrixXX<T>& b = this->get_state<T>(false);
+    MatrixXX<T>& a_gen = this->get_next_state<T>(true);
+    MatrixXX<T>& b_gen = this->get_next_state<T>(false);
+    std::vector<MatrixXX<T>>& tilebuf = this->get_tilebuf<T>();
+
+    const int nrows = a.rows();
+    const int ncols = a.cols();
+    const int n = nsteps;
+    const bool wrap = this->pbc && !this->mask;
+
+    const auto kp = make_kinetic_parameters<T>(this->reaction_system->get_kinetic_parameters());
+
+    const int tid = omp_get_thread_num();
+    const int nthreads = omp_get_num_threads();
+    const int r0 = (int)((long)tid * nrows / nthreads);
+    const int r1 = (int)((long)(tid + 1) * nrows / nthreads);
+
+    // ring buffers of three rows of A and B per time level, followed by the Laplacian rows
+    MatrixXX<T>& ring = tilebuf[tid];
+    T* lap_a = ring.row(6 * n + 0).data();
+    T* lap_b = ring.row(6 * n + 1).data();
+
+    // rows of the band including its halo
+    int g0 = r0 - n;
+    int g1 = r1 + n;
+    bool top_halo = true;
+    bool bottom_halo = true;
+    if(!wrap) {
+        if(g0 <= 0) {
+            g0 = 0;
+            top_halo = false;
+        }
+        if(g1 >= nrows) {
+            g1 = nrows;
+            bottom_halo = false;
+        }
+    }
+    const int nloc = (r0 < r1) ? g1 - g0 : 0;
 
-            if(mask_cur(j) == 1) {
+    // row r of the band at time level s; level 0 is the current state
+    const auto row_a = [&](int s, int r) -> const T* {
+        if(s == 0) {
+            return a.row(((g0 + r) % nrows + nrows) % nrows).data();
+        }
+        return ring.row((s - 1) * 6 + (r % 3)).data();
+    };
+    const auto row_b = [&](int s, int r) -> const T* {
+        if(s == 0) {
+            return b.row(((g0 + r) % nrows + nrows) % nrows).data();
+        }
+        return ring.row((s - 1) * 6 + 3 + (r % 3)).data();
+    };
+
+    for(int p=0; p<nloc+n; p++) {
+        for(int s=1; s<=n; s++) {
+            // the rows that are valid at this level shrink by one on each side with a halo
+            const int q = p - s;
+            const int lo = top_halo ? s : 0;
+            const int hi = bottom_halo ? nloc - s : nloc;
+            if(q < lo || q >= hi) {
                 continue;
             }
 
-            double ddx = 0;
-            double ddy = 0;
-
-            if(mask_up(j) == 1) {                   // north boundary
-                ddy = row_down(j) - row_cur(j);
-            } else if(mask_down(j) == 1) {          // south boundary
-                ddy = row_up(j) - row_cur(j);
-            } else {                                // otherwise
-                ddy = (-2.0 * row_cur(j) + row_down(j) + row_up(j));
+            // the last level only produces the rows of the band itself
+            if(s == n && (g0 + q < r0 || g0 + q >= r1)) {
+                continue;
             }
 
-            if(mask_cur(j-1) == 1) {                // west boundary
-                ddx = row_cur(j+1) - row_cur(j);
-            } else if(mask_cur(j+1) == 1) {         // east boundary
-                ddx = row_cur(j-1) - row_cur(j);
-            } else {                                // otherwise
-                ddx = (-2.0 * row_cur(j) + row_cur(j-1) + row_cur(j+1));
-            }
+            // rows at the edge of the domain reflect onto themselves
+            const T* a_cur = row_a(s-1, q);
+            const T* b_cur = row_b(s-1, q);
+            const T* a_prev = (q > 0) ? row_a(s-1, q-1) : a_cur;
+            const T* b_prev = (q > 0) ? row_b(s-1, q-1) : b_cur;
+            const T* a_next = (q + 1 < nloc) ? row_a(s-1, q+1) : a_cur;
+            const T* b_next = (q + 1 < nloc) ? row_b(s-1, q+1) : b_cur;
+
+            T* a_out = (s == n) ? a_gen.row(g0 + q).data() : ring.row((s - 1) * 6 + (q % 3)).data();
+            T* b_out = (s == n) ? b_gen.row(g0 + q).data() : ring.row((s - 1) * 6 + 3 + (q % 3)).data();
 
-            // calculate laplacian
-            delta_c(i,j) = (ddx + ddy) * idx2;
+            const int gi = ((g0 + q) % nrows + nrows) % nrows;
+            this->update_row<T, Kinetics, Faces>(gi, a_out, b_out, a_prev, a_cur, a_next, b_prev, b_cur, b_next,
+                                          lap_a, lap_b, ncols, kp);
         }
     }
+
+    // all bands need to be complete before the state is replaced
+    #pragma omp barrier
+    #pragma omp single
+    {
+        a.swap(a_gen);
+        b.swap(b_gen);
+    }
 }
 
 /**
- * @brief      Calculate reaction term
+ * @brief      Update a single row according to the boundary conditions
+ *
+ * @param[in]  i       Row index
+ * @param      a_out   Output row of A
+ * @param      b_out   Output row of B
+ * @param[in]  a_prev  Original row i-1 of A
+ * @param[in]  a_cur   Original row i of A
+ * @param[in]  a_next  Original row i+1 of A
+ * @param[in]  b_prev  Original row i-1 of B
+ * @param[in]  b_cur   Original row i of B
+ * @param[in]  b_next  Original row i+1 of B
+ * @param      lap_a   Scratch row for the Laplacian of A
+ * @param      lap_b   Scratch row for the Laplacian of B
+ * @param[in]  ncols   Number of columns
+ * @param[in]  kp      Kinetic parameters
  *
- * Add the value to the current delta matrices
+ * @tparam     T         Floating point type
+ * @tparam     Kinetics  Kinetic system
+ * @tparam     Faces     Whether to use the diffusion coefficients of the faces
  */
-void TwoDimRD::add_reaction() {
-    omp_set_num_threads(this->ncores);
-
-    #pragma omp parallel for schedule(static)
-    for(int i=0; i<(int)this->height; i++) {
-        for(unsigned int j=0; j<this->width; j++) {
-
-            const double a = this->a(i,j);
-            const double b = this->b(i,j);
-
-            double ra = 0;
-            double rb = 0;
+template<typename T, class Kinetics, bool Faces>
+void TwoDimRD::update_row(unsigned int i, T* a_out, T* b_out,
+                          const T* a_prev, const T* a_cur, const T* a_next,
+                          const T* b_prev, const T* b_cur, const T* b_next,
+                          T* lap_a, T* lap_b,
+                          unsigned int ncols, const KineticParameters<T>& kp) const {
+    if(Faces) {
+        this->fused_row_faces<T, Kinetics>(i, a_out, b_out, a_prev, a_cur, a_next, b_prev, b_cur, b_next, ncols, kp);
+        return;
+    }
 
-            this->reaction_system->reaction(a, b, &ra, &rb);
+    if(this->mask) {
+        this->fused_row_mask<T, Kinetics>(i, a_out, b_out, a_prev, a_cur, a_next, b_prev, b_cur, b_next, ncols, kp);
+        return;
+    }
 
-            this->delta_a(i,j) += ra;
-            this->delta_b(i,j) += rb;
+    const T idx2 = (T)(1.0 / (this->dx * this->dx));
+    if(this->laplacian_stencil == STENCIL::NINE_POINT) {
+        if(this->pbc) {
+            laplacian_row_nine_point_pbc(*this->stencil, lap_a, a_prev, a_cur, a_next, ncols, idx2);
+            laplacian_row_nine_point_pbc(*this->stencil, lap_b, b_prev, b_cur, b_next, ncols, idx2);
+        } else {
+            laplacian_row_nine_point_zeroflux(*this->stencil, lap_a, a_prev, a_cur, a_next, ncols, idx2);
+            laplacian_row_nine_point_zeroflux(*this->stencil, lap_b, b_prev, b_cur, b_next, ncols, idx2);
         }
+    } else if(this->pbc) {
+        laplacian_row_pbc(*this->stencil, lap_a, a_prev, a_cur, a_next, ncols, idx2);
+        laplacian_row_pbc(*this->stencil, lap_b, b_prev, b_cur, b_next, ncols, idx2);
+    } else {
+        laplacian_row_zeroflux(*this->stencil, lap_a, a_prev, a_cur, a_next, ncols, idx2);
+        laplacian_row_zeroflux(*this->stencil, lap_b, b_prev, b_cur, b_next, ncols, idx2);
     }
+    this->fused_row_update<T, Kinetics>(a_out, b_out, a_cur, b_cur, lap_a, lap_b, ncols, kp);
 }
 
 /**
- * @brief      Calculate reaction term
+ * @brief      Update a single row from its Laplacians
  *
- * Add the value to the current delta matrices
+ * The Laplacians of the row have been evaluated by the stencil kernels,
+ * such that the remaining loop has no branches and is vectorized.
+ *
+ * @param      a_out   Output row of A
+ * @param      b_out   Output row of B
+ * @param[in]  a_cur   Original row of A
+ * @param[in]  b_cur   Original row of B
+ * @param[in]  lap_a   Laplacian of the row of A
+ * @param[in]  lap_b   Laplacian of the row of B
+ * @param[in]  ncols   Number of columns
+ * @param[in]  kp      Kinetic parameters
+ *
+ * @tparam     T         Floating point type
+ * @tparam     Kinetics  Kinetic system
  */
-void TwoDimRD::apply_mask() {
-    omp_set_num_threads(this->ncores);
-    #pragma omp parallel for schedule(static)
-    for(int i=0; i<(int)this->height; i++) {
-        for(unsigned int j=0; j<this->width; j++) {
+template<typename T, class Kinetics>
+void TwoDimRD::fused_row_update(T* a_out, T* b_out,
+                                const T* a_cur, const T* b_cur,
+                                const T* lap_a, const T* lap_b,
+                                unsigned int ncols, const KineticParameters<T>& kp) const {
+    const T Da = (T)this->Da;
+    const T Db = (T)this->Db;
+    const T dt = (T)this->dt;
+
+    #pragma omp simd
+    for(unsigned int j=0; j<ncols; j++) {
+        T ra = 0;
+        T rb = 0;
+        Kinetics::reaction(a_cur[j], b_cur[j], kp, &ra, &rb);
+
+        a_out[j] = a_cur[j] + (lap_a[j] * Da + ra) * dt;
+        b_out[j] = b_cur[j] + (lap_b[j] * Db + rb) * dt;
+    }
+}
+
+/**
+ * @brief      Update a single row using the diffusion coefficients of the faces
+ *
+ * The west face of a cell is the east face of its left neighbour and the
+ * north face the south face of the row above, which wrap around at the
+ * edges: the faces there are closed unless the domain is periodic. The
+ * interior columns have no branches and are vectorized.
+ *
+ * @param[in]  i       Row index
+ * @param      a_out   Output row of A
+ * @param      b_out   Output row of B
+ * @param[in]  a_prev  Original row i-1 of A
+ * @param[in]  a_cur   Original row i of A
+ * @param[in]  a_next  Original row i+1 of A
+ * @param[in]  b_prev  Original row i-1 of B
+ * @param[in]  b_cur   Original row i of B
+ * @param[in]  b_next  Original row i+1 of B
+ * @param[in]  ncols   Number of columns
+ * @param[in]  kp      Kinetic parameters
+ *
+ * @tparam     T         Floating point type
+ * @tparam     Kinetics  Kinetic system
+ */
+template<typename T, class Kinetics>
+void TwoDimRD::fused_row_faces(unsigned int i, T* a_out, T* b_out,
+                               const T* a_prev, const T* a_cur, const T* a_next,
+                               const T* b_prev, const T* b_cur, const T* b_next,
+                               unsigned int ncols, const KineticParameters<T>& kp) const {
+    const std::array<MatrixXX<T>, 4>& f = this->get_faces<T>();
+    const unsigned int iprev = (i + this->height - 1) % this->height;
+    const T* ea = f[0].row(i).data();
+    const T* sa = f[1].row(i).data();
+    const T* na = f[1].row(iprev).data();
+    const T* eb = f[2].row(i).data();
+    const T* sb = f[3].row(i).data();
+    const T* nb = f[3].row(iprev).data();
+    const T dt = (T)this->dt;
+
+    const auto update_cell = [&](unsigned int j, unsigned int jw, unsigned int je) {
+        const T la = ea[j] * (a_cur[je] - a_cur[j]) + ea[jw] * (a_cur[jw] - a_cur[j]) +
+                     sa[j] * (a_next[j] - a_cur[j]) + na[j] * (a_prev[j] - a_cur[j]);
+        const T lb = eb[j] * (b_cur[je] - b_cur[j]) + eb[jw] * (b_cur[jw] - b_cur[j]) +
+                     sb[j] * (b_next[j] - b_cur[j]) + nb[j] * (b_prev[j] - b_cur[j]);
+
+        T ra = 0;
+        T rb = 0;
+        Kinetics::reaction(a_cur[j], b_cur[j], kp, &ra, &rb);
+
+        a_out[j] = a_cur[j] + (la + ra) * dt;
+        b_out[j] = b_cur[j] + (lb + rb) * dt;
+    };
+
+    #pragma omp simd
+    for(unsigned int j=1; j<ncols-1; j++) {
+        update_cell(j, j-1, j+1);
+    }
+    update_cell(0, ncols-1, 1);
+    update_cell(ncols-1, ncols-2, 0);
+
+    // the walls have closed faces, but would still react
+    if(this->mask) {
+        for(unsigned int j=0; j<ncols; j++) {
             if(this->matmask(i,j) == 1) {
-                this->a(i,j) = 0.0;
-                this->b(i,j) = 0.0;
+                a_out[j] = 0;
+                b_out[j] = 0;
             }
         }
     }
 }
 
+/**
+ * @brief      Update the fluid cells of a single row using the fluid index
+ *
+ * Only the fluid cells are visited and their boundary codes determine
+ * which neighbours contribute, such that walls are never read and the
+ * loop has no branches. Wall cells of the output row are left untouched.
+ *
+ * @param[in]  i       Row index
+ * @param      a_out   Output row of A
+ * @param      b_out   Output row of B
+ * @param[in]  a_prev  Original row i-1 of A
+ * @param[in]  a_cur   Original row i of A
+ * @param[in]  a_next  Original row i+1 of A
+ * @param[in]  b_prev  Original row i-1 of B
+ * @param[in]  b_cur   Original row i of B
+ * @param[in]  b_next  Original row i+1 of B
+ * @param[in]  ncols   Number of columns
+ * @param[in]  kp      Kinetic parameters
+ *
+ * @tparam     T         Floating point type
+ * @tparam     Kinetics  Kinetic system
+ */
+template<typename T, class Kinetics>
+void TwoDimRD::fused_row_mask(unsigned int i, T* a_out, T* b_out,
+                              const T* a_prev, const T* a_cur, const T* a_next,
+                              const T* b_prev, const T* b_cur, const T* b_next,
+                              unsigned int /* ncols */, const KineticParameters<T>& kp) const {
+    const T idx2 = (T)(1.0 / (this->dx * this->dx));
+    const T Da = (T)this->Da;
+    const T Db = (T)this->Db;
+    const T dt = (T)this->dt;
+
+    const uint32_t* cells = this->fluid_index.data() + this->fluid_row_start[i];
+    const int ncells = this->fluid_row_start[i+1] - this->fluid_row_start[i];
+
+    #pragma omp simd
+    for(int k=0; k<ncells; k++) {
+        const uint32_t cell = cells[k];
+        const unsigned int j = cell >> FLUID_CODE_BITS;
+
+        // closed neighbours point to the cell itself and therefore do not contribute
+        const unsigned int jw = j - ((cell & FLUID_OPEN_WEST) ? 1 : 0);
+        const unsigned int je = j + ((cell & FLUID_OPEN_EAST) ? 1 : 0);
+        const T* ap = (cell & FLUID_OPEN_PREV) ? a_prev : a_cur;
+        const T* an = (cell & FLUID_OPEN_NEXT) ? a_next : a_cur;
+        const T* bp = (cell & FLUID_OPEN_PREV) ? b_prev : b_cur;
+        const T* bn = (cell & FLUID_OPEN_NEXT) ? b_next : b_cur;
+
+        const T a = a_cur[j];
+        const T b = b_cur[j];
+        const T lap_a = (ap[j] + an[j] + a_cur[jw] + a_cur[je] - (T)4.0 * a) * idx2;
+        const T lap_b = (bp[j] + bn[j] + b_cur[jw] + b_cur[je] - (T)4.0 * b) * idx2;
+
+        T ra = 0;
+        T rb = 0;
+        Kinetics::reaction(a, b, kp, &ra, &rb);
+
+        a_out[j] = a + (lap_a * Da + ra) * dt;
+        b_out[j] = b + (lap_b * Db + rb) * dt;
+    }
+}
+
 /**
  * @brief      Special instructions for cuda variant
  */
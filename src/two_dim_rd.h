@@ -21,16 +21,102 @@
 
 #pragma once
 
+#include <array>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <string>
+#include <thread>
 #include <vector>
+#include <chrono>
+#include <cstdint>
 
 #include "matrices.h"
 #include "reaction_system.h"
 #include "reaction_gray_scott.h"
+#include "kinetics.h"
+#include "stencil_kernels.h"
+#include "spectral.h"
+#include "runge_kutta.h"
+#include "adi.h"
+#include "multigrid.h"
+#include "super_time_stepping.h"
+#include "adaptive_mesh.h"
 #include "rd2d_cuda.h"
 
+/**
+ * @brief      Deviation of the single-precision state from the double-precision state
+ */
+struct PrecisionDeviation {
+    double max_abs;     //!< maximum absolute deviation over A and B
+    double rel_l2;      //!< L2 norm of the deviation relative to the L2 norm of the double-precision state
+};
+
+/**
+ * @brief      Rate of change of the concentrations over a frame
+ */
+struct UpdateNorm {
+    double max_abs;     //!< maximum absolute rate of change over A and B
+    double rms;         //!< root mean square of the rate of change over A and B
+};
+
+/**
+ * @brief      Fields of a simulation that stay fixed during a run
+ *
+ * The checkpoints of a run share a single copy of these fields, which is
+ * written to a file next to the checkpoint only when that file holds other
+ * fields.
+ */
+struct CheckpointFields {
+    MatrixXXi mask;             //!< mask; empty when there is none
+    MatrixXXd Da_field;         //!< per-cell diffusion coefficient of A; empty when uniform
+    MatrixXXd Db_field;         //!< per-cell diffusion coefficient of B; empty when uniform
+    uint64_t checksum = 0;      //!< checksum of the fields; ties the file of the fields to the checkpoint
+
+    /**
+     * @brief      Whether there are any fields to store
+     *
+     * @return     Whether the mask or a diffusivity field is set
+     */
+    inline bool empty() const {
+        return this->mask.size() == 0 && this->Da_field.size() == 0 && this->Db_field.size() == 0;
+    }
+};
+
+/**
+ * @brief      State of a simulation as stored in a checkpoint
+ *
+ * The checkpoint holds the physical problem and its state at the last
+ * frame. The integrator and the other numerical settings are chosen again
+ * upon a resume; the state that the adaptive integrators carry from frame
+ * to frame is only restored when a matching integrator is chosen.
+ */
+struct Checkpoint {
+    unsigned int width;         //!< width of the system
+    unsigned int height;        //!< height of the system
+    unsigned int steps;         //!< total number of frames of the run
+    unsigned int tsteps;        //!< number of time steps per frame
+    unsigned int frame;         //!< number of frames integrated
+    double Da;                  //!< diffusion coefficient of A
+    double Db;                  //!< diffusion coefficient of B
+    double dx;                  //!< size of the space interval
+    double dt;                  //!< size of the time interval
+    double t;                   //!< time at the last frame
+    KINETICS reacttype;         //!< kinetic system
+    std::string params;         //!< parameter string of the kinetic system
+    bool pbc;                   //!< whether to employ periodic boundary conditions
+    std::shared_ptr<const CheckpointFields> fields; //!< mask and diffusivity fields, shared by the checkpoints of a run
+    std::string random_state;   //!< seed and stream of the random number generator of the initial conditions
+    MatrixXXd a;                //!< concentration of A at the last frame
+    MatrixXXd b;                //!< concentration of B at the last frame
+    double anisotropy;          //!< ratio of the diffusion coefficients along x and along y
+    unsigned int steady_count;  //!< number of consecutive frames below the steady-state tolerance
+    double rk_step;             //!< time step proposed by the adaptive Runge-Kutta integrator; zero when not used
+    unsigned int amr_block_size;    //!< block size of the adaptive mesh; zero when not used
+    uint64_t amr_step;              //!< number of time steps taken on the adaptive mesh
+    std::vector<char> amr_layout;   //!< whether each block of the adaptive mesh is refined
+};
+
 class TwoDimRD {
 private:
     double Da;              //!< Diffusion coefficient of compound A
@@ -45,8 +131,18 @@ private:
 
     MatrixXXd a;            //!< matrix to hold concentration of A
     MatrixXXd b;            //!< matrix to hold concentration of B
-    MatrixXXd delta_a;      //!< matrix to store temporary A increment
-    MatrixXXd delta_b;      //!< matrix to store temporary B increment
+    MatrixXXd linebuf;      //!< per-thread Laplacian rows for the fused update
+
+    MatrixXXf af;           //!< single-precision concentration of A
+    MatrixXXf bf;           //!< single-precision concentration of B
+    MatrixXXf linebuf_f;    //!< per-thread Laplacian rows for the single-precision update
+
+    MatrixXXd a_next;                   //!< second generation of A receiving the result of a time step
+    MatrixXXd b_next;                   //!< second generation of B receiving the result of a time step
+    MatrixXXf af_next;                  //!< second generation of single-precision A
+    MatrixXXf bf_next;                  //!< second generation of single-precision B
+    std::vector<MatrixXXd> tilebuf;     //!< per-thread ring buffers for temporal blocking
+    std::vector<MatrixXXf> tilebuf_f;   //!< per-thread single-precision ring buffers for temporal blocking
 
     std::vector<MatrixXXd> ta;  //!< matrix to hold temporal data
     std::vector<MatrixXXd> tb;  //!< matrix to hold temporal data
@@ -55,14 +151,86 @@ private:
 
     std::unique_ptr<ReactionSystem> reaction_system;    //!< Pointer to reaction system
     std::unique_ptr<RD2D_CUDA> cuda_integrator;         //!< Pointer to reaction system
+    std::unique_ptr<SpectralIntegrator> spectral_integrator;    //!< Pointer to spectral integrator
+    std::unique_ptr<RungeKuttaIntegrator> rk_integrator;        //!< Pointer to adaptive Runge-Kutta integrator
+    std::unique_ptr<AdiIntegrator> adi_integrator;              //!< Pointer to alternating-direction implicit integrator
+    std::unique_ptr<MultigridIntegrator> mg_integrator;         //!< Pointer to multigrid implicit integrator
+    std::unique_ptr<SuperTimeStepping> sts_integrator;          //!< Pointer to super-time-stepping integrator
+    std::unique_ptr<AdaptiveMesh> amr_integrator;               //!< Pointer to adaptive mesh integrator
 
     bool pbc = true;    //!< Whether to employ periodic boundary conditions
     bool mask = false;  //!< Whether to employ a diffusivity mask (internal no-flux walls)
+    STENCIL laplacian_stencil = STENCIL::FIVE_POINT;    //!< finite-difference stencil of the Laplacian
 
     MatrixXXi matmask;          //!< Matrix to store the mask
 
+    MatrixXXd Da_field;         //!< per-cell diffusion coefficient of A; empty when uniform
+    MatrixXXd Db_field;         //!< per-cell diffusion coefficient of B; empty when uniform
+    double anisotropy = 1.0;    //!< ratio of the diffusion coefficients along x and along y
+    std::array<MatrixXXd, 4> faces;     //!< diffusion coefficient over dx^2 of the east and south face of every cell, for A and B
+    std::array<MatrixXXf, 4> faces_f;   //!< single-precision diffusion coefficients of the faces
+
+    std::vector<uint32_t> fluid_index;          //!< column shifted by FLUID_CODE_BITS and boundary code of every fluid cell, per row
+    std::vector<unsigned int> fluid_row_start;  //!< offset of every row in the fluid index, followed by the total number of fluid cells
+
+    static constexpr uint32_t FLUID_OPEN_PREV = 1 << 0;    //!< the cell in the row above is fluid
+    static constexpr uint32_t FLUID_OPEN_NEXT = 1 << 1;    //!< the cell in the row below is fluid
+    static constexpr uint32_t FLUID_OPEN_WEST = 1 << 2;    //!< the cell in the column to the left is fluid
+    static constexpr uint32_t FLUID_OPEN_EAST = 1 << 3;    //!< the cell in the column to the right is fluid
+    static constexpr unsigned int FLUID_CODE_BITS = 4;      //!< number of bits of the boundary code
+
     unsigned int ncores;
     bool do_cuda = false;
+    THREAD_PINNING pinning = THREAD_PINNING::NONE;  //!< how to pin the OpenMP threads to logical CPUs
+
+    TIME_INTEGRATOR integrator = TIME_INTEGRATOR::EULER;    //!< time integrator of the CPU integration
+    double atol = 1e-6;                         //!< absolute tolerance of the adaptive integrators
+    double rtol = 1e-4;                         //!< relative tolerance of the adaptive integrators
+    std::vector<StepStatistics> step_statistics;    //!< per-frame statistics of the adaptive time steps
+    PRECISION precision = PRECISION::DOUBLE;    //!< floating point precision of the CPU integration
+    bool validate_precision = false;            //!< whether to integrate a double-precision reference alongside
+    std::vector<PrecisionDeviation> deviations; //!< per-frame deviation from the double-precision reference
+
+    double steady_tolerance = 0.0;              //!< rate of change below which the state is steady; zero disables the detection
+    unsigned int steady_frames = 5;             //!< number of consecutive frames below the tolerance that make a steady state
+    unsigned int steady_count = 0;              //!< number of consecutive frames below the tolerance so far
+    std::vector<UpdateNorm> update_norms;       //!< per-frame rate of change; empty unless the detection is enabled
+
+    std::string parameters;                     //!< parameter string as passed to set_parameters()
+    std::string checkpoint_filename;            //!< file the checkpoints are written to
+    unsigned int checkpoint_interval = 0;       //!< number of frames between two checkpoints; zero disables them
+    unsigned int checkpoint_frame = 0;          //!< frame of the last checkpoint
+    unsigned int frame_offset = 0;              //!< number of frames integrated before the resume
+    std::unique_ptr<Checkpoint> resume_state;   //!< checkpoint to restore upon initialization
+    std::thread checkpoint_writer;              //!< writes the last checkpoint while the integration continues
+    std::string checkpoint_error;               //!< last failure to write a checkpoint; empty when all have been written
+    std::shared_ptr<const CheckpointFields> checkpoint_fields;  //!< fixed fields of the checkpoints; built upon the first checkpoint
+
+    static constexpr uint32_t CHECKPOINT_MAGIC = 0x4b43464c;           //!< "LFCK" at the start of every checkpoint
+    static constexpr uint32_t CHECKPOINT_FIELDS_MAGIC = 0x4643464c;    //!< "LFCF" at the start of every file of checkpoint fields
+    static constexpr uint32_t CHECKPOINT_VERSION = 3;                  //!< version of the checkpoint layout
+
+    bool temporal_blocking = false;             //!< whether to advance the grid through several time steps per sweep
+    unsigned int block_depth = 8;               //!< number of time steps per temporal block
+    size_t tile_bytes = 1 << 20;                //!< cache budget for the ring buffers of a single thread
+    bool measure_blocking = false;              //!< whether to time temporal blocking upon initialization and keep the faster path
+    double blocking_speedup = 0.0;              //!< measured speedup of temporal blocking over the plain path; zero when not measured
+
+    bool adaptive_mesh = false;                 //!< whether to integrate on a block-structured adaptive mesh
+    unsigned int amr_block_size = 0;            //!< number of cells along a block of the adaptive mesh; zero to choose it from the grid
+    double amr_threshold = 0.05;                //!< difference between neighbouring coarse cells above which a block is refined
+    unsigned int amr_interval = 50;             //!< number of time steps between two regrids
+
+    void (TwoDimRD::*step_function)(unsigned int) = nullptr;      //!< time step specialized for the kinetic system
+    void (TwoDimRD::*step_function_f)(unsigned int) = nullptr;    //!< single-precision time step specialized for the kinetic system
+    void (TwoDimRD::*block_function)(unsigned int) = nullptr;      //!< temporal block specialized for the kinetic system
+    void (TwoDimRD::*block_function_f)(unsigned int) = nullptr;    //!< single-precision temporal block specialized for the kinetic system
+    void (TwoDimRD::*reaction_function)(const double*, const double*, double*, double*) const = nullptr;   //!< reaction terms specialized for the kinetic system
+    void (TwoDimRD::*rate_function)(const MatrixXXd&, const MatrixXXd&, MatrixXXd&, MatrixXXd&) const = nullptr;  //!< time derivatives specialized for the kinetic system
+    void (TwoDimRD::*row_function)(double*, double*, const double*, const double*,
+                                   const double*, const double*, unsigned int,
+                                   const KineticParameters<double>&) const = nullptr;  //!< row update from the Laplacians specialized for the kinetic system
+    const StencilKernels* stencil;                  //!< stencil kernels for the instruction set of this CPU
 
 public:
     /**
@@ -84,10 +252,89 @@ public:
     /**
      * @brief      Sets the reaction.
      *
+     * Also selects the time step that is specialized for the kinetic system
+     *
      * @param      _reaction_system  The reaction system
      */
     void set_reaction(ReactionSystem* _reaction_system);
 
+    /**
+     * @brief      Destroys the object.
+     *
+     * Waits for a checkpoint that is still being written.
+     */
+    ~TwoDimRD();
+
+    /**
+     * @brief      Create a system from a checkpoint
+     *
+     * The dimensions, diffusion coefficients, time step, kinetic system and
+     * its parameters, boundary conditions and mask are taken from the
+     * checkpoint. The number of frames is the number of frames that remain.
+     * The numerical settings can be changed before calling resume(), which
+     * restores the concentrations, the time and the state of the random
+     * number generators.
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     The system
+     */
+    static std::unique_ptr<TwoDimRD> from_checkpoint(const std::string& filename);
+
+    /**
+     * @brief      Initialize a system created by from_checkpoint() from its checkpoint
+     *
+     * This takes the place of set_parameters().
+     */
+    void resume();
+
+    /**
+     * @brief      Set the periodic checkpoints
+     *
+     * Every interval frames, the last frame is copied and written to the
+     * file by a background thread while the integration continues. The
+     * file is written under a temporary name and renamed when complete,
+     * such that an interrupted write never replaces a checkpoint. When a
+     * previous checkpoint is still being written, the integration waits
+     * for it. Upon clean(), the last frame is written as well, such that a
+     * cancelled run can be resumed from where it stopped.
+     *
+     * @param[in]  filename   The filename
+     * @param[in]  _interval  Number of frames between two checkpoints; zero disables them
+     */
+    inline void set_checkpoint(const std::string& filename, unsigned int _interval) {
+        this->checkpoint_filename = filename;
+        this->checkpoint_interval = _interval;
+    }
+
+    /**
+     * @brief      Write a checkpoint of the last frame
+     *
+     * @param[in]  filename  The filename
+     */
+    void write_checkpoint(const std::string& filename);
+
+    /**
+     * @brief      Get the last failure to write a checkpoint
+     *
+     * The checkpoints are written in the background, so the failures are
+     * collected rather than thrown. Only valid after clean().
+     *
+     * @return     The error message; empty when every checkpoint has been written
+     */
+    inline const std::string& get_checkpoint_error() const {
+        return this->checkpoint_error;
+    }
+
+    /**
+     * @brief      Get the number of frames integrated before the resume
+     *
+     * @return     The number of frames; zero unless resumed from a checkpoint
+     */
+    inline unsigned int get_frame_offset() const {
+        return this->frame_offset;
+    }
+
     /**
      * @brief      Set whether to do time-integration using CUDA
      *
@@ -97,6 +344,224 @@ public:
         this->do_cuda = _do_cuda;
     }
 
+    /**
+     * @brief      Set the time integrator of the CPU integration
+     *
+     * Besides explicit Euler, exponential time differencing schemes are
+     * available that integrate the diffusion exactly in the spectral domain
+     * and allow for much larger time steps. These always run in double
+     * precision, without temporal blocking, and do not support a mask.
+     *
+     * The adaptive integrators are embedded Runge-Kutta pairs that adjust
+     * the time step to the tolerances, starting from dt. Frames are still
+     * written every tsteps * dt.
+     *
+     * The ADI integrator treats diffusion implicitly along alternating
+     * directions and the reactions explicitly, such that dt is only limited
+     * by the kinetics. It supports a mask.
+     *
+     * The multigrid integrators take backward Euler or Crank-Nicolson
+     * diffusion steps, solved by geometric multigrid, with explicit
+     * reactions. They follow the walls of a mask exactly and are meant for
+     * large time steps in mazes.
+     *
+     * RKL2 super-time-stepping takes explicit steps beyond the stability
+     * limit of explicit Euler by using as many stages as the diffusion
+     * spectrum requires. It supports a mask.
+     *
+     * Heun and classical RK4 take fixed steps of size dt and reach a given
+     * accuracy with far fewer steps than explicit Euler on oscillatory
+     * kinetics. They support a mask.
+     *
+     * @param[in]  _integrator  The time integrator
+     */
+    inline void set_integrator(TIME_INTEGRATOR _integrator) {
+        this->integrator = _integrator;
+    }
+
+    /**
+     * @brief      Set the tolerances of the adaptive integrators
+     *
+     * @param[in]  _atol  absolute tolerance
+     * @param[in]  _rtol  relative tolerance
+     */
+    inline void set_tolerances(double _atol, double _rtol) {
+        this->atol = _atol;
+        this->rtol = _rtol;
+    }
+
+    /**
+     * @brief      Get the per-frame statistics of the adaptive time steps
+     *
+     * @return     The statistics; empty unless an adaptive integrator is used
+     */
+    inline const auto& get_step_statistics() const {
+        return this->step_statistics;
+    }
+
+    /**
+     * @brief      Get the number of stages per super-time-step
+     *
+     * @return     The number of stages; zero unless RKL2 is used
+     */
+    inline unsigned int get_sts_stages() const {
+        return this->sts_integrator ? this->sts_integrator->get_stages() : 0;
+    }
+
+    /**
+     * @brief      Get the speedup of super-time-stepping over explicit Euler at its stability limit
+     *
+     * @return     The speedup; zero unless RKL2 is used
+     */
+    inline double get_sts_speedup() const {
+        return this->sts_integrator ? this->sts_integrator->get_speedup() : 0.0;
+    }
+
+    /**
+     * @brief      Set the floating point precision of the CPU integration
+     *
+     * @param[in]  _precision  The precision
+     */
+    inline void set_precision(PRECISION _precision) {
+        this->precision = _precision;
+    }
+
+    /**
+     * @brief      Set whether to validate a single-precision run
+     *
+     * A double-precision integration is performed alongside the
+     * single-precision one, starting from the same initial state, and
+     * their deviation is stored for every frame.
+     *
+     * @param[in]  _validate  Whether to validate
+     */
+    inline void set_validate_precision(bool _validate) {
+        this->validate_precision = _validate;
+    }
+
+    /**
+     * @brief      Get the per-frame deviation from the double-precision reference
+     *
+     * @return     The deviations; empty unless the single-precision run is validated
+     */
+    inline const auto& get_precision_deviations() const {
+        return this->deviations;
+    }
+
+    /**
+     * @brief      Set the detection of a steady state
+     *
+     * After every frame, the rate of change is estimated from the
+     * difference with the previous frame, which costs a single pass over
+     * the grid per frame. The state is steady once the maximum absolute
+     * rate of change over A and B stays below the tolerance for the given
+     * number of consecutive frames, upon which the callers of update()
+     * stop integrating.
+     *
+     * @param[in]  _tolerance  Rate of change below which the state is steady; zero disables the detection
+     * @param[in]  _frames     Number of consecutive frames below the tolerance
+     */
+    inline void set_steady_state(double _tolerance, unsigned int _frames = 5) {
+        this->steady_tolerance = _tolerance;
+        this->steady_frames = std::max(_frames, 1u);
+    }
+
+    /**
+     * @brief      Whether a steady state has been reached
+     *
+     * @return     True if the rate of change stayed below the tolerance for enough frames
+     */
+    inline bool is_steady() const {
+        return this->steady_tolerance > 0.0 && this->steady_count >= this->steady_frames;
+    }
+
+    /**
+     * @brief      Get the per-frame rate of change
+     *
+     * @return     The rates of change; empty unless the steady state is detected
+     */
+    inline const auto& get_update_norms() const {
+        return this->update_norms;
+    }
+
+    /**
+     * @brief      Set whether to use temporal blocking on the CPU
+     *
+     * The grid is advanced through several time steps in a single sweep,
+     * which pays off when the grid does not fit in the cache. The depth is
+     * reduced when the rows it needs to keep do not fit in the cache budget.
+     *
+     * @param[in]  _temporal_blocking  Whether to use temporal blocking
+     * @param[in]  _block_depth        Number of time steps per block
+     * @param[in]  _tile_bytes         Cache budget per thread
+     */
+    inline void set_temporal_blocking(bool _temporal_blocking, unsigned int _block_depth = 8, size_t _tile_bytes = 1 << 20) {
+        this->temporal_blocking = _temporal_blocking;
+        this->block_depth = std::max(_block_depth, 1u);
+        this->tile_bytes = _tile_bytes;
+    }
+
+    /**
+     * @brief      Set whether to time temporal blocking against the plain path
+     *
+     * Upon initialization of a new run, 2 x block depth time steps are
+     * integrated with and without temporal blocking from the initial state,
+     * after which the faster path is kept. The timing is only meaningful
+     * when no other runs compete for the cores. A resumed run keeps the
+     * choice of set_temporal_blocking().
+     *
+     * @param[in]  _measure  Whether to time both paths
+     */
+    inline void set_blocking_measurement(bool _measure) {
+        this->measure_blocking = _measure;
+    }
+
+    /**
+     * @brief      Get the speedup of temporal blocking over the plain path
+     *
+     * This is measured on the initial state upon initialization, see
+     * set_blocking_measurement().
+     *
+     * @return     The speedup; zero when it has not been measured
+     */
+    inline double get_blocking_speedup() const {
+        return this->blocking_speedup;
+    }
+
+    /**
+     * @brief      Set whether to integrate on a block-structured adaptive mesh
+     *
+     * The domain is divided in blocks that are either integrated on the
+     * uniform grid or on cells of twice its size, depending on how steep
+     * the pattern is inside them, see AdaptiveMesh. Patterns that occupy a
+     * small part of the domain are integrated at a fraction of the cost.
+     * The frames are resampled to the uniform grid. The adaptive mesh
+     * requires explicit Euler in double precision on the CPU with the
+     * five-point stencil, without a mask or varying diffusion. The time
+     * step is limited by the refined cells, as on the uniform grid.
+     *
+     * @param[in]  _adaptive_mesh  Whether to use the adaptive mesh
+     * @param[in]  _block_size     Number of cells along a block; zero for the largest suitable one up to 32
+     * @param[in]  _threshold      Difference between neighbouring coarse cells above which a block is refined
+     * @param[in]  _interval       Number of time steps between two regrids
+     */
+    inline void set_adaptive_mesh(bool _adaptive_mesh, unsigned int _block_size = 0,
+                                  double _threshold = 0.05, unsigned int _interval = 50) {
+        this->adaptive_mesh = _adaptive_mesh;
+        this->amr_block_size = _block_size;
+        this->amr_threshold = _threshold;
+        this->amr_interval = _interval;
+    }
+
+    /**
+     * @brief      Get the number of cells of the adaptive mesh relative to the uniform grid
+     *
+     * @return     The fraction of cells; one unless the adaptive mesh is used
+     */
+    inline double get_adaptive_cell_fraction() const {
+        return this->amr_integrator ? this->amr_integrator->get_cell_fraction() : 1.0;
+    }
+
     /**
      * @brief      Set whether system has periodic boundary conditions
      *
@@ -106,6 +571,38 @@ public:
         this->pbc = _pbc;
     }
 
+    /**
+     * @brief      Set the finite-difference stencil of the Laplacian
+     *
+     * The nine-point stencil has an isotropic leading error, which removes
+     * the grid-aligned artefacts of the five-point stencil. The fourth-order
+     * stencil reaches the same accuracy on a much coarser grid for smooth
+     * patterns. Both boundary conditions are supported; the zero-flux edges
+     * mirror the cells next to the edge.
+     *
+     * The stability limit of explicit Euler scales with the inverse of the
+     * spectral radius, see get_stencil_spectral_radius(): it is 1.5 times
+     * larger for the nine-point and 0.75 times as large for the fourth-order
+     * stencil. The higher-order stencils are available for explicit Euler,
+     * the Runge-Kutta, RKL2 and spectral integrators on the CPU, but not in
+     * combination with a mask or with spatially varying or anisotropic
+     * diffusion. The fourth-order stencil does not use temporal blocking.
+     *
+     * @param[in]  _stencil  The stencil
+     */
+    inline void set_stencil(STENCIL _stencil) {
+        this->laplacian_stencil = _stencil;
+    }
+
+    /**
+     * @brief      Get the instruction set used by the CPU stencil kernels
+     *
+     * @return     The SIMD level
+     */
+    inline SIMD_LEVEL get_simd_level() const {
+        return this->stencil->level;
+    }
+
     /**
      * @brief      Perform time integration
      */
@@ -126,12 +623,13 @@ public:
     /**
      * @brief      Sets the parameters.
      *
+     * Besides the kinetic parameters, the string may select a fixed-step
+     * scheme by its order: scheme=1 (explicit Euler), scheme=2 (Heun) or
+     * scheme=4 (classical RK4). This overrides the time integrator.
+     *
      * @param[in]  params  The parameters
      */
-    inline void set_parameters(const std::string& params) {
-        this->reaction_system->set_parameters(params);
-        this->init();
-    }
+    void set_parameters(const std::string& params);
 
     inline size_t get_num_img() const {
         return this->ta.size();
@@ -171,14 +669,52 @@ public:
         this->ncores = _ncores;
     }
 
+    /**
+     * @brief      Set how the OpenMP threads are pinned to logical CPUs
+     *
+     * The threads are pinned at the start of every frame, such that each
+     * thread keeps working on the same band of rows on the same CPU. The
+     * state is first touched by the same pinned threads, such that on NUMA
+     * machines the pages of every band reside on the node that works on it.
+     *
+     * @param[in]  _pinning  The pinning policy
+     */
+    inline void set_thread_pinning(THREAD_PINNING _pinning) {
+        this->pinning = _pinning;
+    }
+
     /**
      * @brief      Set the diffusivity mask
      *
+     * Also builds the index of the fluid cells that is used by the CPU
+     * integration.
+     *
      * @param[in]  _mask  The mask
      */
-    inline void set_mask(const MatrixXXi& _mask) {
-        this->matmask = _mask;
-        this->mask = true;
+    void set_mask(const MatrixXXi& _mask);
+
+    /**
+     * @brief      Set spatially varying diffusion coefficients
+     *
+     * The flux over the face between two cells is governed by the average
+     * of the diffusion coefficients of both cells, which conserves mass.
+     * Only the explicit Euler integration on the CPU supports these.
+     *
+     * @param[in]  _Da_field  Diffusion coefficient of A per cell; empty for the uniform Da
+     * @param[in]  _Db_field  Diffusion coefficient of B per cell; empty for the uniform Db
+     */
+    void set_diffusivity_fields(const MatrixXXd& _Da_field, const MatrixXXd& _Db_field);
+
+    /**
+     * @brief      Set anisotropic diffusion
+     *
+     * The diffusion coefficients apply along x; along y they are divided by
+     * the ratio. Only the explicit Euler integration on the CPU supports this.
+     *
+     * @param[in]  _anisotropy  Ratio of the diffusion coefficients along x and along y
+     */
+    inline void set_anisotropy(double _anisotropy) {
+        this->anisotropy = _anisotropy;
     }
 
     /**
@@ -192,6 +728,8 @@ public:
 
     /**
      * @brief      Clean-up any variables that need to be explicitly removed from memory
+     *
+     * When checkpoints are enabled, the last frame is written as well.
      */
     void clean();
 
@@ -202,86 +740,392 @@ private:
     void init();
 
     /**
-     * @brief      Calculate Laplacian using central finite difference with periodic boundary conditions
+     * @brief      Allocate the buffers for temporal blocking
+     */
+    void init_temporal_blocking();
+
+    /**
+     * @brief      Time temporal blocking against the plain path and keep the faster one
+     */
+    void measure_temporal_blocking();
+
+    /**
+     * @brief      Calculate the Laplacian of a row using the selected stencil
      *
-     * @param      delta_c  Concentration update matrix
-     * @param      c        Current concentration matrix
+     * @param[in]  c     Concentration matrix
+     * @param[in]  i     Row index
+     * @param      lap   Output row of the Laplacian
+     * @param[in]  wrap  Whether the boundaries are periodic
      *
-     * Note that this overwrites the current delta matrices!
+     * @tparam     T     Floating point type
      */
-    void laplacian_2d_pbc(MatrixXXd& delta_c, const MatrixXXd& c);
+    template<typename T>
+    void laplacian_row(const MatrixXX<T>& c, int i, T* lap, bool wrap) const;
 
     /**
-     * @brief      Calculate Laplacian using central finite difference with zero-flux boundaries
+     * @brief      Set the concentrations in the masked cells to zero
+     */
+    void apply_mask();
+
+    /**
+     * @brief      Build the index of the fluid cells from the mask
+     */
+    void build_fluid_index();
+
+    /*
+     * FUSED FUNCTIONS
+     */
+
+    /**
+     * @brief      Advance the state by a number of time steps in a single parallel region
      *
-     * @param      delta_c  Concentration update matrix
-     * @param      c        Current concentration matrix
+     * @param[in]  nsteps  Number of time steps
+     * @param[in]  step    Time step specialized for the kinetic system
+     * @param[in]  block   Temporal block specialized for the kinetic system
      *
-     * Note that this overwrites the current delta matrices!
+     * @tparam     T       Floating point type
      */
-    void laplacian_2d_zeroflux(MatrixXXd& delta_c, const MatrixXXd& c);
+    template<typename T>
+    void advance(unsigned int nsteps,
+                 void (TwoDimRD::*step)(unsigned int),
+                 void (TwoDimRD::*block)(unsigned int));
 
     /**
-     * @brief      Calculate Laplacian using central finite difference with zero-flux mask
+     * @brief      Get the number of threads of the parallel region
      *
-     * @param      delta_c  Concentration update matrix
-     * @param      c        Current concentration matrix
+     * Every thread needs to own at least a single row.
      *
-     * Note that this overwrites the current delta matrices!
+     * @return     The number of threads
      */
-    void laplacian_2d_mask(MatrixXXd& delta_c, const MatrixXXd& c);
+    inline unsigned int get_num_threads() const {
+        return std::max(1u, std::min(this->ncores, this->height));
+    }
 
-    /*
-     * CACHE OPTIMIZED FUNCTIONS
+    /**
+     * @brief      Allocate a matrix and zero it from the threads that will work on it
+     *
+     * @param      m     The matrix
+     * @param[in]  rows  Number of rows
+     * @param[in]  cols  Number of columns
+     *
+     * @tparam     T     Floating point type
+     */
+    template<typename T>
+    void first_touch(MatrixXX<T>& m, unsigned int rows, unsigned int cols) const;
+
+    /**
+     * @brief      Perform a single explicit time step in one sweep over the band of the calling thread
+     *
+     * Laplacian, reaction term and Euler update are evaluated per cell. The
+     * state is read from one generation and the new state is written to the
+     * other, such that the rows of the neighbouring bands can be read
+     * directly. Must be called by all threads of the parallel region.
+     *
+     * @param[in]  parity  Which generation holds the current state
+     *
+     * @tparam     T         Floating point type
+     * @tparam     Kinetics  Kinetic system
+     * @tparam     Faces     Whether to use the diffusion coefficients of the faces
      */
+    template<typename T, class Kinetics, bool Faces>
+    void update_fused(unsigned int parity);
 
     /**
-     * @brief      Calculate Laplacian using central finite difference with periodic boundary conditions
+     * @brief      Perform several explicit time steps using temporal blocking
+     *
+     * Every thread sweeps once over its band of rows for all time steps,
+     * keeping the last three rows of every time level in a cache-sized ring
+     * buffer. The band is extended by a halo of nsteps rows that is
+     * recomputed by the neighbouring threads. Must be called by all threads
+     * of the parallel region.
      *
-     * This function attempt to reduce cache misses
+     * @param[in]  nsteps  Number of time steps, at most the block depth
+     *
+     * @tparam     T         Floating point type
+     * @tparam     Kinetics  Kinetic system
+     * @tparam     Faces     Whether to use the diffusion coefficients of the faces
+     */
+    template<typename T, class Kinetics, bool Faces>
+    void update_blocked(unsigned int nsteps);
+
+    /**
+     * @brief      Update a single row according to the boundary conditions
      *
-     * @param      delta_c  Concentration update matrix
-     * @param      c        Current concentration matrix
+     * @param[in]  i       Row index
+     * @param      a_out   Output row of A
+     * @param      b_out   Output row of B
+     * @param[in]  a_prev  Original row i-1 of A
+     * @param[in]  a_cur   Original row i of A
+     * @param[in]  a_next  Original row i+1 of A
+     * @param[in]  b_prev  Original row i-1 of B
+     * @param[in]  b_cur   Original row i of B
+     * @param[in]  b_next  Original row i+1 of B
+     * @param      lap_a   Scratch row for the Laplacian of A
+     * @param      lap_b   Scratch row for the Laplacian of B
+     * @param[in]  ncols   Number of columns
+     * @param[in]  kp      Kinetic parameters
      *
-     * Note that this overwrites the current delta matrices!
+     * @tparam     T         Floating point type
+     * @tparam     Kinetics  Kinetic system
+     * @tparam     Faces     Whether to use the diffusion coefficients of the faces
      */
-    void laplacian_2d_pbc_cached(MatrixXXd& delta_c, const MatrixXXd& c);
+    template<typename T, class Kinetics, bool Faces>
+    void update_row(unsigned int i, T* a_out, T* b_out,
+                    const T* a_prev, const T* a_cur, const T* a_next,
+                    const T* b_prev, const T* b_cur, const T* b_next,
+                    T* lap_a, T* lap_b,
+                    unsigned int ncols, const KineticParameters<T>& kp) const;
 
     /**
-     * @brief      Calculate Laplacian using central finite difference with zero-flux boundaries
+     * @brief      Update a single row from its Laplacians
      *
-     * This function attempt to reduce cache misses
+     * The Laplacians of the row have been evaluated by the stencil kernels,
+     * such that the remaining loop has no branches and is vectorized.
      *
-     * @param      delta_c  Concentration update matrix
-     * @param      c        Current concentration matrix
+     * @param      a_out   Output row of A
+     * @param      b_out   Output row of B
+     * @param[in]  a_cur   Original row of A
+     * @param[in]  b_cur   Original row of B
+     * @param[in]  lap_a   Laplacian of the row of A
+     * @param[in]  lap_b   Laplacian of the row of B
+     * @param[in]  ncols   Number of columns
+     * @param[in]  kp      Kinetic parameters
      *
-     * Note that this overwrites the current delta matrices!
+     * @tparam     T         Floating point type
+     * @tparam     Kinetics  Kinetic system
      */
-    void laplacian_2d_zeroflux_cached(MatrixXXd& delta_c, const MatrixXXd& c);
+    template<typename T, class Kinetics>
+    void fused_row_update(T* a_out, T* b_out,
+                          const T* a_cur, const T* b_cur,
+                          const T* lap_a, const T* lap_b,
+                          unsigned int ncols, const KineticParameters<T>& kp) const;
 
     /**
-     * @brief      Calculate Laplacian using central finite difference with zero-flux mask
+     * @brief      Update the fluid cells of a single row using the fluid index
      *
-     * This function attempt to reduce cache misses
+     * Only the fluid cells are visited and their boundary codes determine
+     * which neighbours contribute, such that walls are never read.
      *
-     * @param      delta_c  Concentration update matrix
-     * @param      c        Current concentration matrix
+     * @param[in]  i       Row index
+     * @param      a_out   Output row of A
+     * @param      b_out   Output row of B
+     * @param[in]  a_prev  Original row i-1 of A
+     * @param[in]  a_cur   Original row i of A
+     * @param[in]  a_next  Original row i+1 of A
+     * @param[in]  b_prev  Original row i-1 of B
+     * @param[in]  b_cur   Original row i of B
+     * @param[in]  b_next  Original row i+1 of B
+     * @param[in]  ncols   Number of columns
+     * @param[in]  kp      Kinetic parameters
      *
-     * Note that this overwrites the current delta matrices!
+     * @tparam     T         Floating point type
+     * @tparam     Kinetics  Kinetic system
      */
-    void laplacian_2d_mask_cached(MatrixXXd& delta_c, const MatrixXXd& c);
+    template<typename T, class Kinetics>
+    void fused_row_mask(unsigned int i, T* a_out, T* b_out,
+                        const T* a_prev, const T* a_cur, const T* a_next,
+                        const T* b_prev, const T* b_cur, const T* b_next,
+                        unsigned int ncols, const KineticParameters<T>& kp) const;
 
     /**
-     * @brief      Calculate reaction term
+     * @brief      Update a single row using the diffusion coefficients of the faces
+     *
+     * The faces at the edges of the domain and those next to the walls of
+     * the mask have a zero coefficient, such that the neighbours across
+     * them do not contribute. Cells inside the walls remain empty.
      *
-     * Add the value to the current delta matrices
+     * @param[in]  i       Row index
+     * @param      a_out   Output row of A
+     * @param      b_out   Output row of B
+     * @param[in]  a_prev  Original row i-1 of A
+     * @param[in]  a_cur   Original row i of A
+     * @param[in]  a_next  Original row i+1 of A
+     * @param[in]  b_prev  Original row i-1 of B
+     * @param[in]  b_cur   Original row i of B
+     * @param[in]  b_next  Original row i+1 of B
+     * @param[in]  ncols   Number of columns
+     * @param[in]  kp      Kinetic parameters
+     *
+     * @tparam     T         Floating point type
+     * @tparam     Kinetics  Kinetic system
      */
-    void add_reaction();
+    template<typename T, class Kinetics>
+    void fused_row_faces(unsigned int i, T* a_out, T* b_out,
+                         const T* a_prev, const T* a_cur, const T* a_next,
+                         const T* b_prev, const T* b_cur, const T* b_next,
+                         unsigned int ncols, const KineticParameters<T>& kp) const;
 
     /**
-     * @brief      Apply mask to concentrations
+     * @brief      Evaluate the reaction terms of all cells
+     *
+     * @param[in]  a     Concentrations of A
+     * @param[in]  b     Concentrations of B
+     * @param      ra    Reaction terms of A
+     * @param      rb    Reaction terms of B
+     *
+     * @tparam     Kinetics  Kinetic system
      */
-    void apply_mask();
+    template<class Kinetics>
+    void evaluate_reaction(const double* a, const double* b, double* ra, double* rb) const;
+
+    /**
+     * @brief      Evaluate the time derivatives of all cells
+     *
+     * Cells inside the walls of the mask have a zero time derivative.
+     *
+     * @param[in]  a     Concentrations of A
+     * @param[in]  b     Concentrations of B
+     * @param      da    Time derivatives of A
+     * @param      db    Time derivatives of B
+     *
+     * @tparam     Kinetics  Kinetic system
+     */
+    template<class Kinetics>
+    void evaluate_rates(const MatrixXXd& a, const MatrixXXd& b, MatrixXXd& da, MatrixXXd& db) const;
+
+    /**
+     * @brief      Select the time steps that are specialized for the kinetic system
+     */
+    void select_step_functions();
+
+    /**
+     * @brief      Select the time steps that are specialized for the kinetic system
+     *
+     * @tparam     Kinetics  Kinetic system
+     */
+    template<class Kinetics>
+    void select_step_functions();
+
+    /**
+     * @brief      Whether the diffusion is anisotropic or varies over the cells
+     *
+     * @return     True if the diffusion coefficients of the faces are used
+     */
+    inline bool has_diffusion_faces() const {
+        return this->Da_field.size() > 0 || this->Db_field.size() > 0 || this->anisotropy != 1.0;
+    }
+
+    /**
+     * @brief      Build the diffusion coefficients of the faces of all cells
+     */
+    void build_diffusion_faces();
+
+    /**
+     * @brief      Get the diffusion coefficients of the faces of the given precision
+     *
+     * @tparam     T      Floating point type
+     *
+     * @return     The east and south faces of A, followed by those of B
+     */
+    template<typename T>
+    const std::array<MatrixXX<T>, 4>& get_faces() const;
+
+    /**
+     * @brief      Get the concentration matrix of the given precision
+     *
+     * @param[in]  first  Whether to return the concentrations of A
+     *
+     * @tparam     T      Floating point type
+     *
+     * @return     The concentration matrix
+     */
+    template<typename T>
+    MatrixXX<T>& get_state(bool first);
+
+    /**
+     * @brief      Get the Laplacian rows of the given precision
+     *
+     * @tparam     T      Floating point type
+     *
+     * @return     The Laplacian rows
+     */
+    template<typename T>
+    MatrixXX<T>& get_linebuf();
+
+    /**
+     * @brief      Get the second generation of the state of the given precision
+     *
+     * @param[in]  first  Whether to return the concentrations of A
+     *
+     * @tparam     T      Floating point type
+     *
+     * @return     The concentration matrix
+     */
+    template<typename T>
+    MatrixXX<T>& get_next_state(bool first);
+
+    /**
+     * @brief      Get the per-thread ring buffers of the given precision
+     *
+     * @tparam     T      Floating point type
+     *
+     * @return     The ring buffers
+     */
+    template<typename T>
+    std::vector<MatrixXX<T>>& get_tilebuf();
+
+    /**
+     * @brief      Store the rate of change over the last frame and update the steady-state count
+     */
+    void store_update_norm();
+
+    /**
+     * @brief      Write a checkpoint in the background when the interval has passed
+     */
+    void store_checkpoint();
+
+    /**
+     * @brief      Copy the state at the last frame into a checkpoint
+     *
+     * @return     The checkpoint
+     */
+    Checkpoint make_checkpoint();
+
+    /**
+     * @brief      Write a checkpoint to a file
+     *
+     * @param[in]  filename  The filename
+     * @param[in]  ckpt      The checkpoint
+     */
+    static void write_checkpoint_file(const std::string& filename, const Checkpoint& ckpt);
+
+    /**
+     * @brief      Read a checkpoint from a file
+     *
+     * @param[in]  filename  The filename
+     *
+     * @return     The checkpoint
+     */
+    static Checkpoint read_checkpoint_file(const std::string& filename);
+
+    /**
+     * @brief      Write the fixed fields of a checkpoint, unless the file already holds them
+     *
+     * @param[in]  filename  The filename
+     * @param[in]  width     The width of the system
+     * @param[in]  height    The height of the system
+     * @param[in]  fields    The fields
+     */
+    static void write_checkpoint_fields(const std::string& filename, unsigned int width,
+                                        unsigned int height, const CheckpointFields& fields);
+
+    /**
+     * @brief      Read the fixed fields of a checkpoint
+     *
+     * @param[in]  filename  The filename
+     * @param[in]  width     The width of the system
+     * @param[in]  height    The height of the system
+     * @param[in]  checksum  The checksum of the fields stored in the checkpoint
+     *
+     * @return     The fields
+     */
+    static std::shared_ptr<const CheckpointFields> read_checkpoint_fields(const std::string& filename, unsigned int width,
+                                                                          unsigned int height, uint64_t checksum);
+
+    /**
+     * @brief      Store the deviation of the single-precision state from the double-precision state
+     */
+    void store_precision_deviation();
 
     /**
      * @brief      Special instructions for cuda variant of time update
@@ -27,6 +27,14 @@ WorkerThread::WorkerThread(TwoDimRD* _reaction_system) {
 }
 
 void WorkerThread::run() {
+    try {
+        this->integrate();
+    } catch(const std::exception& e) {
+        emit simulation_failed(QString::fromStdString(e.what()));
+    }
+}
+
+void WorkerThread::integrate() {
     for(unsigned int i=0; i<this->reaction_system->get_num_steps(); i++) {
 
         if(this->continue_running == false) {
@@ -41,6 +49,13 @@ void WorkerThread::run() {
         std::chrono::duration<double> elapsed_seconds = end-start;
 
         emit step_finished(i, elapsed_seconds.count());
+
+        // the remaining frames are skipped once the pattern no longer changes
+        if(this->reaction_system->is_steady()) {
+            this->reaction_system->clean();
+            emit simulation_converged(i+1);
+            return;
+        }
     }
 
     this->reaction_system->clean();
@@ -34,6 +34,8 @@ private:
     TwoDimRD* reaction_system;
     bool continue_running;
 
+    void integrate();
+
 public:
     WorkerThread(TwoDimRD* _reaction_system);
 
@@ -44,6 +46,10 @@ signals:
 
     void simulation_cancelled();
 
+    void simulation_converged(unsigned int i);
+
+    void simulation_failed(const QString& message);
+
     void step_finished(unsigned int i, double tcalc);
 
 public slots: